@@ -0,0 +1,116 @@
+<?php
+################################################################################
+# Copyright 2013-2015 Aerospike, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+################################################################################
+require_once(realpath(__DIR__ . '/../examples_util.php'));
+
+function parse_args() {
+    $shortopts  = "";
+    $shortopts .= "h::";  /* Optional host */
+    $shortopts .= "p::";  /* Optional port */
+    $shortopts .= "r::";  /* Optionally number of records to aggregate */
+    $shortopts .= "n::";  /* Optionally number of aggregate operations */
+
+    $longopts  = array(
+        "host::",         /* Optional host */
+        "port::",         /* Optional port */
+        "records::",      /* Optionally number of records to aggregate */
+        "num-ops::",      /* Optionally number of aggregate operations */
+        "help",           /* Usage */
+    );
+    $options = getopt($shortopts, $longopts);
+    return $options;
+}
+
+$args = parse_args();
+if (isset($args["help"])) {
+    echo "php aggregate.php [-hHOST] [-pPORT] [-rRECORDS] [-nAGGREGATIONS]\n";
+    echo " or\n";
+    echo "php aggregate.php [--host=HOST] [--port=PORT] [--records=RECORDS] [--num-ops=AGGREGATIONS]\n";
+    exit(1);
+}
+$addr = (isset($args["h"])) ? (string) $args["h"] : ((isset($args["host"])) ? (string) $args["host"] : "localhost");
+$port = (isset($args["p"])) ? (integer) $args["p"] : ((isset($args["port"])) ? (string) $args["port"] : 3000);
+$total_records = (isset($args["r"])) ? (integer) $args["r"] : ((isset($args["records"])) ? (integer) $args["records"] : 10000);
+$total_ops = (isset($args["n"])) ? (integer) $args["n"] : ((isset($args["num-ops"])) ? (integer) $args["num-ops"] : 100);
+
+echo colorize("Connecting to the host ≻", 'black', true);
+$config = array("hosts" => array(array("addr" => $addr, "port" => $port)));
+$db = new Aerospike($config, false);
+if (!$db->isConnected()) {
+    echo fail("Could not connect to host $addr:$port [{$db->errorno()}]: {$db->error()}");
+    exit(1);
+}
+echo success();
+
+echo colorize("Registering the UDF module ≻", 'black', true);
+$module = ini_get('aerospike.udf.lua_user_path').'/example_aggregate_udf.lua';
+if (!copy(__DIR__.'/../query_examples/lua/example_aggregate_udf.lua', $module)) {
+    echo fail("Could not copy the UDF module to ".ini_get('aerospike.udf.lua_user_path'));
+    exit(1);
+}
+if ($db->register($module, "example_aggregate_udf.lua") !== Aerospike::OK) {
+    echo standard_fail($db);
+    exit(1);
+}
+echo success();
+
+echo colorize("Creating a secondary index on the 'age' bin of test.aggregate ≻", 'black', true);
+$status = $db->createIndex("test", "aggregate", "age", Aerospike::INDEX_TYPE_INTEGER, "aggregate_age_index");
+if ($status !== Aerospike::OK && $status !== Aerospike::ERR_INDEX_FOUND) {
+    echo standard_fail($db);
+    exit(1);
+}
+echo success();
+
+echo colorize("Writing $total_records records to test.aggregate ≻", 'black', true);
+$workplaces = array("Planet Express", "HAL Institute", "MomCorp", "DOOP", "Slurm");
+for ($i = 0; $i < $total_records; $i++) {
+    $key = $db->initKey("test", "aggregate", $i);
+    $bins = array("workplace" => $workplaces[$i % count($workplaces)], "age" => $i % 100);
+    if ($db->put($key, $bins) !== Aerospike::OK) {
+        echo standard_fail($db);
+        exit(1);
+    }
+}
+echo success();
+
+$cache = ini_get('aerospike.udf.lua_cache_enabled') ? "enabled" : "disabled";
+echo colorize("Running $total_ops aggregations with the Lua state cache $cache ≻", 'black', true);
+$where = $db->predicateBetween("age", 0, 99);
+$fails = 0;
+$begin = microtime(true);
+for ($num_ops = 0; $num_ops < $total_ops; $num_ops++) {
+    $status = $db->aggregate("test", "aggregate", $where, "example_aggregate_udf",
+        "group_count", array("workplace"), $result);
+    if ($status !== Aerospike::OK) {
+        $fails++;
+    }
+}
+$end = microtime(true);
+if ($fails == 0) {
+    echo success();
+} else {
+    echo standard_fail($db);
+}
+
+$color = ($fails > 0) ? 'red' : 'green';
+echo colorize("Failed aggregations: $fails\n", $color, true);
+$delta = $end - $begin;
+$ms = ($delta * 1000) / max($total_ops, 1);
+echo colorize("Total time: {$delta}s Average: {$ms}ms per aggregation of $total_records records\n", 'purple', true);
+
+$db->close();
+?>
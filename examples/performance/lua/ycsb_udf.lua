@@ -0,0 +1,10 @@
+-- Record UDF used by ycsb.php --update-with=udf.
+-- Sets one bin of the record, creating the record if needed.
+function update(rec, bin_name, value)
+	rec[bin_name] = value
+	if aerospike:exists(rec) then
+		aerospike:update(rec)
+	else
+		aerospike:create(rec)
+	end
+end
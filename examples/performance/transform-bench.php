@@ -0,0 +1,106 @@
+<?php
+################################################################################
+# Copyright 2013-2015 Aerospike, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+################################################################################
+require_once(realpath(__DIR__ . '/../examples_util.php'));
+
+function parse_args() {
+    $shortopts  = "";
+    $shortopts .= "n::";  /* Optionally number of round trips per payload */
+
+    $longopts  = array(
+        "num-ops::",      /* Optionally number of round trips per payload */
+        "payload::",      /* Optionally a single payload to run */
+        "json",           /* Output one JSON document, for tracking over commits */
+        "help",           /* Usage */
+    );
+    $options = getopt($shortopts, $longopts);
+    return $options;
+}
+
+class BenchObject {
+    public $id = 1234;
+    public $name = "bench";
+    public $tags = array("a", "b", "c");
+}
+
+function payloads() {
+    $flat = array();
+    for ($i = 0; $i < 10; $i++) {
+        $flat["bin$i"] = ($i % 2) ? $i * 1000 : "value $i";
+    }
+
+    $nested = array("doc" => array(
+        "user" => array("id" => 42, "name" => "Jane", "emails" => array("a@example.com", "b@example.com")),
+        "history" => array_fill(0, 20, array("ts" => 1420070400, "event" => "login", "ok" => 1)),
+        "settings" => array("lang" => "en", "tz" => "UTC", "flags" => range(0, 15))));
+
+    $wide = array();
+    for ($i = 0; $i < 100; $i++) {
+        $wide["b$i"] = $i;
+    }
+
+    $binary = array("blob" => str_repeat("\x00\x01\x02\xff", 4096));
+
+    $serialized = array("obj" => new BenchObject(), "float" => 3.14159, "flag" => true);
+
+    return array(
+        "flat" => $flat,
+        "nested" => $nested,
+        "wide" => $wide,
+        "binary" => $binary,
+        "serialized" => $serialized);
+}
+
+$args = parse_args();
+if (isset($args["help"])) {
+    echo "php transform-bench.php [-nROUND_TRIPS] [--payload=NAME] [--json]\n";
+    echo " or\n";
+    echo "php transform-bench.php [--num-ops=ROUND_TRIPS] [--payload=NAME] [--json]\n";
+    echo "payloads: ".implode(", ", array_keys(payloads()))."\n";
+    exit(1);
+}
+$total_ops = (isset($args["n"])) ? (integer) $args["n"] : ((isset($args["num-ops"])) ? (integer) $args["num-ops"] : 10000);
+
+if (!method_exists("Aerospike", "benchTransform")) {
+    echo fail("The aerospike extension must be built with --enable-aerospike-bench");
+    exit(1);
+}
+
+$results = array();
+foreach (payloads() as $name => $bins) {
+    if (isset($args["payload"]) && $args["payload"] != $name) {
+        continue;
+    }
+    $result = Aerospike::benchTransform($bins, $total_ops, Aerospike::SERIALIZER_PHP);
+    if (is_null($result)) {
+        echo fail("The $name payload could not be round-tripped");
+        exit(1);
+    }
+    $results[$name] = $result;
+}
+
+if (isset($args["json"])) {
+    echo json_encode($results)."\n";
+    exit(0);
+}
+
+printf("%-12s %6s %10s %10s %10s %12s %14s\n", "payload", "bins", "put ns", "get ns",
+    "ns/op", "wire bytes", "mem bytes/op");
+foreach ($results as $name => $result) {
+    printf("%-12s %6d %10d %10d %10d %12d %14d\n", $name, $result["bins"], $result["put_ns"],
+        $result["get_ns"], $result["ns_per_op"], $result["wire_bytes"], $result["mem_bytes_per_op"]);
+}
+?>
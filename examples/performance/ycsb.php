@@ -0,0 +1,585 @@
+<?php
+################################################################################
+# Copyright 2013-2015 Aerospike, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+################################################################################
+#
+# A YCSB style workload driver. A load phase inserts the records, then a run
+# phase executes one of the core workloads A-F against them, with the
+# latency of every operation recorded into a log-linear histogram (1%
+# precision) per operation type. Concurrency comes from worker processes,
+# whose histograms are merged by the parent.
+#
+#   A  50% read, 50% update                     zipfian
+#   B  95% read,  5% update                     zipfian
+#   C 100% read                                 zipfian
+#   D  95% read,  5% insert                     latest
+#   E  95% scan,  5% insert                     zipfian
+#   F  50% read, 50% read-modify-write          zipfian
+#
+# Aerospike has no ordered short range scan, so the scans of workload E are
+# batch reads (getMany) of up to --scan-length consecutive keys, and the
+# read-modify-write of F is a single operate() reading and writing a bin.
+# Updates go through put(), operate() or apply() of a record UDF, as chosen
+# by --update-with.
+################################################################################
+require_once(realpath(__DIR__ . '/../examples_util.php'));
+
+function parse_args() {
+    $shortopts  = "";
+    $shortopts .= "h::";  /* Optional host */
+    $shortopts .= "p::";  /* Optional port */
+    $shortopts .= "w::";  /* Optionally the workload, a-f */
+    $shortopts .= "c::";  /* Optionally the number of worker processes */
+
+    $longopts  = array(
+        "host::",         /* Optional host */
+        "port::",         /* Optional port */
+        "workload::",     /* Optionally the workload, a-f */
+        "workers::",      /* Optionally the number of worker processes */
+        "phase::",        /* Optionally load, run or all */
+        "records::",      /* Optionally the number of records loaded */
+        "operations::",   /* Optionally the number of operations run */
+        "duration::",     /* Optionally a time limit in seconds for the run */
+        "target::",       /* Optionally the target operations per second */
+        "distribution::", /* Optionally override with zipfian, uniform or latest */
+        "record-size::",  /* Optionally small, medium or large */
+        "scan-length::",  /* Optionally the max keys of a workload E batch read */
+        "update-with::",  /* Optionally put, operate or udf */
+        "namespace::",    /* Optionally the namespace */
+        "set::",          /* Optionally the set */
+        "json",           /* Output one JSON document, for comparing builds */
+        "worker::",       /* Internal: run as worker N */
+        "help",           /* Usage */
+    );
+    $options = getopt($shortopts, $longopts);
+    return $options;
+}
+
+function workloads() {
+    return array(
+        "a" => array("mix" => array("read" => 0.5, "update" => 0.5), "distribution" => "zipfian"),
+        "b" => array("mix" => array("read" => 0.95, "update" => 0.05), "distribution" => "zipfian"),
+        "c" => array("mix" => array("read" => 1.0), "distribution" => "zipfian"),
+        "d" => array("mix" => array("read" => 0.95, "insert" => 0.05), "distribution" => "latest"),
+        "e" => array("mix" => array("scan" => 0.95, "insert" => 0.05), "distribution" => "zipfian"),
+        "f" => array("mix" => array("read" => 0.5, "rmw" => 0.5), "distribution" => "zipfian"));
+}
+
+function record_sizes() {
+    /* bins x bytes per bin */
+    return array(
+        "small" => array(1, 100),
+        "medium" => array(10, 100),
+        "large" => array(10, 1000));
+}
+
+/*
+ * Log-linear latency histogram in microseconds, in the manner of
+ * HdrHistogram: values below 256 are exact, above that every power of two
+ * is split into 128 buckets.
+ */
+class LatencyHistogram {
+    public $counts = array();
+    public $total = 0;
+    public $sum = 0;
+    public $min = null;
+    public $max = 0;
+
+    private static function index($value) {
+        if ($value < 256) {
+            return $value;
+        }
+        $exponent = 0;
+        while ($value >= 256) {
+            $value >>= 1;
+            $exponent++;
+        }
+        return 256 + ($exponent - 1) * 128 + ($value - 128);
+    }
+
+    private static function highest($index) {
+        if ($index < 256) {
+            return $index;
+        }
+        $exponent = (int) (($index - 256) / 128) + 1;
+        $mantissa = ($index - 256) % 128 + 128;
+        return (($mantissa + 1) << $exponent) - 1;
+    }
+
+    public function record($us) {
+        $us = max(0, (int) $us);
+        $index = self::index($us);
+        $this->counts[$index] = isset($this->counts[$index]) ? $this->counts[$index] + 1 : 1;
+        $this->total++;
+        $this->sum += $us;
+        $this->min = is_null($this->min) ? $us : min($this->min, $us);
+        $this->max = max($this->max, $us);
+    }
+
+    public function merge($other) {
+        foreach ($other['counts'] as $index => $count) {
+            $this->counts[$index] = isset($this->counts[$index]) ? $this->counts[$index] + $count : $count;
+        }
+        $this->total += $other['total'];
+        $this->sum += $other['sum'];
+        if (!is_null($other['min'])) {
+            $this->min = is_null($this->min) ? $other['min'] : min($this->min, $other['min']);
+        }
+        $this->max = max($this->max, $other['max']);
+    }
+
+    public function percentile($percentile) {
+        if ($this->total == 0) {
+            return 0;
+        }
+        ksort($this->counts);
+        $target = max(1, (int) ceil($this->total * $percentile / 100));
+        $seen = 0;
+        foreach ($this->counts as $index => $count) {
+            $seen += $count;
+            if ($seen >= $target) {
+                return min(self::highest($index), $this->max);
+            }
+        }
+        return $this->max;
+    }
+
+    public function export() {
+        return array("counts" => $this->counts, "total" => $this->total, "sum" => $this->sum,
+            "min" => $this->min, "max" => $this->max);
+    }
+
+    public function summary() {
+        return array(
+            "count" => $this->total,
+            "avg_us" => ($this->total > 0) ? round($this->sum / $this->total, 1) : 0,
+            "min_us" => (int) $this->min,
+            "p50_us" => $this->percentile(50),
+            "p90_us" => $this->percentile(90),
+            "p99_us" => $this->percentile(99),
+            "p999_us" => $this->percentile(99.9),
+            "max_us" => $this->max);
+    }
+}
+
+/*
+ * Key choosers. The zipfian generator is the one of Gray et al. used by
+ * YCSB, with the popular items scattered over the key space; latest favors
+ * the most recently inserted keys.
+ */
+class ZipfianGenerator {
+    const THETA = 0.99;
+    private $items = 0;
+    private $zetan = 0.0;
+    private $zeta2;
+    private $alpha;
+    private $eta;
+
+    public function __construct($items) {
+        $this->zeta2 = 1 + pow(0.5, self::THETA);
+        $this->alpha = 1.0 / (1.0 - self::THETA);
+        $this->grow($items);
+    }
+
+    public function grow($items) {
+        for ($i = $this->items + 1; $i <= $items; $i++) {
+            $this->zetan += 1.0 / pow($i, self::THETA);
+        }
+        $this->items = $items;
+        $this->eta = (1 - pow(2.0 / $items, 1 - self::THETA)) / (1 - $this->zeta2 / $this->zetan);
+    }
+
+    public function next() {
+        $u = mt_rand() / mt_getrandmax();
+        $uz = $u * $this->zetan;
+        if ($uz < 1.0) {
+            return 0;
+        }
+        if ($uz < 1.0 + pow(0.5, self::THETA)) {
+            return 1;
+        }
+        return min($this->items - 1, (int) ($this->items * pow($this->eta * $u - $this->eta + 1, $this->alpha)));
+    }
+}
+
+class KeyChooser {
+    private $distribution;
+    private $zipfian = null;
+    private $items;
+
+    public function __construct($distribution, $items) {
+        $this->distribution = $distribution;
+        $this->items = $items;
+        if ($distribution != "uniform") {
+            $this->zipfian = new ZipfianGenerator($items);
+        }
+    }
+
+    public function grow($items) {
+        $this->items = $items;
+        if ($this->distribution == "latest") {
+            $this->zipfian->grow($items);
+        }
+    }
+
+    public function next() {
+        switch ($this->distribution) {
+            case "uniform":
+                return mt_rand(0, $this->items - 1);
+            case "latest":
+                return $this->items - 1 - $this->zipfian->next();
+            default:
+                return crc32("item".$this->zipfian->next()) % $this->items;
+        }
+    }
+}
+
+class Workload {
+    private $db;
+    private $ns;
+    private $set;
+    private $bins;
+    private $bin_size;
+    private $values;
+    private $update_with;
+    private $scan_length;
+    public $histograms = array();
+    public $errors = array();
+
+    public function __construct($db, $config) {
+        $this->db = $db;
+        $this->ns = $config["namespace"];
+        $this->set = $config["set"];
+        list($this->bins, $this->bin_size) = $config["record_size"];
+        $this->update_with = $config["update_with"];
+        $this->scan_length = $config["scan_length"];
+        $this->values = str_repeat(md5(mt_rand()), (int) ceil(($this->bin_size + 1024) / 32));
+    }
+
+    private function key($n) {
+        return $this->db->initKey($this->ns, $this->set, "user".$n);
+    }
+
+    private function value() {
+        return substr($this->values, mt_rand(0, 1023), $this->bin_size);
+    }
+
+    private function record() {
+        $record = array();
+        for ($i = 0; $i < $this->bins; $i++) {
+            $record["field$i"] = $this->value();
+        }
+        return $record;
+    }
+
+    private function timed($op, $intended, $status) {
+        $us = (microtime(true) - $intended) * 1000000;
+        if (!isset($this->histograms[$op])) {
+            $this->histograms[$op] = new LatencyHistogram();
+            $this->errors[$op] = 0;
+        }
+        $this->histograms[$op]->record($us);
+        if ($status !== Aerospike::OK && $status !== Aerospike::ERR_RECORD_NOT_FOUND) {
+            $this->errors[$op]++;
+        }
+    }
+
+    public function insert($n, $intended) {
+        $status = $this->db->put($this->key($n), $this->record());
+        $this->timed("insert", $intended, $status);
+    }
+
+    public function read($n, $intended) {
+        $status = $this->db->get($this->key($n), $record);
+        $this->timed("read", $intended, $status);
+    }
+
+    public function update($n, $intended) {
+        $bin = "field".mt_rand(0, $this->bins - 1);
+        switch ($this->update_with) {
+            case "operate":
+                $operations = array(array("op" => Aerospike::OPERATOR_WRITE, "bin" => $bin, "val" => $this->value()));
+                $status = $this->db->operate($this->key($n), $operations);
+                break;
+            case "udf":
+                $status = $this->db->apply($this->key($n), "ycsb_udf", "update", array($bin, $this->value()));
+                break;
+            default:
+                $status = $this->db->put($this->key($n), array($bin => $this->value()));
+                break;
+        }
+        $this->timed("update", $intended, $status);
+    }
+
+    public function rmw($n, $intended) {
+        $bin = "field".mt_rand(0, $this->bins - 1);
+        $operations = array(
+            array("op" => Aerospike::OPERATOR_READ, "bin" => $bin),
+            array("op" => Aerospike::OPERATOR_WRITE, "bin" => $bin, "val" => $this->value()));
+        $status = $this->db->operate($this->key($n), $operations, $returned);
+        $this->timed("rmw", $intended, $status);
+    }
+
+    public function scan($n, $intended) {
+        $keys = array();
+        $length = mt_rand(1, $this->scan_length);
+        for ($i = 0; $i < $length; $i++) {
+            $keys[] = $this->key($n + $i);
+        }
+        $status = $this->db->getMany($keys, $records);
+        $this->timed("scan", $intended, $status);
+    }
+
+    public function export() {
+        $operations = array();
+        foreach ($this->histograms as $op => $histogram) {
+            $operations[$op] = array("errors" => $this->errors[$op], "histogram" => $histogram->export());
+        }
+        return $operations;
+    }
+}
+
+function run_worker($db, $config, $worker, $workers) {
+    $workload = new Workload($db, $config);
+    $begin = microtime(true);
+    $rate = ($config["target"] > 0) ? $config["target"] / $workers : 0;
+
+    if ($config["phase"] == "load") {
+        $done = 0;
+        for ($n = $worker; $n < $config["records"]; $n += $workers) {
+            $intended = ($rate > 0) ? $begin + $done / $rate : microtime(true);
+            $now = microtime(true);
+            if ($intended > $now) {
+                usleep((int) (($intended - $now) * 1000000));
+            }
+            $workload->insert($n, $intended);
+            $done++;
+        }
+        return array("runtime" => microtime(true) - $begin, "operations" => $workload->export());
+    }
+
+    $definition = $config["workload"];
+    $chooser = new KeyChooser($config["distribution"], $config["records"]);
+    $next_insert = $config["records"] + $worker;
+    $limit = ($config["operations"] > 0) ? (int) ceil($config["operations"] / $workers) : PHP_INT_MAX;
+    $deadline = ($config["duration"] > 0) ? $begin + $config["duration"] : PHP_INT_MAX;
+    for ($done = 0; $done < $limit; $done++) {
+        /* with a target rate latency is measured from the intended start,
+         * so a stalled server is not hidden by the driver slowing down */
+        $intended = ($rate > 0) ? $begin + $done / $rate : microtime(true);
+        $now = microtime(true);
+        if ($intended > $now) {
+            usleep((int) (($intended - $now) * 1000000));
+        }
+        if ($now > $deadline) {
+            break;
+        }
+        $pick = mt_rand() / mt_getrandmax();
+        $op = "read";
+        foreach ($definition["mix"] as $op => $share) {
+            $pick -= $share;
+            if ($pick < 0) {
+                break;
+            }
+        }
+        if ($op == "insert") {
+            $workload->insert($next_insert, $intended);
+            $next_insert += $workers;
+            $chooser->grow($next_insert - $workers + 1);
+        } else {
+            $workload->$op($chooser->next(), $intended);
+        }
+    }
+    return array("runtime" => microtime(true) - $begin, "operations" => $workload->export());
+}
+
+function spawn_workers($config, $phase) {
+    global $argv;
+    $php = defined('PHP_BINARY') ? PHP_BINARY : "php";
+    $processes = array();
+    for ($i = 0; $i < $config["workers"]; $i++) {
+        $command = escapeshellarg($php);
+        foreach ($argv as $arg) {
+            if (strpos($arg, "--phase") !== 0 && $arg !== "--json") {
+                $command .= " ".escapeshellarg($arg);
+            }
+        }
+        $command .= " --phase=$phase --worker=$i --json";
+        $pipes = array();
+        $process = proc_open($command, array(1 => array("pipe", "w")), $pipes);
+        $processes[] = array($process, $pipes[1]);
+    }
+    $results = array();
+    foreach ($processes as $entry) {
+        $output = stream_get_contents($entry[1]);
+        fclose($entry[1]);
+        proc_close($entry[0]);
+        $result = json_decode($output, true);
+        if (!is_array($result)) {
+            echo fail("A worker failed: $output");
+            exit(1);
+        }
+        $results[] = $result;
+    }
+    return $results;
+}
+
+function summarize($results) {
+    $histograms = array();
+    $errors = array();
+    $runtime = 0;
+    foreach ($results as $result) {
+        $runtime = max($runtime, $result["runtime"]);
+        foreach ($result["operations"] as $op => $data) {
+            if (!isset($histograms[$op])) {
+                $histograms[$op] = new LatencyHistogram();
+                $errors[$op] = 0;
+            }
+            $histograms[$op]->merge($data["histogram"]);
+            $errors[$op] += $data["errors"];
+        }
+    }
+    $total = 0;
+    $operations = array();
+    foreach ($histograms as $op => $histogram) {
+        $operations[$op] = array_merge($histogram->summary(), array("errors" => $errors[$op]));
+        $total += $histogram->total;
+    }
+    return array(
+        "runtime_sec" => round($runtime, 3),
+        "operations_total" => $total,
+        "ops_per_sec" => ($runtime > 0) ? round($total / $runtime, 1) : 0,
+        "operations" => $operations);
+}
+
+function print_phase($name, $summary) {
+    echo colorize("[$name] {$summary['operations_total']} operations in {$summary['runtime_sec']}s, ".
+        "{$summary['ops_per_sec']} ops/s\n", 'purple', true);
+    printf("%-8s %10s %8s %10s %8s %8s %8s %8s %10s\n", "op", "count", "errors", "avg us",
+        "p50", "p90", "p99", "p99.9", "max us");
+    foreach ($summary["operations"] as $op => $stats) {
+        printf("%-8s %10d %8d %10.1f %8d %8d %8d %8d %10d\n", $op, $stats["count"], $stats["errors"],
+            $stats["avg_us"], $stats["p50_us"], $stats["p90_us"], $stats["p99_us"],
+            $stats["p999_us"], $stats["max_us"]);
+    }
+}
+
+function connect($addr, $port) {
+    $config = array("hosts" => array(array("addr" => $addr, "port" => $port)));
+    $db = new Aerospike($config, true);
+    if (!$db->isConnected()) {
+        echo fail("Could not connect to host $addr:$port [{$db->errorno()}]: {$db->error()}");
+        exit(1);
+    }
+    return $db;
+}
+
+function register_udf($db) {
+    $module = ini_get('aerospike.udf.lua_user_path').'/ycsb_udf.lua';
+    if (!copy(__DIR__.'/lua/ycsb_udf.lua', $module)) {
+        echo fail("Could not copy the UDF module to ".ini_get('aerospike.udf.lua_user_path'));
+        exit(1);
+    }
+    if ($db->register($module, "ycsb_udf.lua") !== Aerospike::OK) {
+        echo standard_fail($db);
+        exit(1);
+    }
+}
+
+$args = parse_args();
+if (isset($args["help"])) {
+    echo "php ycsb.php [-hHOST] [-pPORT] [-wWORKLOAD] [-cWORKERS]\n";
+    echo " or\n";
+    echo "php ycsb.php [--host=HOST] [--port=PORT] [--workload=a|b|c|d|e|f] [--workers=WORKERS]\n";
+    echo "    [--phase=load|run|all] [--records=RECORDS] [--operations=OPERATIONS] [--duration=SECONDS]\n";
+    echo "    [--target=OPS_PER_SEC] [--distribution=zipfian|uniform|latest] [--record-size=small|medium|large]\n";
+    echo "    [--scan-length=KEYS] [--update-with=put|operate|udf] [--namespace=NS] [--set=SET] [--json]\n";
+    exit(1);
+}
+$addr = (isset($args["h"])) ? (string) $args["h"] : ((isset($args["host"])) ? (string) $args["host"] : "localhost");
+$port = (isset($args["p"])) ? (integer) $args["p"] : ((isset($args["port"])) ? (integer) $args["port"] : 3000);
+$name = strtolower((isset($args["w"])) ? (string) $args["w"] : ((isset($args["workload"])) ? (string) $args["workload"] : "a"));
+$workloads = workloads();
+$sizes = record_sizes();
+if (!isset($workloads[$name])) {
+    echo fail("Unknown workload $name");
+    exit(1);
+}
+$config = array(
+    "workload_name" => $name,
+    "workload" => $workloads[$name],
+    "workers" => max(1, (isset($args["c"])) ? (integer) $args["c"] : ((isset($args["workers"])) ? (integer) $args["workers"] : 1)),
+    "phase" => (isset($args["phase"])) ? (string) $args["phase"] : "all",
+    "records" => (isset($args["records"])) ? (integer) $args["records"] : 100000,
+    "operations" => (isset($args["operations"])) ? (integer) $args["operations"] : 100000,
+    "duration" => (isset($args["duration"])) ? (integer) $args["duration"] : 0,
+    "target" => (isset($args["target"])) ? (integer) $args["target"] : 0,
+    "distribution" => (isset($args["distribution"])) ? (string) $args["distribution"] : $workloads[$name]["distribution"],
+    "record_size_name" => (isset($args["record-size"])) ? (string) $args["record-size"] : "medium",
+    "scan_length" => (isset($args["scan-length"])) ? (integer) $args["scan-length"] : 100,
+    "update_with" => (isset($args["update-with"])) ? (string) $args["update-with"] : "put",
+    "namespace" => (isset($args["namespace"])) ? (string) $args["namespace"] : "test",
+    "set" => (isset($args["set"])) ? (string) $args["set"] : "ycsb");
+if (!isset($sizes[$config["record_size_name"]])) {
+    echo fail("Unknown record size {$config['record_size_name']}");
+    exit(1);
+}
+$config["record_size"] = $sizes[$config["record_size_name"]];
+if ($config["duration"] > 0 && !isset($args["operations"])) {
+    $config["operations"] = 0;
+}
+
+if (isset($args["worker"])) {
+    mt_srand(getmypid() ^ (int) (microtime(true) * 1000000));
+    $db = connect($addr, $port);
+    echo json_encode(run_worker($db, $config, (integer) $args["worker"], $config["workers"]))."\n";
+    $db->close();
+    exit(0);
+}
+
+$report = array(
+    "extension" => phpversion("aerospike"),
+    "php" => PHP_VERSION,
+    "config" => array(
+        "workload" => $name,
+        "workers" => $config["workers"],
+        "records" => $config["records"],
+        "operations" => $config["operations"],
+        "duration" => $config["duration"],
+        "target" => $config["target"],
+        "distribution" => $config["distribution"],
+        "record_size" => $config["record_size_name"],
+        "update_with" => $config["update_with"]),
+    "phases" => array());
+
+if ($config["update_with"] == "udf" && $config["phase"] != "load") {
+    $db = connect($addr, $port);
+    register_udf($db);
+    $db->close();
+}
+foreach (array("load", "run") as $phase) {
+    if ($config["phase"] != "all" && $config["phase"] != $phase) {
+        continue;
+    }
+    $report["phases"][$phase] = summarize(spawn_workers($config, $phase));
+    if (!isset($args["json"])) {
+        print_phase($phase, $report["phases"][$phase]);
+    }
+}
+
+if (isset($args["json"])) {
+    echo json_encode($report)."\n";
+}
+?>
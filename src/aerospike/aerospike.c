@@ -87,12 +87,18 @@ PHP_INI_BEGIN()
    STD_PHP_INI_ENTRY("aerospike.serializer", SERIALIZER_DEFAULT, PHP_INI_PERDIR|PHP_INI_SYSTEM, OnUpdateString, serializer, zend_aerospike_globals, aerospike_globals)
    STD_PHP_INI_ENTRY("aerospike.udf.lua_system_path", "/opt/aerospike/client-php/sys-lua", PHP_INI_PERDIR|PHP_INI_SYSTEM, OnUpdateString, lua_system_path, zend_aerospike_globals, aerospike_globals)
    STD_PHP_INI_ENTRY("aerospike.udf.lua_user_path", "/opt/aerospike/client-php/usr-lua", PHP_INI_PERDIR|PHP_INI_SYSTEM, OnUpdateString, lua_user_path, zend_aerospike_globals, aerospike_globals)
+   STD_PHP_INI_ENTRY("aerospike.udf.lua_cache_enabled", "false", PHP_INI_PERDIR|PHP_INI_SYSTEM, OnUpdateBool, lua_cache_enabled, zend_aerospike_globals, aerospike_globals)
    STD_PHP_INI_ENTRY("aerospike.key_policy", "0", PHP_INI_PERDIR|PHP_INI_SYSTEM, OnUpdateString, key_policy, zend_aerospike_globals, aerospike_globals)
    STD_PHP_INI_ENTRY("aerospike.key_gen", "0", PHP_INI_PERDIR|PHP_INI_SYSTEM, OnUpdateString, key_gen, zend_aerospike_globals, aerospike_globals)
    STD_PHP_INI_ENTRY("aerospike.shm.use", "false", PHP_INI_PERDIR|PHP_INI_SYSTEM, OnUpdateBool, shm_use, zend_aerospike_globals, aerospike_globals)
    STD_PHP_INI_ENTRY("aerospike.shm.max_nodes", "16", PHP_INI_PERDIR|PHP_INI_SYSTEM, OnUpdateLong, shm_max_nodes, zend_aerospike_globals, aerospike_globals)
    STD_PHP_INI_ENTRY("aerospike.shm.max_namespaces", "8", PHP_INI_PERDIR|PHP_INI_SYSTEM, OnUpdateLong, shm_max_namespaces, zend_aerospike_globals, aerospike_globals)
    STD_PHP_INI_ENTRY("aerospike.shm.takeover_threshold_sec", "30", PHP_INI_PERDIR|PHP_INI_SYSTEM, OnUpdateLong, shm_takeover_threshold_sec, zend_aerospike_globals, aerospike_globals)
+   STD_PHP_INI_ENTRY("aerospike.preconnect", NULL, PHP_INI_SYSTEM, OnUpdateString, preconnect, zend_aerospike_globals, aerospike_globals)
+   STD_PHP_INI_ENTRY("aerospike.preconnect_sockets", "0", PHP_INI_SYSTEM, OnUpdateLong, preconnect_sockets, zend_aerospike_globals, aerospike_globals)
+   STD_PHP_INI_ENTRY("aerospike.persistent.idle_timeout_sec", "0", PHP_INI_PERDIR|PHP_INI_SYSTEM, OnUpdateLong, persistent_idle_timeout_sec, zend_aerospike_globals, aerospike_globals)
+   STD_PHP_INI_ENTRY("aerospike.slow_op_threshold_ms", "0", PHP_INI_ALL, OnUpdateLong, slow_op_threshold_ms, zend_aerospike_globals, aerospike_globals)
+   STD_PHP_INI_ENTRY("aerospike.persistent.max_age_sec", "0", PHP_INI_PERDIR|PHP_INI_SYSTEM, OnUpdateLong, persistent_max_age_sec, zend_aerospike_globals, aerospike_globals)
 PHP_INI_END()
 
 
@@ -119,6 +125,9 @@ static void aerospike_check_close_and_destroy(void *hashtable_element) {
             }
             as_ref_p->ref_hosts_entry = 0;
             as_ref_p->as_p = NULL;
+            if (as_ref_p->config_key_p) {
+                pefree(as_ref_p->config_key_p, 1);
+            }
             if (as_ref_p) {
                 pefree(as_ref_p, 1);
             }
@@ -134,9 +143,18 @@ static void aerospike_globals_ctor(zend_aerospike_globals *globals TSRMLS_DC)
 {
     DEBUG_PHP_EXT_DEBUG("In ctor");
     pthread_rwlock_init(&AEROSPIKE_G(aerospike_mutex), NULL);
+    AEROSPIKE_G(preconnected) = false;
+#ifndef AEROSPIKE_NO_STATS
+    AEROSPIKE_G(stats_g) = aerospike_stats_create();
+#else
+    AEROSPIKE_G(stats_g) = NULL;
+#endif
+    AEROSPIKE_G(stats_call_g) = NULL;
+    AEROSPIKE_G(session_cache_g) = NULL;
     if ((!(AEROSPIKE_G(persistent_list_g))) || (AEROSPIKE_G(persistent_ref_count) < 1)) {
         AEROSPIKE_G(persistent_list_g) = (HashTable *)pemalloc(sizeof(HashTable), 1);
         zend_hash_init(AEROSPIKE_G(persistent_list_g), 1000, NULL, &aerospike_check_close_and_destroy, 1);
+        AEROSPIKE_G(registry_g) = NULL;
         AEROSPIKE_G(persistent_ref_count) = 1;
     } else {
         AEROSPIKE_G(persistent_ref_count)++;
@@ -145,9 +163,14 @@ static void aerospike_globals_ctor(zend_aerospike_globals *globals TSRMLS_DC)
 
 static void aerospike_globals_dtor(zend_aerospike_globals *globals TSRMLS_DC)
 {
+    aerospike_stats_destroy(AEROSPIKE_G(stats_g));
+    AEROSPIKE_G(stats_g) = NULL;
+    /* releases the connections of the cached sessions, before the registry goes */
+    aerospike_session_cache_destroy(TSRMLS_C);
     if (globals->persistent_list_g) {
         if (AEROSPIKE_G(persistent_ref_count) == 1) {
             DEBUG_PHP_EXT_DEBUG("Ref count is working");
+            aerospike_helper_registry_destroy(&AEROSPIKE_G(registry_g));
             zend_hash_clean(AEROSPIKE_G(persistent_list_g));
             zend_hash_destroy(AEROSPIKE_G(persistent_list_g));
             pefree(AEROSPIKE_G(persistent_list_g), 1);
@@ -199,6 +222,20 @@ ZEND_ARG_PASS_INFO(0)
 ZEND_ARG_PASS_INFO(1)
 ZEND_END_ARG_INFO()
 
+/*
+ ********************************************************************
+ * Using "arginfo_fourth_by_ref" in zend_arg_info argument of a
+ * zend_function_entry accepts fourth argument of the
+ * corresponding functions by reference and rest by value.
+ ********************************************************************
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_fourth_by_ref, 0)
+ZEND_ARG_PASS_INFO(0)
+ZEND_ARG_PASS_INFO(0)
+ZEND_ARG_PASS_INFO(0)
+ZEND_ARG_PASS_INFO(1)
+ZEND_END_ARG_INFO()
+
 /*
  ********************************************************************
  * Using "arginfo_fifth_by_ref" in zend_arg_info argument of a
@@ -294,6 +331,10 @@ static zend_function_entry Aerospike_class_functions[] =
     PHP_ME(Aerospike, close, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(Aerospike, reconnect, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(Aerospike, getNodes, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Aerospike, shmStats, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Aerospike, nodeStats, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Aerospike, runtimeInfo, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Aerospike, stats, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(Aerospike, info, arginfo_sec_by_ref, ZEND_ACC_PUBLIC)
     PHP_ME(Aerospike, infoMany, NULL, ZEND_ACC_PUBLIC)
 
@@ -325,6 +366,9 @@ static zend_function_entry Aerospike_class_functions[] =
     PHP_ME(Aerospike, removeBin, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(Aerospike, setDeserializer, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_ME(Aerospike, setSerializer, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+#ifdef AEROSPIKE_BENCH
+    PHP_ME(Aerospike, benchTransform, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+#endif
     PHP_ME(Aerospike, touch, NULL, ZEND_ACC_PUBLIC)
 
     /*
@@ -334,6 +378,7 @@ static zend_function_entry Aerospike_class_functions[] =
      */
     PHP_ME(Aerospike, setLogLevel, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(Aerospike, setLogHandler, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Aerospike, setTraceHandler, NULL, ZEND_ACC_PUBLIC)
 
     /*
      ********************************************************************
@@ -355,6 +400,12 @@ static zend_function_entry Aerospike_class_functions[] =
     PHP_ME(Aerospike, scan, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(Aerospike, scanApply, arginfo_sixth_by_ref, ZEND_ACC_PUBLIC)
     PHP_ME(Aerospike, scanInfo, arginfo_sec_by_ref, ZEND_ACC_PUBLIC)
+    PHP_ME(Aerospike, scanIterator, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Aerospike, queryIterator, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Aerospike, scanToFile, arginfo_fifth_by_ref, ZEND_ACC_PUBLIC)
+    PHP_ME(Aerospike, importFile, arginfo_sixth_by_ref, ZEND_ACC_PUBLIC)
+    PHP_ME(Aerospike, scanAggregate, arginfo_fourth_by_ref, ZEND_ACC_PUBLIC)
+    PHP_ME(Aerospike, queryAggregate, arginfo_fifth_by_ref, ZEND_ACC_PUBLIC)
 
     /*
      ********************************************************************
@@ -391,6 +442,7 @@ static void Aerospike_object_free_storage(void *object TSRMLS_DC)
     as_error_init(&error);
 
     if (intern_obj_p) {
+        aerospike_iterator_close_all(intern_obj_p TSRMLS_CC);
         if (intern_obj_p->is_persistent == false && intern_obj_p->as_ref_p) {
             if (intern_obj_p->as_ref_p->ref_as_p != 0) {
                 if (AEROSPIKE_OK != aerospike_close(intern_obj_p->as_ref_p->as_p, &error)) {
@@ -407,6 +459,16 @@ static void Aerospike_object_free_storage(void *object TSRMLS_DC)
             if (intern_obj_p->as_ref_p) {
                 pefree(intern_obj_p->as_ref_p, 1);
             }
+        } else if (intern_obj_p->as_ref_p &&
+                intern_obj_p->is_conn_16 == AEROSPIKE_CONN_STATE_TRUE) {
+            /*
+             * The persistent connection is no longer held by this object, as
+             * if close() had been called, so that it can be reaped once idle.
+             */
+            if (intern_obj_p->as_ref_p->ref_as_p > 0) {
+                intern_obj_p->as_ref_p->ref_as_p--;
+            }
+            intern_obj_p->as_ref_p->last_used = time(NULL);
         }
         intern_obj_p->as_ref_p = NULL;
         zend_object_std_dtor(&intern_obj_p->std TSRMLS_CC);
@@ -500,10 +562,12 @@ PHP_METHOD(Aerospike, __construct)
         goto exit;
     }
 
-    /* configuration */
+    /* configuration, zeroed first as it is hashed to find a persistent connection */
+    memset(&config, 0, sizeof(as_config));
     as_config_init(&config);
     strcpy(config.lua.system_path, ini_value = LUA_SYSTEM_PATH_PHP_INI);
     strcpy(config.lua.user_path, ini_value = LUA_USER_PATH_PHP_INI);
+    config.lua.cache_enabled = LUA_CACHE_ENABLED_PHP_INI;
     aerospike_helper_check_and_configure_shm(&config TSRMLS_CC);
 
     /* check for hosts, user and pass within config*/
@@ -619,6 +683,9 @@ PHP_METHOD(Aerospike, close)
         goto exit;
     }
 
+    /* live iterators must not keep scanning over a closed connection */
+    aerospike_iterator_close_all(aerospike_obj_p TSRMLS_CC);
+
     if (aerospike_obj_p->is_persistent == false) {
         if (AEROSPIKE_OK !=
                  (status = aerospike_close(aerospike_obj_p->as_ref_p->as_p, &error))) {
@@ -712,6 +779,9 @@ PHP_METHOD(Aerospike, get)
     as_key                 as_key_for_get_record;
     int16_t                initializeKey = 0;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_GET);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -775,6 +845,7 @@ PHP_METHOD(Aerospike, get)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     if (initializeKey) {
         as_key_destroy(&as_key_for_get_record);
     }
@@ -797,6 +868,9 @@ PHP_METHOD(Aerospike, put)
     as_key                 as_key_for_put_record;
     int16_t                initializeKey = 0;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_PUT);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -843,6 +917,7 @@ PHP_METHOD(Aerospike, put)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     if (initializeKey) {
         as_key_destroy(&as_key_for_put_record);
     }
@@ -895,6 +970,148 @@ exit:
 }
 /* }}} */
 
+/* {{{ proto array Aerospike::shmStats( void )
+   Gets the state of the shared memory cluster map of the connection */
+PHP_METHOD(Aerospike, shmStats)
+{
+    as_status              status = AEROSPIKE_OK;
+    as_error               error;
+    Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+
+    as_error_init(&error);
+
+    if (!aerospike_obj_p) {
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR, "Invalid aerospike object");
+        DEBUG_PHP_EXT_ERROR("Invalid aerospike object");
+        status = AEROSPIKE_ERR;
+        goto exit;
+    }
+
+    if (PHP_IS_CONN_NOT_ESTABLISHED(aerospike_obj_p->is_conn_16)) {
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_CLUSTER,
+                "shmStats: connection not established");
+        DEBUG_PHP_EXT_ERROR("shmStats: connection not established");
+        status = AEROSPIKE_ERR_CLUSTER;
+        goto exit;
+    }
+
+    array_init(return_value);
+
+    if (AEROSPIKE_OK !=
+            (status = aerospike_info_shm_stats(aerospike_obj_p->as_ref_p,
+                                               &error, return_value TSRMLS_CC))) {
+        DEBUG_PHP_EXT_ERROR("shmStats function returned an error");
+        goto exit;
+    }
+
+exit:
+    PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
+    aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
+    if (AEROSPIKE_OK != status) {
+        zval_dtor(return_value);
+        RETURN_NULL();
+    }
+}
+/* }}} */
+
+/* {{{ proto array Aerospike::nodeStats( void )
+   Gets the client-side view and counters of each node of the cluster */
+PHP_METHOD(Aerospike, nodeStats)
+{
+    as_status              status = AEROSPIKE_OK;
+    as_error               error;
+    Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+
+    as_error_init(&error);
+
+    if (!aerospike_obj_p) {
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR, "Invalid aerospike object");
+        DEBUG_PHP_EXT_ERROR("Invalid aerospike object");
+        status = AEROSPIKE_ERR;
+        goto exit;
+    }
+
+    if (PHP_IS_CONN_NOT_ESTABLISHED(aerospike_obj_p->is_conn_16)) {
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_CLUSTER,
+                "nodeStats: connection not established");
+        DEBUG_PHP_EXT_ERROR("nodeStats: connection not established");
+        status = AEROSPIKE_ERR_CLUSTER;
+        goto exit;
+    }
+
+    array_init(return_value);
+
+    if (AEROSPIKE_OK !=
+            (status = aerospike_info_node_stats(aerospike_obj_p->as_ref_p->as_p,
+                                                &error, return_value TSRMLS_CC))) {
+        DEBUG_PHP_EXT_ERROR("nodeStats function returned an error");
+        goto exit;
+    }
+
+exit:
+    PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
+    aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
+    if (AEROSPIKE_OK != status) {
+        zval_dtor(return_value);
+        RETURN_NULL();
+    }
+}
+/* }}} */
+
+/* {{{ proto array Aerospike::runtimeInfo( void )
+   Gets the runtime state of the extension in this process, as in phpinfo() */
+PHP_METHOD(Aerospike, runtimeInfo)
+{
+    array_init(return_value);
+    aerospike_info_runtime(return_value TSRMLS_CC);
+    PHP_EXT_RESET_AS_ERR_IN_CLASS();
+    aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
+}
+/* }}} */
+
+/* {{{ proto array Aerospike::stats( [ bool reset=false ] )
+   Gets the client-side latency statistics of the operations */
+PHP_METHOD(Aerospike, stats)
+{
+    as_status              status = AEROSPIKE_OK;
+    as_error               error;
+    zend_bool              reset = false;
+    Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+
+    as_error_init(&error);
+
+    if (!aerospike_obj_p) {
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR, "Invalid aerospike object");
+        DEBUG_PHP_EXT_ERROR("Invalid aerospike object");
+        status = AEROSPIKE_ERR;
+        goto exit;
+    }
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "|b", &reset) == FAILURE) {
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Unable to parse parameters for stats");
+        DEBUG_PHP_EXT_ERROR("Unable to parse parameters for stats");
+        status = AEROSPIKE_ERR_PARAM;
+        goto exit;
+    }
+
+    array_init(return_value);
+
+    if (AEROSPIKE_OK !=
+            (status = aerospike_stats_get(return_value, reset, &error TSRMLS_CC))) {
+        DEBUG_PHP_EXT_ERROR("stats function returned an error");
+        goto exit;
+    }
+
+exit:
+    PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
+    aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
+    if (AEROSPIKE_OK != status) {
+        zval_dtor(return_value);
+        RETURN_NULL();
+    }
+}
+/* }}} */
+
 /* {{{ proto int Aerospike::info( string request, string &response [, array host [, array options ]] )
    Sends an info command to a cluster node */
 PHP_METHOD(Aerospike, info)
@@ -1025,6 +1242,9 @@ PHP_METHOD(Aerospike, existsMany)
     zval*                   metadata_p = NULL;
     zval*                   options_p = NULL;
     Aerospike_object*       aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call    stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_BATCH);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -1067,6 +1287,7 @@ PHP_METHOD(Aerospike, existsMany)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
     aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
     RETURN_LONG(status);
@@ -1084,6 +1305,9 @@ PHP_METHOD(Aerospike, getMany)
     zval*                   filter_bins_p = NULL;
     zval*                   options_p = NULL;
     Aerospike_object*       aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call    stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_BATCH);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -1119,6 +1343,7 @@ PHP_METHOD(Aerospike, getMany)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
     aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
     RETURN_LONG(status);
@@ -1138,6 +1363,9 @@ PHP_METHOD(Aerospike, operate)
     as_key                 as_key_for_get_record;
     int16_t                initializeKey = 0;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_OPERATE);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -1196,6 +1424,7 @@ PHP_METHOD(Aerospike, operate)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     if (initializeKey) {
         as_key_destroy(&as_key_for_get_record);
     }
@@ -1221,6 +1450,9 @@ PHP_METHOD(Aerospike, append)
     long                   bin_name_len;
     long                   append_str_len;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_OPERATE);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -1277,6 +1509,7 @@ PHP_METHOD(Aerospike, append)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     if (initializeKey) {
         as_key_destroy(&as_key_for_get_record);
     }
@@ -1297,6 +1530,9 @@ PHP_METHOD(Aerospike, remove)
     as_key                 as_key_for_put_record;
     int16_t                initializeKey = 0;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_REMOVE);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -1338,6 +1574,7 @@ PHP_METHOD(Aerospike, remove)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     if (initializeKey) {
         as_key_destroy(&as_key_for_put_record);
     }
@@ -1357,6 +1594,9 @@ PHP_METHOD(Aerospike, exists)
     zval*                  metadata_p = NULL;
     zval*                  options_p = NULL;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_GET);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -1381,6 +1621,7 @@ PHP_METHOD(Aerospike, exists)
     status = aerospike_php_exists_metadata(aerospike_obj_p, key_record_p, metadata_p, options_p, &error);
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     if (status != AEROSPIKE_OK) {
         PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
     } else {
@@ -1401,6 +1642,9 @@ PHP_METHOD(Aerospike, getMetadata)
     zval*                  metadata_p = NULL;
     zval*                  options_p = NULL;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_GET);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -1426,6 +1670,7 @@ PHP_METHOD(Aerospike, getMetadata)
     status = aerospike_php_exists_metadata(aerospike_obj_p, key_record_p, metadata_p, options_p, &error);
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     if (status != AEROSPIKE_OK) {
         PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
     } else {
@@ -1462,6 +1707,9 @@ PHP_METHOD(Aerospike, prepend)
     long                   bin_name_len;
     long                   prepend_str_len;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_OPERATE);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -1518,6 +1766,7 @@ PHP_METHOD(Aerospike, prepend)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     if (initializeKey) {
         as_key_destroy(&as_key_for_get_record);
     }
@@ -1542,6 +1791,9 @@ PHP_METHOD(Aerospike, increment)
     int                    bin_name_len;
     long                   offset = 0;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_OPERATE);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -1598,6 +1850,7 @@ PHP_METHOD(Aerospike, increment)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     if (initializeKey) {
         as_key_destroy(&as_key_for_get_record);
     }
@@ -1620,6 +1873,9 @@ PHP_METHOD(Aerospike, touch)
     int16_t                initializeKey = 0;
     long                   time_to_live;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_OPERATE);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -1674,6 +1930,7 @@ PHP_METHOD(Aerospike, touch)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     if (initializeKey) {
         as_key_destroy(&as_key_for_get_record);
     }
@@ -1814,6 +2071,35 @@ PHP_METHOD(Aerospike, setSerializer)
 }
 /* }}} */
 
+#ifdef AEROSPIKE_BENCH
+/* {{{ proto array Aerospike::benchTransform( array bins, int iterations [, int serializer ] )
+   Round-trips a record through the transform layer, without a cluster */
+PHP_METHOD(Aerospike, benchTransform)
+{
+    as_error               error;
+    zval*                  bins_p = NULL;
+    long                   iterations = 0;
+    long                   serializer_policy = SERIALIZER_PHP;
+
+    as_error_init(&error);
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "al|l",
+                &bins_p, &iterations, &serializer_policy) == FAILURE) {
+        DEBUG_PHP_EXT_ERROR("Unable to parse parameters for benchTransform");
+        RETURN_NULL();
+    }
+
+    array_init(return_value);
+    if (AEROSPIKE_OK != aerospike_bench_transform(bins_p, iterations,
+                (uint32_t) serializer_policy, return_value, &error TSRMLS_CC)) {
+        DEBUG_PHP_EXT_ERROR("benchTransform: %s", error.message);
+        zval_dtor(return_value);
+        RETURN_NULL();
+    }
+}
+/* }}} */
+#endif
+
 /* {{{ proto int Aerospike::removeBin( array key, array bins [, array options ])
    Removes a bin from a record */
 PHP_METHOD(Aerospike, removeBin)
@@ -1826,6 +2112,9 @@ PHP_METHOD(Aerospike, removeBin)
     as_key                 as_key_for_put_record;
     int16_t                initializeKey = 0;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_OPERATE);
 
     as_error_init(&error);
     if (!aerospike_obj_p) {
@@ -1871,6 +2160,7 @@ PHP_METHOD(Aerospike, removeBin)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
     aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
     RETURN_LONG(status);
@@ -1983,6 +2273,9 @@ PHP_METHOD(Aerospike, query)
     HashTable*              bins_ht_p = NULL;
     HashTable*              predicate_ht_p = NULL;
     Aerospike_object*       aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call    stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_QUERY);
 
     PHP_EXT_SET_AS_ERR(&error, DEFAULT_ERRORNO, DEFAULT_ERROR);
 
@@ -2036,6 +2329,7 @@ PHP_METHOD(Aerospike, query)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
     aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
     RETURN_LONG(status);
@@ -2067,6 +2361,9 @@ PHP_METHOD(Aerospike, aggregate)
     zval*                   options_p = NULL;
     HashTable*              bins_ht_p = NULL;
     Aerospike_object*       aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call    stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_QUERY);
 
     /*
      * TODO:
@@ -2157,6 +2454,7 @@ PHP_METHOD(Aerospike, aggregate)
         goto exit;
     }
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
     aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
     RETURN_LONG(status);
@@ -2181,6 +2479,9 @@ PHP_METHOD(Aerospike, scan)
     zval                   *bins_p = NULL;
     zval                   *options_p = NULL;
     HashTable*             bins_ht_p = NULL;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_SCAN);
 
     /*
      * initialized to 'no error' (status AEROSPIKE_OK, empty message)
@@ -2233,12 +2534,152 @@ PHP_METHOD(Aerospike, scan)
     }
 
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
     aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
     RETURN_LONG(status);
 }
 /* }}} */
 
+/* {{{ proto AerospikeIterator Aerospike::scanIterator( string ns, string set [, array select [, array options ]] )
+   Returns an iterator over the records of a set, prefetched in the background */
+PHP_METHOD(Aerospike, scanIterator)
+{
+    as_status              status = AEROSPIKE_OK;
+    as_error               error;
+    Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    char                   *ns_p = NULL;
+    int                    ns_p_length = 0;
+    char                   *set_p = NULL;
+    int                    set_p_length = 0;
+    zval                   *bins_p = NULL;
+    zval                   *options_p = NULL;
+    aerospike_stream       *stream_p = NULL;
+
+    as_error_init(&error);
+
+    if (!aerospike_obj_p) {
+        status = AEROSPIKE_ERR;
+        DEBUG_PHP_EXT_ERROR("Aerospike::scanIterator() has no valid aerospike object");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR, "Aerospike::scanIterator() has no valid aerospike object");
+        goto exit;
+    }
+
+    if (PHP_IS_CONN_NOT_ESTABLISHED(aerospike_obj_p->is_conn_16)) {
+        status = AEROSPIKE_ERR_CLUSTER;
+        DEBUG_PHP_EXT_ERROR("Aerospike::scanIterator() has no connection to the database");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_CLUSTER, "Aerospike::scanIterator() has no connection to the database");
+        goto exit;
+    }
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "ss|a!a!",
+        &ns_p, &ns_p_length, &set_p, &set_p_length,
+        &bins_p, &options_p) == FAILURE) {
+        status = AEROSPIKE_ERR_PARAM;
+        DEBUG_PHP_EXT_ERROR("Aerospike::scanIterator() unable to parse parameters");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Aerospike::scanIterator() unable to parse parameters");
+        goto exit;
+    }
+
+    if (ns_p_length == 0 || set_p_length == 0) {
+        status = AEROSPIKE_ERR_PARAM;
+        DEBUG_PHP_EXT_ERROR("Aerospike::scanIterator() expects parameter 1 & 2 to be a non-empty strings.");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Aerospike::scanIterator() expects parameter 1 & 2 to be a non-empty strings.");
+        goto exit;
+    }
+
+    if (AEROSPIKE_OK !=
+            (status = aerospike_scan_stream(aerospike_obj_p->as_ref_p->as_p,
+                                     &error, ns_p, set_p,
+                                     (bins_p ? Z_ARRVAL_P(bins_p) : NULL),
+                                     options_p, &stream_p TSRMLS_CC))) {
+        DEBUG_PHP_EXT_ERROR("scanIterator returned an error");
+        goto exit;
+    }
+
+    aerospike_iterator_init(return_value, getThis(), stream_p TSRMLS_CC);
+
+exit:
+    PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
+    aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
+    if (AEROSPIKE_OK != status) {
+        RETURN_NULL();
+    }
+}
+/* }}} */
+
+/* {{{ proto AerospikeIterator Aerospike::queryIterator( string ns, string set, array where [, array select [, array options ]] )
+   Returns an iterator over the records matching a query, prefetched in the background */
+PHP_METHOD(Aerospike, queryIterator)
+{
+    as_status               status = AEROSPIKE_OK;
+    as_error                error;
+    char*                   ns_p = NULL;
+    int                     ns_p_length = 0;
+    char*                   set_p = NULL;
+    int                     set_p_length = 0;
+    zval*                   predicate_p = NULL;
+    zval*                   bins_p = NULL;
+    zval*                   options_p = NULL;
+    aerospike_stream*       stream_p = NULL;
+    Aerospike_object*       aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+
+    PHP_EXT_SET_AS_ERR(&error, DEFAULT_ERRORNO, DEFAULT_ERROR);
+
+    if (!aerospike_obj_p) {
+        status = AEROSPIKE_ERR;
+        DEBUG_PHP_EXT_ERROR("Aerospike::queryIterator() has no valid aerospike object");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR,
+                "Aerospike::queryIterator() has no valid aerospike object");
+        goto exit;
+    }
+
+    if (PHP_IS_CONN_NOT_ESTABLISHED(aerospike_obj_p->is_conn_16)) {
+        status = AEROSPIKE_ERR_CLUSTER;
+        DEBUG_PHP_EXT_ERROR("Aerospike::queryIterator() has no connection to the database");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_CLUSTER,
+                "Aerospike::queryIterator() has no connection to the database");
+        goto exit;
+    }
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "ssa!|a!a!",
+        &ns_p, &ns_p_length, &set_p, &set_p_length, &predicate_p,
+        &bins_p, &options_p) == FAILURE) {
+        status = AEROSPIKE_ERR_PARAM;
+        DEBUG_PHP_EXT_ERROR("Aerospike::queryIterator() unable to parse parameters");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Aerospike::queryIterator() unable to parse parameters");
+        goto exit;
+    }
+
+    if (ns_p_length == 0 || set_p_length == 0) {
+        status = AEROSPIKE_ERR_PARAM;
+        DEBUG_PHP_EXT_ERROR("Aerospike::queryIterator() expects parameter 1 & 2 to be a non-empty strings.");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM,
+                "Aerospike::queryIterator() expects parameter 1 & 2 to be a non-empty strings.");
+        goto exit;
+    }
+
+    if (AEROSPIKE_OK !=
+            (status = aerospike_query_stream(aerospike_obj_p->as_ref_p->as_p,
+                                          &error, ns_p, set_p,
+                                          (bins_p ? Z_ARRVAL_P(bins_p) : NULL),
+                                          (predicate_p ? Z_ARRVAL_P(predicate_p) : NULL),
+                                          options_p, &stream_p TSRMLS_CC))) {
+        DEBUG_PHP_EXT_ERROR("queryIterator returned an error");
+        goto exit;
+    }
+
+    aerospike_iterator_init(return_value, getThis(), stream_p TSRMLS_CC);
+
+exit:
+    PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
+    aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
+    if (AEROSPIKE_OK != status) {
+        RETURN_NULL();
+    }
+}
+/* }}} */
+
 /* {{{ proto int Aerospike::scanApply( string ns, string set, string module, string function, array args, int &scan_id [, array options ] )
    Applies a record UDF to each record of a set using a background scan  */
 PHP_METHOD(Aerospike, scanApply)
@@ -2261,6 +2702,9 @@ PHP_METHOD(Aerospike, scanApply)
     zval*                  args_p = NULL;
     zval*                  options_p = NULL;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_SCAN);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -2345,6 +2789,298 @@ PHP_METHOD(Aerospike, scanApply)
         goto exit;
     }
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
+    PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
+    aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
+    RETURN_LONG(status);
+}
+/* }}} */
+
+/* {{{ proto int Aerospike::scanToFile ( string ns, string set, string path, int format, array &stats [, array select [, array options ]] )
+   Scans a set and writes its records to a file without invoking PHP per record */
+PHP_METHOD(Aerospike, scanToFile)
+{
+    as_status              status = AEROSPIKE_OK;
+    as_error               error;
+    Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    char                   *ns_p = NULL;
+    int                    ns_p_length = 0;
+    char                   *set_p = NULL;
+    int                    set_p_length = 0;
+    char                   *path_p = NULL;
+    int                    path_p_length = 0;
+    long                   format = FILE_FORMAT_NDJSON;
+    zval                   *stats_p = NULL;
+    zval                   *bins_p = NULL;
+    zval                   *options_p = NULL;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_SCAN);
+
+    as_error_init(&error);
+
+    if (!aerospike_obj_p) {
+        status = AEROSPIKE_ERR;
+        DEBUG_PHP_EXT_ERROR("Aerospike::scanToFile() has no valid aerospike object");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR, "Aerospike::scanToFile() has no valid aerospike object");
+        goto exit;
+    }
+
+    if (PHP_IS_CONN_NOT_ESTABLISHED(aerospike_obj_p->is_conn_16)) {
+        status = AEROSPIKE_ERR_CLUSTER;
+        DEBUG_PHP_EXT_ERROR("Aerospike::scanToFile() has no connection to the database");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_CLUSTER, "Aerospike::scanToFile() has no connection to the database");
+        goto exit;
+    }
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "sssl|za!a!",
+        &ns_p, &ns_p_length, &set_p, &set_p_length, &path_p, &path_p_length,
+        &format, &stats_p, &bins_p, &options_p) == FAILURE) {
+        status = AEROSPIKE_ERR_PARAM;
+        DEBUG_PHP_EXT_ERROR("Aerospike::scanToFile() unable to parse parameters");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Aerospike::scanToFile() unable to parse parameters");
+        goto exit;
+    }
+
+    if (ns_p_length == 0 || set_p_length == 0 || path_p_length == 0) {
+        status = AEROSPIKE_ERR_PARAM;
+        DEBUG_PHP_EXT_ERROR("Aerospike::scanToFile() expects parameter 1, 2 & 3 to be a non-empty strings.");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Aerospike::scanToFile() expects parameter 1, 2 & 3 to be a non-empty strings.");
+        goto exit;
+    }
+
+    if (stats_p) {
+        zval_dtor(stats_p);
+        array_init(stats_p);
+    }
+
+    if (AEROSPIKE_OK !=
+            (status = aerospike_scan_to_file(aerospike_obj_p->as_ref_p->as_p,
+                                     &error, ns_p, set_p, path_p, format, stats_p,
+                                     (bins_p ? Z_ARRVAL_P(bins_p) : NULL),
+                                     options_p TSRMLS_CC))) {
+        DEBUG_PHP_EXT_ERROR("scanToFile returned an error");
+        goto exit;
+    }
+
+exit:
+    AEROSPIKE_STATS_END(stats_call, status);
+    PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
+    aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
+    RETURN_LONG(status);
+}
+/* }}} */
+
+/* {{{ proto int Aerospike::importFile ( string path, string ns, string set, string key_field, int format [, array &stats [, array options [, callback progress_cb ]]] )
+   Writes the records of an NDJSON or CSV file into a set, with several writes in flight */
+PHP_METHOD(Aerospike, importFile)
+{
+    as_status              status = AEROSPIKE_OK;
+    as_error               error;
+    Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    char                   *path_p = NULL;
+    int                    path_p_length = 0;
+    char                   *ns_p = NULL;
+    int                    ns_p_length = 0;
+    char                   *set_p = NULL;
+    int                    set_p_length = 0;
+    char                   *key_field_p = NULL;
+    int                    key_field_p_length = 0;
+    long                   format = FILE_FORMAT_NDJSON;
+    zval                   *stats_p = NULL;
+    zval                   *options_p = NULL;
+    zend_fcall_info        fci = empty_fcall_info;
+    zend_fcall_info_cache  fcc = empty_fcall_info_cache;
+    userland_callback      progress;
+
+    as_error_init(&error);
+
+    if (!aerospike_obj_p) {
+        status = AEROSPIKE_ERR;
+        DEBUG_PHP_EXT_ERROR("Aerospike::importFile() has no valid aerospike object");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR, "Aerospike::importFile() has no valid aerospike object");
+        goto exit;
+    }
+
+    if (PHP_IS_CONN_NOT_ESTABLISHED(aerospike_obj_p->is_conn_16)) {
+        status = AEROSPIKE_ERR_CLUSTER;
+        DEBUG_PHP_EXT_ERROR("Aerospike::importFile() has no connection to the database");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_CLUSTER, "Aerospike::importFile() has no connection to the database");
+        goto exit;
+    }
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "ssssl|za!f",
+        &path_p, &path_p_length, &ns_p, &ns_p_length, &set_p, &set_p_length,
+        &key_field_p, &key_field_p_length, &format, &stats_p, &options_p,
+        &fci, &fcc) == FAILURE) {
+        status = AEROSPIKE_ERR_PARAM;
+        DEBUG_PHP_EXT_ERROR("Aerospike::importFile() unable to parse parameters");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Aerospike::importFile() unable to parse parameters");
+        goto exit;
+    }
+
+    if (path_p_length == 0 || ns_p_length == 0 || set_p_length == 0 || key_field_p_length == 0) {
+        status = AEROSPIKE_ERR_PARAM;
+        DEBUG_PHP_EXT_ERROR("Aerospike::importFile() expects parameters 1 to 4 to be a non-empty strings.");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Aerospike::importFile() expects parameters 1 to 4 to be a non-empty strings.");
+        goto exit;
+    }
+
+    progress.fci_p = &fci;
+    progress.fcc_p = &fcc;
+    progress.obj = aerospike_obj_p;
+
+    if (AEROSPIKE_OK !=
+            (status = aerospike_import_file(aerospike_obj_p->as_ref_p->as_p,
+                                     &error, path_p, ns_p, set_p, key_field_p,
+                                     format, stats_p, options_p,
+                                     (ZEND_FCI_INITIALIZED(fci) ? &progress : NULL)
+                                     TSRMLS_CC))) {
+        DEBUG_PHP_EXT_ERROR("importFile returned an error");
+        goto exit;
+    }
+
+exit:
+    PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
+    aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
+    RETURN_LONG(status);
+}
+/* }}} */
+
+/* {{{ proto int Aerospike::scanAggregate ( string ns, string set, array aggregations, array &result [, array options ] )
+   Scans a set and computes counts, sums, min/max, distinct counts and histograms over its bins in C */
+PHP_METHOD(Aerospike, scanAggregate)
+{
+    as_status              status = AEROSPIKE_OK;
+    as_error               error;
+    Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    char                   *ns_p = NULL;
+    int                    ns_p_length = 0;
+    char                   *set_p = NULL;
+    int                    set_p_length = 0;
+    zval                   *aggregations_p = NULL;
+    zval                   *result_p = NULL;
+    zval                   *options_p = NULL;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_SCAN);
+
+    as_error_init(&error);
+
+    if (!aerospike_obj_p) {
+        status = AEROSPIKE_ERR;
+        DEBUG_PHP_EXT_ERROR("Aerospike::scanAggregate() has no valid aerospike object");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR, "Aerospike::scanAggregate() has no valid aerospike object");
+        goto exit;
+    }
+
+    if (PHP_IS_CONN_NOT_ESTABLISHED(aerospike_obj_p->is_conn_16)) {
+        status = AEROSPIKE_ERR_CLUSTER;
+        DEBUG_PHP_EXT_ERROR("Aerospike::scanAggregate() has no connection to the database");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_CLUSTER, "Aerospike::scanAggregate() has no connection to the database");
+        goto exit;
+    }
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "ssaz|a",
+        &ns_p, &ns_p_length, &set_p, &set_p_length, &aggregations_p,
+        &result_p, &options_p) == FAILURE) {
+        status = AEROSPIKE_ERR_PARAM;
+        DEBUG_PHP_EXT_ERROR("Aerospike::scanAggregate() unable to parse parameters");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Aerospike::scanAggregate() unable to parse parameters");
+        goto exit;
+    }
+
+    if (ns_p_length == 0 || set_p_length == 0) {
+        status = AEROSPIKE_ERR_PARAM;
+        DEBUG_PHP_EXT_ERROR("Aerospike::scanAggregate() expects parameter 1 & 2 to be a non-empty strings.");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Aerospike::scanAggregate() expects parameter 1 & 2 to be a non-empty strings.");
+        goto exit;
+    }
+
+    zval_dtor(result_p);
+    array_init(result_p);
+
+    if (AEROSPIKE_OK !=
+            (status = aerospike_scan_reduce(aerospike_obj_p->as_ref_p->as_p,
+                                     &error, ns_p, set_p, Z_ARRVAL_P(aggregations_p),
+                                     result_p, options_p TSRMLS_CC))) {
+        DEBUG_PHP_EXT_ERROR("scanAggregate returned an error");
+        goto exit;
+    }
+
+exit:
+    AEROSPIKE_STATS_END(stats_call, status);
+    PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
+    aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
+    RETURN_LONG(status);
+}
+/* }}} */
+
+/* {{{ proto int Aerospike::queryAggregate ( string ns, string set, array where, array aggregations, array &result [, array options ] )
+   Queries a set and computes counts, sums, min/max, distinct counts and histograms over the matching records in C */
+PHP_METHOD(Aerospike, queryAggregate)
+{
+    as_status              status = AEROSPIKE_OK;
+    as_error               error;
+    Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    char                   *ns_p = NULL;
+    int                    ns_p_length = 0;
+    char                   *set_p = NULL;
+    int                    set_p_length = 0;
+    zval                   *predicate_p = NULL;
+    zval                   *aggregations_p = NULL;
+    zval                   *result_p = NULL;
+    zval                   *options_p = NULL;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_QUERY);
+
+    as_error_init(&error);
+
+    if (!aerospike_obj_p) {
+        status = AEROSPIKE_ERR;
+        DEBUG_PHP_EXT_ERROR("Aerospike::queryAggregate() has no valid aerospike object");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR, "Aerospike::queryAggregate() has no valid aerospike object");
+        goto exit;
+    }
+
+    if (PHP_IS_CONN_NOT_ESTABLISHED(aerospike_obj_p->is_conn_16)) {
+        status = AEROSPIKE_ERR_CLUSTER;
+        DEBUG_PHP_EXT_ERROR("Aerospike::queryAggregate() has no connection to the database");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_CLUSTER, "Aerospike::queryAggregate() has no connection to the database");
+        goto exit;
+    }
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "ssaaz|a",
+        &ns_p, &ns_p_length, &set_p, &set_p_length, &predicate_p,
+        &aggregations_p, &result_p, &options_p) == FAILURE) {
+        status = AEROSPIKE_ERR_PARAM;
+        DEBUG_PHP_EXT_ERROR("Aerospike::queryAggregate() unable to parse parameters");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Aerospike::queryAggregate() unable to parse parameters");
+        goto exit;
+    }
+
+    if (ns_p_length == 0 || set_p_length == 0) {
+        status = AEROSPIKE_ERR_PARAM;
+        DEBUG_PHP_EXT_ERROR("Aerospike::queryAggregate() expects parameter 1 & 2 to be a non-empty strings.");
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Aerospike::queryAggregate() expects parameter 1 & 2 to be a non-empty strings.");
+        goto exit;
+    }
+
+    zval_dtor(result_p);
+    array_init(result_p);
+
+    if (AEROSPIKE_OK !=
+            (status = aerospike_query_reduce(aerospike_obj_p->as_ref_p->as_p,
+                                     &error, ns_p, set_p, Z_ARRVAL_P(predicate_p),
+                                     Z_ARRVAL_P(aggregations_p), result_p,
+                                     options_p TSRMLS_CC))) {
+        DEBUG_PHP_EXT_ERROR("queryAggregate returned an error");
+        goto exit;
+    }
+
+exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
     aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
     RETURN_LONG(status);
@@ -2581,6 +3317,9 @@ PHP_METHOD(Aerospike, apply)
     int16_t                initializeKey = 0;
     zval*                  options_p = NULL;
     Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+    aerospike_stats_call   stats_call;
+
+    AEROSPIKE_STATS_BEGIN(stats_call, AEROSPIKE_STATS_OP_APPLY);
 
     if (!aerospike_obj_p) {
         status = AEROSPIKE_ERR;
@@ -2677,6 +3416,7 @@ PHP_METHOD(Aerospike, apply)
         goto exit;
     }
 exit:
+    AEROSPIKE_STATS_END(stats_call, status);
     if (initializeKey) {
         as_key_destroy(&as_key_for_apply_udf);
     }
@@ -3047,7 +3787,7 @@ PHP_METHOD(Aerospike, setLogHandler)
         RETURN_FALSE;
     }
 
-    as_log_set_callback((as_log_callback)&aerospike_helper_log_callback);
+    as_log_set_callback((as_log_callback)&aerospike_log_client_callback);
     is_callback_registered = 1;
     Z_ADDREF_P(func_call_info.function_name);
     PHP_EXT_RESET_AS_ERR_IN_CLASS();
@@ -3055,6 +3795,51 @@ PHP_METHOD(Aerospike, setLogHandler)
 }
 /* }}} */
 
+/* {{{ proto bool Aerospike::setTraceHandler( callback trace_handler [, float sample_rate=1.0 ] )
+   Sets a handler receiving a span for a sample of the API calls */
+PHP_METHOD(Aerospike, setTraceHandler)
+{
+    as_status              status = AEROSPIKE_OK;
+    as_error               error;
+    zend_fcall_info        trace_call_info = empty_fcall_info;
+    zend_fcall_info_cache  trace_call_info_cache = empty_fcall_info_cache;
+    double                 sample_rate = 1.0;
+    Aerospike_object*      aerospike_obj_p = PHP_AEROSPIKE_GET_OBJECT;
+
+    as_error_init(&error);
+
+    if (!aerospike_obj_p) {
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR, "Invalid aerospike object");
+        DEBUG_PHP_EXT_ERROR("Invalid aerospike object");
+        status = AEROSPIKE_ERR;
+        goto exit;
+    }
+
+    if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "f!|d",
+                &trace_call_info, &trace_call_info_cache, &sample_rate) == FAILURE) {
+        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_PARAM, "Unable to parse parameters for setTraceHandler");
+        DEBUG_PHP_EXT_ERROR("Unable to parse parameters for setTraceHandler");
+        status = AEROSPIKE_ERR_PARAM;
+        goto exit;
+    }
+
+    if (AEROSPIKE_OK !=
+            (status = aerospike_stats_trace_set(&trace_call_info,
+                    &trace_call_info_cache, sample_rate, &error TSRMLS_CC))) {
+        DEBUG_PHP_EXT_ERROR("setTraceHandler function returned an error");
+        goto exit;
+    }
+
+exit:
+    PHP_EXT_SET_AS_ERR_IN_CLASS(&error);
+    aerospike_helper_set_error(Aerospike_ce, getThis() TSRMLS_CC);
+    if (AEROSPIKE_OK != status) {
+        RETURN_FALSE;
+    }
+    RETURN_TRUE;
+}
+/* }}} */
+
 /*
  *******************************************************************************************************
  * Error handling APIs:
@@ -3126,6 +3911,10 @@ PHP_MINIT_FUNCTION(aerospike)
     EXPOSE_GENERAL_CONSTANTS_LONG_ZEND(Aerospike_ce);
     EXPOSE_GENERAL_CONSTANTS_STRING_ZEND(Aerospike_ce);
 
+    if (SUCCESS != aerospike_iterator_register_class(TSRMLS_C)) {
+        return FAILURE;
+    }
+
     php_session_register_module(&ps_mod_aerospike);
     return SUCCESS;
 }
@@ -3154,7 +3943,18 @@ PHP_MSHUTDOWN_FUNCTION(aerospike)
  */
 PHP_RINIT_FUNCTION(aerospike)
 {
-    /*** TO BE IMPLEMENTED ***/
+    /*
+     * Clusters listed in aerospike.preconnect are connected by the first
+     * request of each process rather than in MINIT, as the php-fpm master
+     * forks its workers after MINIT and the tend threads would not survive.
+     */
+    if (!AEROSPIKE_G(preconnected)) {
+        AEROSPIKE_G(preconnected) = true;
+        aerospike_helper_preconnect(TSRMLS_C);
+    }
+
+    /* a call cut short by a fatal error of the previous request left its timer */
+    AEROSPIKE_G(stats_call_g) = NULL;
 
     DEBUG_PHP_EXT_DEBUG("Inside rinit of this build");
     return SUCCESS;
@@ -3184,6 +3984,16 @@ PHP_RSHUTDOWN_FUNCTION(aerospike)
         }
     }
 
+    aerospike_stats_flush_slow_ops(TSRMLS_C);
+    aerospike_stats_trace_release(TSRMLS_C);
+    aerospike_log_drain(TSRMLS_C);
+
+    /*
+     * Objects still alive here hold their connection (ref_as_p > 0) and are
+     * never reaped; those freed later are reaped at a following RSHUTDOWN.
+     */
+    aerospike_helper_reap_persistent(TSRMLS_C);
+
     DEBUG_PHP_EXT_DEBUG("Inside rshutdown of this build");
     return SUCCESS;
 }
@@ -3193,11 +4003,120 @@ PHP_RSHUTDOWN_FUNCTION(aerospike)
  * Aerospike module info.
  ********************************************************************
  */
+/*
+ * Formats a value of Aerospike::runtimeInfo() for a phpinfo() row; an
+ * array is listed as its key=value pairs.
+ */
+static void
+aerospike_minfo_value(zval *value_p, char *buf_p, size_t size)
+{
+    HashPosition    pos;
+    zval            **entry_pp = NULL;
+    char            *key_p = NULL;
+    uint            key_len = 0;
+    ulong           index = 0;
+    size_t          len = 0;
+    zval            copy;
+
+    buf_p[0] = '\0';
+    if (Z_TYPE_P(value_p) != IS_ARRAY) {
+        copy = *value_p;
+        zval_copy_ctor(&copy);
+        convert_to_string(&copy);
+        snprintf(buf_p, size, "%s", Z_STRVAL(copy));
+        zval_dtor(&copy);
+        return;
+    }
+
+    for (zend_hash_internal_pointer_reset_ex(Z_ARRVAL_P(value_p), &pos);
+            len < size && zend_hash_get_current_data_ex(Z_ARRVAL_P(value_p),
+                (void **) &entry_pp, &pos) == SUCCESS;
+            zend_hash_move_forward_ex(Z_ARRVAL_P(value_p), &pos)) {
+        if (Z_TYPE_PP(entry_pp) == IS_ARRAY ||
+                zend_hash_get_current_key_ex(Z_ARRVAL_P(value_p), &key_p,
+                    &key_len, &index, 0, &pos) != HASH_KEY_IS_STRING) {
+            continue;
+        }
+        copy = **entry_pp;
+        zval_copy_ctor(&copy);
+        convert_to_string(&copy);
+        len += snprintf(buf_p + len, size - len, "%s%s=%s", len ? ", " : "",
+                key_p, Z_STRVAL(copy));
+        zval_dtor(&copy);
+    }
+}
+
 PHP_MINFO_FUNCTION(aerospike)
 {
+    zval            *info_p = NULL;
+    zval            **section_pp = NULL;
+    zval            **entry_pp = NULL;
+    HashPosition    section_pos;
+    HashPosition    entry_pos;
+    char            *section_key_p = NULL;
+    char            *entry_key_p = NULL;
+    uint            key_len = 0;
+    ulong           index = 0;
+    char            name[64];
+    char            value[1024];
+
     php_info_print_table_start();
     php_info_print_table_row(2, "aerospike support", "enabled");
     php_info_print_table_row(2, "aerospike version", PHP_AEROSPIKE_VERSION);
     php_info_print_table_end();
+
+    DISPLAY_INI_ENTRIES();
+
+    MAKE_STD_ZVAL(info_p);
+    array_init(info_p);
+    aerospike_info_runtime(info_p TSRMLS_CC);
+
+    for (zend_hash_internal_pointer_reset_ex(Z_ARRVAL_P(info_p), &section_pos);
+            zend_hash_get_current_data_ex(Z_ARRVAL_P(info_p),
+                (void **) &section_pp, &section_pos) == SUCCESS;
+            zend_hash_move_forward_ex(Z_ARRVAL_P(info_p), &section_pos)) {
+        if (Z_TYPE_PP(section_pp) != IS_ARRAY ||
+                zend_hash_get_current_key_ex(Z_ARRVAL_P(info_p), &section_key_p,
+                    &key_len, &index, 0, &section_pos) != HASH_KEY_IS_STRING) {
+            continue;
+        }
+
+        php_info_print_table_start();
+        php_info_print_table_header(2, section_key_p, "");
+        for (zend_hash_internal_pointer_reset_ex(Z_ARRVAL_PP(section_pp), &entry_pos);
+                zend_hash_get_current_data_ex(Z_ARRVAL_PP(section_pp),
+                    (void **) &entry_pp, &entry_pos) == SUCCESS;
+                zend_hash_move_forward_ex(Z_ARRVAL_PP(section_pp), &entry_pos)) {
+            if (zend_hash_get_current_key_ex(Z_ARRVAL_PP(section_pp), &entry_key_p,
+                        &key_len, &index, 0, &entry_pos) == HASH_KEY_IS_STRING) {
+                snprintf(name, sizeof(name), "%s", entry_key_p);
+            } else {
+                snprintf(name, sizeof(name), "%lu", index);
+            }
+
+            /* the persistent clients are listed one row each */
+            if (Z_TYPE_PP(entry_pp) == IS_ARRAY && !strcmp(name, "clients")) {
+                zval        **client_pp = NULL;
+                HashPosition client_pos;
+                uint32_t    client = 0;
+
+                for (zend_hash_internal_pointer_reset_ex(Z_ARRVAL_PP(entry_pp), &client_pos);
+                        zend_hash_get_current_data_ex(Z_ARRVAL_PP(entry_pp),
+                            (void **) &client_pp, &client_pos) == SUCCESS;
+                        zend_hash_move_forward_ex(Z_ARRVAL_PP(entry_pp), &client_pos)) {
+                    snprintf(name, sizeof(name), "client %u", client++);
+                    aerospike_minfo_value(*client_pp, value, sizeof(value));
+                    php_info_print_table_row(2, name, value);
+                }
+                continue;
+            }
+
+            aerospike_minfo_value(*entry_pp, value, sizeof(value));
+            php_info_print_table_row(2, name, value);
+        }
+        php_info_print_table_end();
+    }
+
+    zval_ptr_dtor(&info_p);
 }
 
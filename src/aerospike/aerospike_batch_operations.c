@@ -196,8 +196,9 @@ aerospike_batch_operations_exists_many(aerospike* as_object_p, as_error* error_p
     metadata_callback.udata_p = metadata_p;
     metadata_callback.error_p = error_p;
 
-    if (AEROSPIKE_OK != (status = aerospike_batch_exists(as_object_p, error_p,
-                    &batch_policy, &batch, batch_exists_cb, &metadata_callback))) {
+    if (AEROSPIKE_OK != (status = AEROSPIKE_STATS_NET(as_object_p, NULL, NULL, NULL, 0,
+                    aerospike_batch_exists(as_object_p, error_p,
+                        &batch_policy, &batch, batch_exists_cb, &metadata_callback)))) {
         DEBUG_PHP_EXT_DEBUG("Unable to get metadata of batch records");
         goto exit;
     }
@@ -401,16 +402,18 @@ aerospike_batch_operations_get_many(aerospike* as_object_p, as_error* error_p,
         filter_bins_count = zend_hash_num_elements(Z_ARRVAL_P(filter_bins_p));
         const char*                       select_p[filter_bins_count];
         process_filer_bins(Z_ARRVAL_P(filter_bins_p), select_p TSRMLS_CC);
-        if (AEROSPIKE_OK != aerospike_batch_get_bins(as_object_p, error_p, &batch_policy,
-                    &batch, select_p, filter_bins_count,
-                    (aerospike_batch_read_callback) batch_get_cb,
-                    &batch_get_callback_udata)) {
+        if (AEROSPIKE_OK != AEROSPIKE_STATS_NET(as_object_p, NULL, NULL, NULL, filter_bins_count,
+                    aerospike_batch_get_bins(as_object_p, error_p, &batch_policy,
+                        &batch, select_p, filter_bins_count,
+                        (aerospike_batch_read_callback) batch_get_cb,
+                        &batch_get_callback_udata))) {
             DEBUG_PHP_EXT_DEBUG("Unable to get batch records");
             goto exit;
         }
-    } else if (AEROSPIKE_OK != aerospike_batch_get(as_object_p, error_p, &batch_policy,
-                &batch, (aerospike_batch_read_callback) batch_get_cb,
-                &batch_get_callback_udata)) {
+    } else if (AEROSPIKE_OK != AEROSPIKE_STATS_NET(as_object_p, NULL, NULL, NULL, 0,
+                aerospike_batch_get(as_object_p, error_p, &batch_policy,
+                    &batch, (aerospike_batch_read_callback) batch_get_cb,
+                    &batch_get_callback_udata))) {
         DEBUG_PHP_EXT_DEBUG("Unable to get batch records");
         goto exit;
     }
@@ -0,0 +1,168 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "php.h"
+#include "php_aerospike.h"
+#include "aerospike/as_log.h"
+#include "aerospike/as_error.h"
+#include "aerospike/as_status.h"
+#include "aerospike/as_record.h"
+#include "aerospike/as_buffer.h"
+#include "aerospike/as_serializer.h"
+#include "aerospike/as_msgpack.h"
+#include "aerospike_common.h"
+#include "aerospike_policy.h"
+
+#ifdef AEROSPIKE_BENCH
+
+/*
+ *******************************************************************************************************
+ * Offline benchmark of the transform layer, built with
+ * --enable-aerospike-bench and run by examples/performance/transform-bench.php.
+ * A PHP record is round-tripped the way put() and get() do it, minus the
+ * network: AS_DEFAULT_PUT into an as_record, then AS_DEFAULT_GET back into
+ * a PHP array. No cluster is needed.
+ *******************************************************************************************************
+ */
+typedef struct aerospike_bench_totals_s {
+    uint64_t    put_ns;
+    uint64_t    get_ns;
+    uint64_t    mem_bytes;
+} aerospike_bench_totals;
+
+/*
+ *******************************************************************************************************
+ * Sums the msgpack encoded size of the bins of a record, i.e. the payload
+ * the record would put on the wire.
+ *******************************************************************************************************
+ */
+static bool
+bench_bin_size(const char *name_p, const as_val *val_p, void *udata_p)
+{
+    as_serializer   serializer;
+    as_buffer       buffer;
+
+    as_msgpack_init(&serializer);
+    as_buffer_init(&buffer);
+    if (0 == as_serializer_serialize(&serializer, (as_val *) val_p, &buffer)) {
+        *((uint64_t *) udata_p) += buffer.size;
+    }
+    as_buffer_destroy(&buffer);
+    as_serializer_destroy(&serializer);
+    return true;
+}
+
+/*
+ *******************************************************************************************************
+ * One round trip. Kept in a function of its own, as the record is
+ * allocated on the stack as in aerospike_transform_key_data_put().
+ *******************************************************************************************************
+ */
+static void
+bench_round_trip(zval *bins_p, uint32_t serializer_policy,
+        aerospike_bench_totals *totals_p, uint64_t *wire_bytes_p,
+        as_error *error_p TSRMLS_DC)
+{
+    as_static_pool              static_pool = {0};
+    as_record                   record;
+    zval                        *record_p = NULL;
+    foreach_callback_udata      udata;
+    size_t                      mem_before = zend_memory_usage(0 TSRMLS_CC);
+    uint64_t                    begin_ns = aerospike_stats_now_ns();
+    uint64_t                    put_ns = 0;
+
+    as_record_inita(&record, zend_hash_num_elements(Z_ARRVAL_P(bins_p)));
+    aerospike_transform_iterate_records(&bins_p, &record, &static_pool,
+            serializer_policy, error_p TSRMLS_CC);
+    put_ns = aerospike_stats_now_ns();
+    if (AEROSPIKE_OK != error_p->code) {
+        goto exit;
+    }
+
+    MAKE_STD_ZVAL(record_p);
+    array_init(record_p);
+    udata.udata_p = record_p;
+    udata.error_p = error_p;
+    udata.obj = NULL;
+    if (!as_record_foreach(&record, (as_rec_foreach_callback) AS_DEFAULT_GET, &udata)) {
+        if (AEROSPIKE_OK == error_p->code) {
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
+                    "Unable to read the record back");
+        }
+        DEBUG_PHP_EXT_DEBUG("Unable to read the record back");
+        goto exit;
+    }
+
+    totals_p->get_ns += aerospike_stats_now_ns() - put_ns;
+    totals_p->put_ns += put_ns - begin_ns;
+    totals_p->mem_bytes += zend_memory_usage(0 TSRMLS_CC) - mem_before;
+    if (wire_bytes_p) {
+        as_record_foreach(&record, bench_bin_size, wire_bytes_p);
+    }
+
+exit:
+    if (record_p) {
+        zval_ptr_dtor(&record_p);
+    }
+    as_record_destroy(&record);
+    aerospike_helper_free_static_pool(&static_pool);
+}
+
+/*
+ *******************************************************************************************************
+ * Round-trips a record through the transform layer and reports the average
+ * cost per round trip.
+ *
+ * @param bins_p            The PHP record (bin name => value).
+ * @param iterations        The number of timed round trips.
+ * @param serializer_policy The SERIALIZER_* used for unsupported types.
+ * @param return_p          An initialized array zval to be populated.
+ * @param error_p           The as_error to be populated by the function
+ *                          with the encountered error if any.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+extern as_status
+aerospike_bench_transform(zval *bins_p, long iterations,
+        uint32_t serializer_policy, zval *return_p, as_error *error_p TSRMLS_DC)
+{
+    aerospike_bench_totals      totals = {0};
+    uint64_t                    wire_bytes = 0;
+    long                        i = 0;
+
+    if (iterations <= 0) {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                "The number of iterations must be positive");
+        DEBUG_PHP_EXT_DEBUG("The number of iterations must be positive");
+        goto exit;
+    }
+
+    /* warm-up, which also sizes the payload */
+    bench_round_trip(bins_p, serializer_policy, &totals, &wire_bytes, error_p TSRMLS_CC);
+    if (AEROSPIKE_OK != error_p->code) {
+        goto exit;
+    }
+
+    memset(&totals, 0, sizeof(totals));
+    for (i = 0; i < iterations && AEROSPIKE_OK == error_p->code; i++) {
+        bench_round_trip(bins_p, serializer_policy, &totals, NULL, error_p TSRMLS_CC);
+    }
+    if (AEROSPIKE_OK != error_p->code) {
+        goto exit;
+    }
+
+    add_assoc_long(return_p, "iterations", iterations);
+    add_assoc_long(return_p, "bins", (long) zend_hash_num_elements(Z_ARRVAL_P(bins_p)));
+    add_assoc_long(return_p, "put_ns", (long) (totals.put_ns / iterations));
+    add_assoc_long(return_p, "get_ns", (long) (totals.get_ns / iterations));
+    add_assoc_long(return_p, "ns_per_op", (long) ((totals.put_ns + totals.get_ns) / iterations));
+    add_assoc_long(return_p, "wire_bytes", (long) wire_bytes);
+    add_assoc_long(return_p, "mem_bytes_per_op", (long) (totals.mem_bytes / iterations));
+
+exit:
+    return error_p->code;
+}
+
+#endif
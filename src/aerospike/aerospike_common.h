@@ -1,12 +1,22 @@
 #ifndef __AEROSPIKE_COMMON_H__
 #define __AEROSPIKE_COMMON_H__
+
+/* the --enable/--disable-aerospike-* switches of config.m4 land in config.h */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include "aerospike/as_arraylist.h"
 #include "aerospike/as_hashmap.h"
 #include "aerospike/as_key.h"
 #include "aerospike/as_record.h"
+#include "aerospike/as_cluster.h"
 #include "aerospike/as_node.h"
 #include "aerospike/as_operations.h"
+#include "aerospike/as_policy.h"
 #include "aerospike/as_record.h"
+#include "aerospike/as_scan.h"
+#include "aerospike/as_query.h"
 
 /*
  *******************************************************************************************************
@@ -58,12 +68,13 @@
 
 /*
  *******************************************************************************************************
- * MACRO TO RETRIEVE THE PHP INI ENTRIES FOR LUA SYSTEM AND USER PATHS IF
- * SPECIFIED, ELSE RETURN DEFAULTS.
+ * MACRO TO RETRIEVE THE PHP INI ENTRIES FOR LUA SYSTEM AND USER PATHS AND THE
+ * LUA STATE CACHE IF SPECIFIED, ELSE RETURN DEFAULTS.
  *******************************************************************************************************
  */
 #define LUA_SYSTEM_PATH_PHP_INI INI_STR("aerospike.udf.lua_system_path") ? INI_STR("aerospike.udf.lua_system_path") : ""
 #define LUA_USER_PATH_PHP_INI INI_STR("aerospike.udf.lua_user_path") ? INI_STR("aerospike.udf.lua_user_path") : ""
+#define LUA_CACHE_ENABLED_PHP_INI INI_BOOL("aerospike.udf.lua_cache_enabled") ? INI_BOOL("aerospike.udf.lua_cache_enabled") : false
 
 /*
  *******************************************************************************************************
@@ -76,6 +87,32 @@
 #define SHM_MAX_NAMESPACES_PHP_INI INI_INT("aerospike.shm.max_namespaces") ? INI_INT("aerospike.shm.max_namespaces") : 8
 #define SHM_TAKEOVER_THRESHOLD_SEC_PHP_INI INI_INT("aerospike.shm.takeover_threshold_sec") ? INI_INT("aerospike.shm.takeover_threshold_sec") : 30
 
+/*
+ *******************************************************************************************************
+ * MACRO TO RETRIEVE THE PHP INI ENTRIES FOR PRECONNECTED CLUSTERS IF
+ * SPECIFIED, ELSE RETURN DEFAULTS.
+ *******************************************************************************************************
+ */
+#define PRECONNECT_PHP_INI INI_STR("aerospike.preconnect") ? INI_STR("aerospike.preconnect") : NULL
+#define PRECONNECT_SOCKETS_PHP_INI INI_INT("aerospike.preconnect_sockets") ? INI_INT("aerospike.preconnect_sockets") : 0
+
+/*
+ *******************************************************************************************************
+ * MACRO TO RETRIEVE THE PHP INI ENTRY FOR THE LOG FILE, WHICH ALSO RECEIVES
+ * THE SLOW OPERATIONS, IF SPECIFIED, ELSE RETURN DEFAULTS.
+ *******************************************************************************************************
+ */
+#define LOG_PATH_PHP_INI INI_STR("aerospike.log_path") ? INI_STR("aerospike.log_path") : NULL
+
+/*
+ *******************************************************************************************************
+ * MACRO TO RETRIEVE THE PHP INI ENTRIES FOR THE IDLE TIMEOUT AND MAXIMUM AGE
+ * OF PERSISTENT CONNECTIONS IF SPECIFIED, ELSE RETURN DEFAULTS (0, NEVER).
+ *******************************************************************************************************
+ */
+#define PERSISTENT_IDLE_TIMEOUT_SEC_PHP_INI INI_INT("aerospike.persistent.idle_timeout_sec") ? INI_INT("aerospike.persistent.idle_timeout_sec") : 0
+#define PERSISTENT_MAX_AGE_SEC_PHP_INI INI_INT("aerospike.persistent.max_age_sec") ? INI_INT("aerospike.persistent.max_age_sec") : 0
+
 /*
  *******************************************************************************************************
  * MACRO TO RETRIEVE THE PHP INI ENTRIES FOR SESSION HANDLER IF
@@ -88,6 +125,7 @@
 
 #define AEROSPIKE_SESSION "aerospike"
 #define AEROSPIKE_SESSION_LEN 9
+#define AEROSPIKE_SESSION_DIGEST_SIZE 16
 
 /* 
  *******************************************************************************************************
@@ -183,8 +221,40 @@ typedef struct csdk_aerospike_obj {
      * persistent_list hashtable.
      */
     int ref_hosts_entry;
+
+    /*
+     * created and last_used are the times the persistent C SDK aerospike
+     * object was created and last held by a PHP userland Aerospike object,
+     * for the idle timeout and maximum age of persistent connections.
+     */
+    time_t created;
+    time_t last_used;
+
+    /*
+     * shm_owner_pid is the last observed PID of the process tending the
+     * shared memory cluster map and shm_takeovers counts how often it was
+     * seen to change, i.e. another process took the tending over.
+     */
+    uint32_t shm_owner_pid;
+    uint32_t shm_takeovers;
+
+    /*
+     * config_key_p is the normalised config the persistent C SDK aerospike
+     * object was built from, its alias in the persistent list and what a
+     * registry hit is confirmed against.
+     */
+    char *config_key_p;
+    size_t config_key_len;
 } aerospike_ref;
 
+/*
+ *******************************************************************************************************
+ * Registry of the persistent aerospike_refs, keyed by a hash of their
+ * as_config (see aerospike_helper.c).
+ *******************************************************************************************************
+ */
+typedef struct aerospike_registry_s aerospike_registry;
+
 /*
  *******************************************************************************************************
  * Structure to map the zend Aerospike object with the C client's aerospike object ref structure.
@@ -195,6 +265,7 @@ typedef struct Aerospike_object {
     bool is_persistent;
     aerospike_ref *as_ref_p;
     u_int16_t is_conn_16;
+    struct AerospikeIterator_object *iterators_p;
 #ifdef ZTS
     void ***ts;
 #endif
@@ -203,12 +274,31 @@ typedef struct Aerospike_object {
 /* 
  *******************************************************************************************************
  * Structure containing session info of Aerospike_object.
+ * One is cached per session.save_path for the lifetime of the process, its
+ * read_* fields are reset by each session close.
  *******************************************************************************************************
  */
 typedef struct aerospike_session_t {
     Aerospike_object    *aerospike_obj_p;
     char                ns_p[AS_NAMESPACE_MAX_SIZE];
     char                set_p[AS_SET_MAX_SIZE];
+    uint32_t            lazy_touch_sec;
+    bool                read_touch;
+    uint32_t            read_timeout_ms;
+    uint32_t            write_timeout_ms;
+    as_policy_replica   replica;
+    bool                check_gen;
+    bool                merge_on_conflict;
+    bool                bytes_encoding;
+    uint32_t            compress_threshold;
+    /* What the read of this request returned, for the write to compare */
+    char                *read_id_p;
+    char                *read_data_p;
+    bool                read_found;
+    uint32_t            read_ttl;
+    uint16_t            read_gen;
+    size_t              read_len;
+    unsigned char       read_digest[AEROSPIKE_SESSION_DIGEST_SIZE];
 } aerospike_session;
 
 /*
@@ -279,6 +369,100 @@ typedef struct _userland_callback {
     Aerospike_object *obj;
 } userland_callback;
 
+/*
+ *******************************************************************************************************
+ * Record stream used to hand scan/query records from the C client's threads
+ * over to the PHP thread through a bounded ring (see aerospike_stream.c).
+ *******************************************************************************************************
+ */
+#define AEROSPIKE_STREAM_DEFAULT_CAPACITY 256
+typedef struct aerospike_stream_s aerospike_stream;
+
+/*
+ *******************************************************************************************************
+ * Built-in reducers of scanAggregate()/queryAggregate(), computed in C on the
+ * records of a scan/query (see aerospike_reduce.c).
+ *******************************************************************************************************
+ */
+typedef struct aerospike_reducer_s aerospike_reducer;
+
+/*
+ *******************************************************************************************************
+ * Client-side latency statistics of the API calls, recorded per operation
+ * type in log-bucketed histograms (see aerospike_stats.c). Compiled out when
+ * the extension is configured with --disable-aerospike-stats.
+ *******************************************************************************************************
+ */
+enum aerospike_stats_op {
+    AEROSPIKE_STATS_OP_GET,
+    AEROSPIKE_STATS_OP_PUT,
+    AEROSPIKE_STATS_OP_REMOVE,
+    AEROSPIKE_STATS_OP_OPERATE,
+    AEROSPIKE_STATS_OP_APPLY,
+    AEROSPIKE_STATS_OP_BATCH,
+    AEROSPIKE_STATS_OP_SCAN,
+    AEROSPIKE_STATS_OP_QUERY,
+    AEROSPIKE_STATS_OP_COUNT
+};
+
+typedef struct aerospike_stats_s aerospike_stats;
+
+/*
+ * An API call being timed. Calls nest (a scan callback may call get()), so
+ * each call remembers the one it interrupted. net_ns accumulates the time
+ * spent in the C client; the namespace, set, digest and bin count are only
+ * copied once the call is already slower than aerospike.slow_op_threshold_ms.
+ * A call sampled for tracing also keeps its wall-clock start, its first and
+ * last calls into the C client, and the client and replica its key was sent
+ * with, to name its node once it is done.
+ */
+typedef struct aerospike_stats_call_s {
+    int                             op;
+    uint64_t                        begin_ns;
+    uint64_t                        net_begin_ns;
+    uint64_t                        net_ns;
+    bool                            has_target;
+    bool                            has_digest;
+    uint32_t                        bins;
+    char                            ns[AS_NAMESPACE_MAX_SIZE];
+    char                            set[AS_SET_MAX_SIZE];
+    uint8_t                         digest[AS_DIGEST_VALUE_SIZE];
+    bool                            traced;
+    uint64_t                        start_us;
+    uint64_t                        net_first_ns;
+    uint64_t                        net_last_ns;
+    aerospike                       *as_p;
+    as_policy_replica               replica;
+    struct aerospike_stats_call_s   *prev_p;
+} aerospike_stats_call;
+
+/*
+ * AEROSPIKE_STATS_NET() evaluates a call into the C client of as_p, timing
+ * it as network time of the current API call, and yields its status. key_p
+ * or ns_p and set_p, and bins, describe the records it reads or writes; a
+ * call with a key is also counted against the partition of the key.
+ * AEROSPIKE_STATS_NET_READ() does the same for a read sent with the given
+ * replica policy. The call is an argument of aerospike_stats_net_end(),
+ * which returns its status, so it runs between the two.
+ */
+#ifndef AEROSPIKE_NO_STATS
+#define AEROSPIKE_STATS_BEGIN(call, stats_op) aerospike_stats_begin(&(call), (stats_op) TSRMLS_CC)
+#define AEROSPIKE_STATS_END(call, status) aerospike_stats_end(&(call), (status) TSRMLS_CC)
+#define AEROSPIKE_STATS_NET(as_p, key_p, ns_p, set_p, bins, call)           \
+    (aerospike_stats_net_begin((as_p) TSRMLS_CC),                           \
+     aerospike_stats_net_end((key_p), (ns_p), (set_p),                      \
+            AS_POLICY_REPLICA_MASTER, (bins), (call) TSRMLS_CC))
+#define AEROSPIKE_STATS_NET_READ(as_p, key_p, replica, bins, call)          \
+    (aerospike_stats_net_begin((as_p) TSRMLS_CC),                           \
+     aerospike_stats_net_end((key_p), NULL, NULL, (replica), (bins),        \
+            (call) TSRMLS_CC))
+#else
+#define AEROSPIKE_STATS_BEGIN(call, stats_op) ((void) &(call))
+#define AEROSPIKE_STATS_END(call, status) ((void) &(call))
+#define AEROSPIKE_STATS_NET(as_p, key_p, ns_p, set_p, bins, call) (call)
+#define AEROSPIKE_STATS_NET_READ(as_p, key_p, replica, bins, call) (call)
+#endif
+
 /*
  *******************************************************************************************************
  * Decision Structure for as_config/zval to be populated by
@@ -316,7 +500,24 @@ extern bool
 aerospike_helper_log_callback(as_log_level level, const char * func TSRMLS_DC, const char * file, uint32_t line, const char * fmt, ...);
 extern int parseLogParameters(as_log *as_log_p);
 extern bool
-aerospike_helper_record_stream_callback(const as_val* p_val, void* udata);
+aerospike_log_client_callback(as_log_level level, const char *func,
+        const char *file, uint32_t line, const char *fmt, ...);
+extern void
+aerospike_log_queue(as_log_level level, const char *func, const char *file,
+        uint32_t line, const char *fmt, va_list ap);
+extern void
+aerospike_log_drain(TSRMLS_D);
+extern uint64_t
+aerospike_log_dropped_count(void);
+extern as_status
+aerospike_helper_record_stream_to_zval(as_record* current_as_rec,
+        zval* outer_container_p TSRMLS_DC);
+extern bool
+aerospike_helper_record_stream_call(zval* arg_p,
+        userland_callback* user_func_p TSRMLS_DC);
+extern bool
+aerospike_helper_record_stream_dispatch(as_record* current_as_rec,
+        userland_callback* user_func_p TSRMLS_DC);
 extern bool
 aerospike_helper_aggregate_callback(const as_val* val_p, void* udata_p);
 extern bool
@@ -472,6 +673,13 @@ extern as_status
 aerospike_transform_check_and_set_config(HashTable* ht_p, zval** retdata_pp,
         void* config_p);
 
+extern void
+aerospike_transform_iterate_records(zval **record_pp,
+                                    as_record* as_record_p,
+                                    as_static_pool* static_pool,
+                                    uint32_t serializer_policy,
+                                    as_error *error_p TSRMLS_DC);
+
 extern as_status
 aerospike_transform_key_data_put(aerospike* as_object_p,
                                  zval **record_pp,
@@ -556,6 +764,18 @@ extern void
 get_generation_value(zval* options_p, uint16_t* generation_value_p,
         as_error *error_p TSRMLS_DC);
 
+extern void
+get_stream_buffer_size(zval* options_p, uint32_t* buffer_size_p,
+        as_error *error_p TSRMLS_DC);
+
+extern void
+get_callback_batch_size(zval* options_p, uint32_t* batch_size_p,
+        as_error *error_p TSRMLS_DC);
+
+extern void
+get_import_concurrency(zval* options_p, uint32_t* concurrency_p,
+        as_error *error_p TSRMLS_DC);
+
 /*
  *******************************************************************************************************
  * Extern declarations of helper functions.
@@ -565,6 +785,18 @@ extern void
 aerospike_helper_set_error(zend_class_entry *ce_p,
                            zval *object_p TSRMLS_DC);
 
+extern void
+aerospike_helper_registry_destroy(aerospike_registry **registry_pp);
+
+extern void
+aerospike_helper_preconnect(TSRMLS_D);
+
+extern void
+aerospike_helper_reap_persistent(TSRMLS_D);
+
+extern void
+aerospike_helper_persistent_info(zval *return_p TSRMLS_DC);
+
 extern as_status
 aerospike_helper_object_from_alias_hash(Aerospike_object* as_object_p,
                                         bool persist_flag,
@@ -621,6 +853,11 @@ aerospike_get_registered_udf_module_code(Aerospike_object* aerospike_obj_p,
  ******************************************************************************************************
  */
 extern as_status
+aerospike_scan_stream(aerospike* as_object_p, as_error* error_p,
+        char* namespace_p, char* set_p, HashTable* bins_ht_p,
+        zval* options_p, aerospike_stream** stream_pp TSRMLS_DC);
+
+extern as_status
 aerospike_scan_run(aerospike* as_object_p, as_error* error_p,
         char* namespace_p, char* set_p, userland_callback* user_func_p,
         HashTable* bins_ht_p, zval* options_p TSRMLS_DC);
@@ -634,12 +871,46 @@ extern as_status
 aerospike_scan_get_info(aerospike* as_object_p, as_error* error_p,
         uint64_t scan_id, zval* scan_info_p, zval* options_p TSRMLS_DC);
 
+extern as_status
+aerospike_scan_to_file(aerospike* as_object_p, as_error* error_p,
+        char* namespace_p, char* set_p, char* path_p, long format,
+        zval* stats_p, HashTable* bins_ht_p, zval* options_p TSRMLS_DC);
+
+extern as_status
+aerospike_scan_reduce(aerospike* as_object_p, as_error* error_p,
+        char* namespace_p, char* set_p, HashTable* aggregations_ht_p,
+        zval* result_p, zval* options_p TSRMLS_DC);
+
+/*
+ ******************************************************************************************************
+ * Extern declarations of session handler functions.
+ ******************************************************************************************************
+ */
+extern void
+aerospike_session_cache_destroy(TSRMLS_D);
+
+/*
+ ******************************************************************************************************
+ * Extern declarations of import functions.
+ ******************************************************************************************************
+ */
+extern as_status
+aerospike_import_file(aerospike* as_object_p, as_error* error_p, char* path_p,
+        char* namespace_p, char* set_p, char* key_field_p, long format,
+        zval* stats_p, zval* options_p, userland_callback* progress_p TSRMLS_DC);
+
 /*
  ******************************************************************************************************
  * Extern declarations of query functions.
  ******************************************************************************************************
  */
 extern as_status
+aerospike_query_stream(aerospike* as_object_p, as_error* error_p,
+        char* namespace_p, char* set_p, HashTable* bins_ht_p,
+        HashTable* predicate_ht_p, zval* options_p,
+        aerospike_stream** stream_pp TSRMLS_DC);
+
+extern as_status
 aerospike_query_run(aerospike* as_object_p, as_error* error_p, char* namespace_p,
         char* set_p, userland_callback* user_func_p, HashTable* bins_ht_p,
         HashTable* predicate_ht_p, zval* options_p TSRMLS_DC);
@@ -650,6 +921,144 @@ aerospike_query_aggregate(aerospike* as_object_p, as_error* error_p,
         char* namespace_p, char* set_p, HashTable* bins_ht_p,
         HashTable* predicate_ht_p, zval* return_value_p, zval* options_p TSRMLS_DC);
 
+extern as_status
+aerospike_query_reduce(aerospike* as_object_p, as_error* error_p,
+        char* namespace_p, char* set_p, HashTable* predicate_ht_p,
+        HashTable* aggregations_ht_p, zval* result_p, zval* options_p TSRMLS_DC);
+
+/*
+ ******************************************************************************************************
+ * Extern declarations of reducer functions.
+ ******************************************************************************************************
+ */
+extern aerospike_reducer*
+aerospike_reducer_create(HashTable *aggregations_ht_p, as_error *error_p TSRMLS_DC);
+
+extern const char*
+aerospike_reducer_bin(aerospike_reducer *reducer_p, uint32_t i);
+
+extern bool
+aerospike_reducer_callback(const as_val *val_p, void *udata_p);
+
+extern as_status
+aerospike_reducer_result(aerospike_reducer *reducer_p, zval *result_p,
+        as_error *error_p TSRMLS_DC);
+
+extern void
+aerospike_reducer_destroy(aerospike_reducer *reducer_p);
+
+/*
+ ******************************************************************************************************
+ * Extern declarations of statistics functions.
+ ******************************************************************************************************
+ */
+extern aerospike_stats*
+aerospike_stats_create(void);
+
+extern void
+aerospike_stats_destroy(aerospike_stats *stats_p);
+
+extern uint64_t
+aerospike_stats_now_ns(void);
+
+extern void
+aerospike_stats_begin(aerospike_stats_call *call_p, int op TSRMLS_DC);
+
+extern void
+aerospike_stats_end(aerospike_stats_call *call_p, as_status status TSRMLS_DC);
+
+extern void
+aerospike_stats_net_begin(aerospike *as_p TSRMLS_DC);
+
+extern as_status
+aerospike_stats_net_end(as_key *key_p, const char *ns_p, const char *set_p,
+        as_policy_replica replica, uint32_t bins, as_status status TSRMLS_DC);
+
+extern void
+aerospike_stats_net_add(aerospike *as_p, const char *ns_p, const char *set_p,
+        uint64_t net_ns TSRMLS_DC);
+
+extern void
+aerospike_stats_nodes_get(as_cluster *cluster_p, as_nodes *nodes_p,
+        zval **node_stats_pp TSRMLS_DC);
+
+extern as_policy_replica
+aerospike_stats_operate_replica(as_operations *ops_p, as_policy_replica replica);
+
+extern as_status
+aerospike_stats_trace_set(zend_fcall_info *fci_p, zend_fcall_info_cache *fcc_p,
+        double sample_rate, as_error *error_p TSRMLS_DC);
+
+extern void
+aerospike_stats_trace_release(TSRMLS_D);
+
+extern void
+aerospike_stats_counters(zval *return_p TSRMLS_DC);
+
+/*
+ ******************************************************************************************************
+ * Extern declarations of benchmark functions (--enable-aerospike-bench).
+ ******************************************************************************************************
+ */
+#ifdef AEROSPIKE_BENCH
+extern as_status
+aerospike_bench_transform(zval *bins_p, long iterations,
+        uint32_t serializer_policy, zval *return_p, as_error *error_p TSRMLS_DC);
+#endif
+
+extern void
+aerospike_stats_flush_slow_ops(TSRMLS_D);
+
+extern as_status
+aerospike_stats_get(zval *return_p, bool reset, as_error *error_p TSRMLS_DC);
+
+/*
+ ******************************************************************************************************
+ * Extern declarations of record stream functions.
+ ******************************************************************************************************
+ */
+extern aerospike_stream*
+aerospike_stream_create(aerospike *as_object_p, uint32_t capacity);
+
+extern as_status
+aerospike_stream_start_scan(aerospike_stream *stream_p,
+        as_policy_scan *scan_policy_p, as_scan *scan_p, bool owns_request,
+        as_error *error_p);
+
+extern as_status
+aerospike_stream_start_query(aerospike_stream *stream_p,
+        as_policy_query *query_policy_p, as_query *query_p, bool owns_request,
+        as_error *error_p);
+
+extern as_record*
+aerospike_stream_next(aerospike_stream *stream_p);
+
+extern void
+aerospike_stream_cancel(aerospike_stream *stream_p);
+
+extern as_status
+aerospike_stream_destroy(aerospike_stream *stream_p, as_error *error_p,
+        bool report_cancelled);
+
+extern as_status
+aerospike_stream_run(aerospike_stream *stream_p, userland_callback *user_func_p,
+        uint32_t batch_size, as_error *error_p TSRMLS_DC);
+
+/*
+ ******************************************************************************************************
+ * Extern declarations of iterator functions.
+ ******************************************************************************************************
+ */
+extern void
+aerospike_iterator_init(zval *iterator_p, zval *owner_p,
+        aerospike_stream *stream_p TSRMLS_DC);
+
+extern void
+aerospike_iterator_close_all(Aerospike_object *aerospike_obj_p TSRMLS_DC);
+
+extern int
+aerospike_iterator_register_class(TSRMLS_D);
+
 /*
  ******************************************************************************************************
  * Extern declarations of index functions.
@@ -682,6 +1091,20 @@ extern as_status
 aerospike_info_get_cluster_nodes(aerospike* as_object_p,
         as_error* error_p, zval* return_p, zval* host, zval* options_p TSRMLS_DC);
 
+extern void
+aerospike_info_shm_observe(aerospike_ref* as_ref_p);
+
+extern as_status
+aerospike_info_shm_stats(aerospike_ref* as_ref_p, as_error* error_p,
+        zval* return_p TSRMLS_DC);
+
+extern as_status
+aerospike_info_node_stats(aerospike* as_object_p, as_error* error_p,
+        zval* return_p TSRMLS_DC);
+
+extern void
+aerospike_info_runtime(zval* return_p TSRMLS_DC);
+
 /*
  ******************************************************************************************************
  * Extern declarations of Batch operations.
@@ -708,4 +1131,7 @@ set_policy(as_policy_read *read_policy_p, as_policy_write *write_policy_p,
         as_policy_query *query_policy_p, uint32_t *serializer_policy_p,
         zval *options_p, as_error *error_p TSRMLS_DC);
 
+extern void
+aerospike_policy_ini_info(zval *return_p TSRMLS_DC);
+
 #endif
@@ -0,0 +1,774 @@
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include "php.h"
+#include "aerospike/as_log.h"
+#include "aerospike/as_error.h"
+#include "aerospike/as_status.h"
+#include "aerospike/as_record.h"
+#include "aerospike/as_scan.h"
+#include "aerospike/as_buffer.h"
+#include "aerospike/as_hashmap.h"
+#include "aerospike/as_stringmap.h"
+#include "aerospike/as_serializer.h"
+#include "aerospike/as_msgpack.h"
+#include "aerospike/aerospike.h"
+#include "aerospike/aerospike_scan.h"
+#include "aerospike_common.h"
+#include "aerospike_policy.h"
+
+/*
+ *******************************************************************************************************
+ * Aerospike::scanToFile() support: the records of a scan are formatted and
+ * written to disk from the C client's callback, without going through the
+ * PHP interpreter. Callbacks may run on the client's node threads, so no
+ * PHP (emalloc'd or zval) state is touched from them.
+ *
+ * With OPT_SCAN_CONCURRENTLY every node thread writes to its own part file
+ * (<path>.part<n>) without taking a lock; otherwise a single file is written
+ * under the export's lock.
+ *******************************************************************************************************
+ */
+#define AEROSPIKE_EXPORT_FLUSH_SIZE     (64 * 1024)
+#define AEROSPIKE_EXPORT_RECORDS        "records"
+#define AEROSPIKE_EXPORT_BYTES          "bytes"
+#define AEROSPIKE_EXPORT_FILES          "files"
+
+typedef struct aerospike_export_buffer_s {
+    char        *data_p;
+    size_t      size;
+    size_t      capacity;
+} aerospike_export_buffer;
+
+typedef struct aerospike_export_file_s {
+    pthread_t               thread;
+    char                    path[MAXPATHLEN];
+    FILE                    *file_p;
+    gzFile                  gz_file;
+    aerospike_export_buffer buffer;
+    uint64_t                records;
+} aerospike_export_file;
+
+typedef struct aerospike_export_s {
+    uint64_t                id;
+    const char              *path_p;
+    long                    format;
+    bool                    gzip;
+    bool                    per_thread;
+    char                    **bin_names_pp;
+    uint32_t                n_bins;
+    pthread_mutex_t         lock;
+    aerospike_export_file   **files_pp;
+    uint32_t                n_files;
+    uint32_t                files_capacity;
+    volatile bool           failed;
+    as_error                error;
+} aerospike_export;
+
+typedef struct aerospike_export_json_udata_s {
+    aerospike_export_buffer *buffer_p;
+    bool                    first;
+} aerospike_export_json_udata;
+
+/*
+ * Each node thread remembers the part file it writes to, tagged with the id
+ * of the export it belongs to so that a later export never reuses it.
+ */
+static uint64_t aerospike_export_serial = 0;
+static __thread uint64_t aerospike_export_tls_id = 0;
+static __thread aerospike_export_file *aerospike_export_tls_file_p = NULL;
+
+static const char aerospike_export_b64[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static bool
+export_json_val(aerospike_export_buffer *buffer_p, const as_val *val_p);
+
+/*
+ *******************************************************************************************************
+ * Output buffer helpers. The buffers are malloc'd, as they are filled from
+ * the C client's threads.
+ *******************************************************************************************************
+ */
+static bool
+export_buffer_append(aerospike_export_buffer *buffer_p, const char *data_p, size_t len)
+{
+    size_t      capacity = 0;
+    char        *data_new_p = NULL;
+
+    if (buffer_p->size + len > buffer_p->capacity) {
+        capacity = buffer_p->capacity ? buffer_p->capacity : 1024;
+        while (capacity < buffer_p->size + len) {
+            capacity *= 2;
+        }
+        if (NULL == (data_new_p = realloc(buffer_p->data_p, capacity))) {
+            return false;
+        }
+        buffer_p->data_p = data_new_p;
+        buffer_p->capacity = capacity;
+    }
+    memcpy(buffer_p->data_p + buffer_p->size, data_p, len);
+    buffer_p->size += len;
+    return true;
+}
+
+static bool
+export_buffer_append_str(aerospike_export_buffer *buffer_p, const char *str_p)
+{
+    return export_buffer_append(buffer_p, str_p, strlen(str_p));
+}
+
+static bool
+export_buffer_append_int(aerospike_export_buffer *buffer_p, int64_t value)
+{
+    char        digits[32];
+    int         len = snprintf(digits, sizeof(digits), "%" PRId64, value);
+
+    return export_buffer_append(buffer_p, digits, len);
+}
+
+static bool
+export_buffer_append_b64(aerospike_export_buffer *buffer_p, const uint8_t *data_p, uint32_t size)
+{
+    char        quad[4];
+    uint32_t    i = 0;
+    uint32_t    triple = 0;
+
+    for (i = 0; i < size; i += 3) {
+        triple = data_p[i] << 16;
+        if (i + 1 < size) {
+            triple |= data_p[i + 1] << 8;
+        }
+        if (i + 2 < size) {
+            triple |= data_p[i + 2];
+        }
+        quad[0] = aerospike_export_b64[(triple >> 18) & 0x3F];
+        quad[1] = aerospike_export_b64[(triple >> 12) & 0x3F];
+        quad[2] = (i + 1 < size) ? aerospike_export_b64[(triple >> 6) & 0x3F] : '=';
+        quad[3] = (i + 2 < size) ? aerospike_export_b64[triple & 0x3F] : '=';
+        if (!export_buffer_append(buffer_p, quad, 4)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool
+export_buffer_append_hex(aerospike_export_buffer *buffer_p, const uint8_t *data_p, uint32_t size)
+{
+    char        hex[2];
+    uint32_t    i = 0;
+
+    for (i = 0; i < size; i++) {
+        hex[0] = "0123456789abcdef"[data_p[i] >> 4];
+        hex[1] = "0123456789abcdef"[data_p[i] & 0x0F];
+        if (!export_buffer_append(buffer_p, hex, 2)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ *******************************************************************************************************
+ * JSON encoding of as_val. Bytes are written as base64 strings and map keys
+ * which are not strings are written as their JSON text, quoted.
+ *******************************************************************************************************
+ */
+static bool
+export_json_string(aerospike_export_buffer *buffer_p, const char *str_p, size_t len)
+{
+    char        escaped[8];
+    size_t      i = 0;
+    size_t      start = 0;
+    bool        ok = export_buffer_append(buffer_p, "\"", 1);
+
+    for (i = 0; ok && i < len; i++) {
+        unsigned char c = (unsigned char) str_p[i];
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+        ok = export_buffer_append(buffer_p, str_p + start, i - start);
+        switch (c) {
+            case '"':  strcpy(escaped, "\\\""); break;
+            case '\\': strcpy(escaped, "\\\\"); break;
+            case '\n': strcpy(escaped, "\\n"); break;
+            case '\r': strcpy(escaped, "\\r"); break;
+            case '\t': strcpy(escaped, "\\t"); break;
+            default:   snprintf(escaped, sizeof(escaped), "\\u%04x", c); break;
+        }
+        ok = ok && export_buffer_append_str(buffer_p, escaped);
+        start = i + 1;
+    }
+    ok = ok && export_buffer_append(buffer_p, str_p + start, len - start);
+    return ok && export_buffer_append(buffer_p, "\"", 1);
+}
+
+static bool
+export_json_list_element(as_val *val_p, void *udata_p)
+{
+    aerospike_export_json_udata *json_p = (aerospike_export_json_udata *) udata_p;
+
+    if (!json_p->first && !export_buffer_append(json_p->buffer_p, ",", 1)) {
+        return false;
+    }
+    json_p->first = false;
+    return export_json_val(json_p->buffer_p, val_p);
+}
+
+static bool
+export_json_map_entry(const as_val *key_p, const as_val *val_p, void *udata_p)
+{
+    aerospike_export_json_udata *json_p = (aerospike_export_json_udata *) udata_p;
+    aerospike_export_buffer     key_buffer = {0};
+    bool                        ok = true;
+
+    if (!json_p->first && !export_buffer_append(json_p->buffer_p, ",", 1)) {
+        return false;
+    }
+    json_p->first = false;
+
+    if (key_p && as_val_type(key_p) == AS_STRING) {
+        ok = export_json_string(json_p->buffer_p, as_string_get((as_string *) key_p),
+                as_string_len((as_string *) key_p));
+    } else {
+        ok = export_json_val(&key_buffer, key_p) &&
+            export_json_string(json_p->buffer_p, key_buffer.data_p, key_buffer.size);
+        free(key_buffer.data_p);
+    }
+    return ok && export_buffer_append(json_p->buffer_p, ":", 1) &&
+        export_json_val(json_p->buffer_p, val_p);
+}
+
+static bool
+export_json_val(aerospike_export_buffer *buffer_p, const as_val *val_p)
+{
+    aerospike_export_json_udata json = {buffer_p, true};
+
+    switch (val_p ? as_val_type(val_p) : AS_NIL) {
+        case AS_BOOLEAN:
+            return export_buffer_append_str(buffer_p,
+                    as_boolean_get((as_boolean *) val_p) ? "true" : "false");
+        case AS_INTEGER:
+            return export_buffer_append_int(buffer_p, as_integer_get((as_integer *) val_p));
+        case AS_STRING:
+            return export_json_string(buffer_p, as_string_get((as_string *) val_p),
+                    as_string_len((as_string *) val_p));
+        case AS_BYTES:
+            return export_buffer_append(buffer_p, "\"", 1) &&
+                export_buffer_append_b64(buffer_p, as_bytes_get((as_bytes *) val_p),
+                        as_bytes_size((as_bytes *) val_p)) &&
+                export_buffer_append(buffer_p, "\"", 1);
+        case AS_LIST:
+            return export_buffer_append(buffer_p, "[", 1) &&
+                as_list_foreach((as_list *) val_p, export_json_list_element, &json) &&
+                export_buffer_append(buffer_p, "]", 1);
+        case AS_MAP:
+            return export_buffer_append(buffer_p, "{", 1) &&
+                as_map_foreach((as_map *) val_p,
+                        (as_map_foreach_callback) export_json_map_entry, &json) &&
+                export_buffer_append(buffer_p, "}", 1);
+        default:
+            return export_buffer_append_str(buffer_p, "null");
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Record formatters. NDJSON and msgpack records mirror the array passed to
+ * scan() callbacks (key, metadata and bins); CSV rows hold the selected bins.
+ *******************************************************************************************************
+ */
+static bool
+export_format_ndjson(aerospike_export *export_p, aerospike_export_buffer *buffer_p,
+        const as_record *record_p)
+{
+    uint16_t        i = 0;
+    bool            ok = true;
+
+    ok = export_buffer_append_str(buffer_p, "{\"key\":{\"ns\":") &&
+        export_json_string(buffer_p, record_p->key.ns, strlen(record_p->key.ns)) &&
+        export_buffer_append_str(buffer_p, ",\"set\":") &&
+        export_json_string(buffer_p, record_p->key.set, strlen(record_p->key.set)) &&
+        export_buffer_append_str(buffer_p, ",\"digest\":\"") &&
+        export_buffer_append_hex(buffer_p, record_p->key.digest.value, AS_DIGEST_VALUE_SIZE) &&
+        export_buffer_append(buffer_p, "\"", 1);
+    if (ok && record_p->key.valuep) {
+        ok = export_buffer_append_str(buffer_p, ",\"key\":") &&
+            export_json_val(buffer_p, (as_val *) record_p->key.valuep);
+    }
+    ok = ok && export_buffer_append_str(buffer_p, "},\"metadata\":{\"generation\":") &&
+        export_buffer_append_int(buffer_p, record_p->gen) &&
+        export_buffer_append_str(buffer_p, ",\"ttl\":") &&
+        export_buffer_append_int(buffer_p, record_p->ttl) &&
+        export_buffer_append_str(buffer_p, "},\"bins\":{");
+
+    for (i = 0; ok && i < record_p->bins.size; i++) {
+        ok = (i == 0 || export_buffer_append(buffer_p, ",", 1)) &&
+            export_json_string(buffer_p, record_p->bins.entries[i].name,
+                    strlen(record_p->bins.entries[i].name)) &&
+            export_buffer_append(buffer_p, ":", 1) &&
+            export_json_val(buffer_p, (as_val *) record_p->bins.entries[i].valuep);
+    }
+    return ok && export_buffer_append_str(buffer_p, "}}\n");
+}
+
+static bool
+export_csv_string(aerospike_export_buffer *buffer_p, const char *str_p, size_t len)
+{
+    size_t      i = 0;
+    size_t      start = 0;
+    bool        ok = export_buffer_append(buffer_p, "\"", 1);
+
+    for (i = 0; ok && i < len; i++) {
+        if (str_p[i] == '"') {
+            ok = export_buffer_append(buffer_p, str_p + start, i + 1 - start) &&
+                export_buffer_append(buffer_p, "\"", 1);
+            start = i + 1;
+        }
+    }
+    ok = ok && export_buffer_append(buffer_p, str_p + start, len - start);
+    return ok && export_buffer_append(buffer_p, "\"", 1);
+}
+
+static bool
+export_format_csv_header(aerospike_export *export_p, aerospike_export_buffer *buffer_p)
+{
+    uint32_t    i = 0;
+    bool        ok = true;
+
+    for (i = 0; ok && i < export_p->n_bins; i++) {
+        ok = (i == 0 || export_buffer_append(buffer_p, ",", 1)) &&
+            export_csv_string(buffer_p, export_p->bin_names_pp[i],
+                    strlen(export_p->bin_names_pp[i]));
+    }
+    return ok && export_buffer_append(buffer_p, "\n", 1);
+}
+
+static bool
+export_format_csv(aerospike_export *export_p, aerospike_export_buffer *buffer_p,
+        const as_record *record_p)
+{
+    aerospike_export_buffer nested = {0};
+    as_val                  *val_p = NULL;
+    uint32_t                i = 0;
+    bool                    ok = true;
+
+    for (i = 0; ok && i < export_p->n_bins; i++) {
+        ok = (i == 0 || export_buffer_append(buffer_p, ",", 1));
+        val_p = (as_val *) as_record_get((as_record *) record_p, export_p->bin_names_pp[i]);
+        switch (val_p ? as_val_type(val_p) : AS_NIL) {
+            case AS_INTEGER:
+            case AS_BOOLEAN:
+                ok = ok && export_json_val(buffer_p, val_p);
+                break;
+            case AS_STRING:
+                ok = ok && export_csv_string(buffer_p, as_string_get((as_string *) val_p),
+                        as_string_len((as_string *) val_p));
+                break;
+            case AS_BYTES:
+                ok = ok && export_buffer_append_b64(buffer_p, as_bytes_get((as_bytes *) val_p),
+                        as_bytes_size((as_bytes *) val_p));
+                break;
+            case AS_LIST:
+            case AS_MAP:
+                nested.size = 0;
+                ok = ok && export_json_val(&nested, val_p) &&
+                    export_csv_string(buffer_p, nested.data_p, nested.size);
+                break;
+            default:
+                break;
+        }
+    }
+    free(nested.data_p);
+    return ok && export_buffer_append(buffer_p, "\n", 1);
+}
+
+static bool
+export_format_msgpack(aerospike_export *export_p, aerospike_export_buffer *buffer_p,
+        const as_record *record_p)
+{
+    as_serializer   serializer;
+    as_buffer       packed;
+    as_hashmap      *record_map_p = as_hashmap_new(3);
+    as_hashmap      *key_map_p = as_hashmap_new(4);
+    as_hashmap      *metadata_map_p = as_hashmap_new(2);
+    as_hashmap      *bins_map_p = as_hashmap_new(record_p->bins.size ? record_p->bins.size : 1);
+    as_val          *val_p = NULL;
+    uint16_t        i = 0;
+    bool            ok = false;
+
+    if (!record_map_p || !key_map_p || !metadata_map_p || !bins_map_p) {
+        goto exit;
+    }
+
+    as_stringmap_set_str((as_map *) key_map_p, "ns", record_p->key.ns);
+    as_stringmap_set_str((as_map *) key_map_p, "set", record_p->key.set);
+    as_stringmap_set((as_map *) key_map_p, "digest", (as_val *) as_bytes_new_wrap(
+                (uint8_t *) record_p->key.digest.value, AS_DIGEST_VALUE_SIZE, false));
+    if (record_p->key.valuep) {
+        as_val_reserve((as_val *) record_p->key.valuep);
+        as_stringmap_set((as_map *) key_map_p, "key", (as_val *) record_p->key.valuep);
+    }
+    as_stringmap_set_int64((as_map *) metadata_map_p, "generation", record_p->gen);
+    as_stringmap_set_int64((as_map *) metadata_map_p, "ttl", record_p->ttl);
+    for (i = 0; i < record_p->bins.size; i++) {
+        if (NULL != (val_p = (as_val *) record_p->bins.entries[i].valuep)) {
+            as_val_reserve(val_p);
+            as_stringmap_set((as_map *) bins_map_p, record_p->bins.entries[i].name, val_p);
+        }
+    }
+
+    /* ownership of the nested maps moves to record_map_p */
+    as_stringmap_set_map((as_map *) record_map_p, "key", (as_map *) key_map_p);
+    as_stringmap_set_map((as_map *) record_map_p, "metadata", (as_map *) metadata_map_p);
+    as_stringmap_set_map((as_map *) record_map_p, "bins", (as_map *) bins_map_p);
+    key_map_p = metadata_map_p = bins_map_p = NULL;
+
+    as_msgpack_init(&serializer);
+    as_buffer_init(&packed);
+    if (0 == as_serializer_serialize(&serializer, (as_val *) record_map_p, &packed)) {
+        ok = export_buffer_append(buffer_p, (char *) packed.data, packed.size);
+    }
+    as_buffer_destroy(&packed);
+    as_serializer_destroy(&serializer);
+
+exit:
+    if (record_map_p) {
+        as_hashmap_destroy(record_map_p);
+    }
+    if (key_map_p) {
+        as_hashmap_destroy(key_map_p);
+    }
+    if (metadata_map_p) {
+        as_hashmap_destroy(metadata_map_p);
+    }
+    if (bins_map_p) {
+        as_hashmap_destroy(bins_map_p);
+    }
+    return ok;
+}
+
+/*
+ *******************************************************************************************************
+ * Output file handling.
+ *******************************************************************************************************
+ */
+static void
+export_fail(aerospike_export *export_p, const char *message_p)
+{
+    pthread_mutex_lock(&export_p->lock);
+    if (!export_p->failed) {
+        export_p->failed = true;
+        PHP_EXT_SET_AS_ERR(&export_p->error, AEROSPIKE_ERR_CLIENT, message_p);
+    }
+    pthread_mutex_unlock(&export_p->lock);
+}
+
+static bool
+export_file_flush(aerospike_export_file *file_p)
+{
+    bool        ok = true;
+
+    if (file_p->buffer.size) {
+        if (file_p->gz_file) {
+            ok = (gzwrite(file_p->gz_file, file_p->buffer.data_p,
+                        (unsigned) file_p->buffer.size) == (int) file_p->buffer.size);
+        } else {
+            ok = (fwrite(file_p->buffer.data_p, 1, file_p->buffer.size,
+                        file_p->file_p) == file_p->buffer.size);
+        }
+        file_p->buffer.size = 0;
+    }
+    return ok;
+}
+
+static bool
+export_file_close(aerospike_export_file *file_p)
+{
+    bool        ok = export_file_flush(file_p);
+
+    if (file_p->gz_file) {
+        ok = (Z_OK == gzclose(file_p->gz_file)) && ok;
+        file_p->gz_file = NULL;
+    }
+    if (file_p->file_p) {
+        ok = (0 == fclose(file_p->file_p)) && ok;
+        file_p->file_p = NULL;
+    }
+    return ok;
+}
+
+/*
+ * Opens the next output file of the export. Must be called with the
+ * export's lock held.
+ */
+static aerospike_export_file *
+export_file_open(aerospike_export *export_p)
+{
+    aerospike_export_file   *file_p = NULL;
+    aerospike_export_file   **files_pp = NULL;
+    uint32_t                capacity = 0;
+
+    if (export_p->n_files == export_p->files_capacity) {
+        capacity = export_p->files_capacity ? export_p->files_capacity * 2 : 8;
+        if (NULL == (files_pp = realloc(export_p->files_pp, capacity * sizeof(*files_pp)))) {
+            return NULL;
+        }
+        export_p->files_pp = files_pp;
+        export_p->files_capacity = capacity;
+    }
+
+    if (NULL == (file_p = calloc(1, sizeof(aerospike_export_file)))) {
+        return NULL;
+    }
+    file_p->thread = pthread_self();
+    if (export_p->per_thread) {
+        snprintf(file_p->path, sizeof(file_p->path), "%s.part%u",
+                export_p->path_p, export_p->n_files);
+    } else {
+        snprintf(file_p->path, sizeof(file_p->path), "%s", export_p->path_p);
+    }
+
+    if (export_p->gzip) {
+        file_p->gz_file = gzopen(file_p->path, "wb");
+    } else {
+        file_p->file_p = fopen(file_p->path, "wb");
+    }
+    if (!file_p->gz_file && !file_p->file_p) {
+        free(file_p);
+        return NULL;
+    }
+
+    if (export_p->format == FILE_FORMAT_CSV &&
+            !export_format_csv_header(export_p, &file_p->buffer)) {
+        export_file_close(file_p);
+        free(file_p->buffer.data_p);
+        free(file_p);
+        return NULL;
+    }
+
+    export_p->files_pp[export_p->n_files++] = file_p;
+    return file_p;
+}
+
+/*
+ *******************************************************************************************************
+ * Callback for aerospike_scan_foreach(): formats the record into the output
+ * buffer of the calling thread's file and flushes it when it is full.
+ *
+ * @param val_p             The current record, NULL once the scan is done.
+ * @param udata_p           The aerospike_export.
+ *
+ * @return false to abort the scan on a write error, else true.
+ *******************************************************************************************************
+ */
+static bool
+export_record(const as_val *val_p, void *udata_p)
+{
+    aerospike_export        *export_p = (aerospike_export *) udata_p;
+    aerospike_export_file   *file_p = NULL;
+    as_record               *record_p = NULL;
+    bool                    ok = false;
+
+    if (!val_p) {
+        return true;
+    }
+    if (export_p->failed) {
+        return false;
+    }
+    if (NULL == (record_p = as_record_fromval(val_p))) {
+        return true;
+    }
+
+    if (export_p->per_thread) {
+        if (aerospike_export_tls_id == export_p->id) {
+            file_p = aerospike_export_tls_file_p;
+        } else {
+            pthread_mutex_lock(&export_p->lock);
+            file_p = export_file_open(export_p);
+            pthread_mutex_unlock(&export_p->lock);
+            aerospike_export_tls_id = export_p->id;
+            aerospike_export_tls_file_p = file_p;
+        }
+    } else {
+        pthread_mutex_lock(&export_p->lock);
+        file_p = export_p->n_files ? export_p->files_pp[0] : export_file_open(export_p);
+    }
+
+    if (!file_p) {
+        if (!export_p->per_thread) {
+            pthread_mutex_unlock(&export_p->lock);
+        }
+        export_fail(export_p, "Unable to open the export file");
+        return false;
+    }
+
+    switch (export_p->format) {
+        case FILE_FORMAT_CSV:
+            ok = export_format_csv(export_p, &file_p->buffer, record_p);
+            break;
+        case FILE_FORMAT_MSGPACK:
+            ok = export_format_msgpack(export_p, &file_p->buffer, record_p);
+            break;
+        default:
+            ok = export_format_ndjson(export_p, &file_p->buffer, record_p);
+            break;
+    }
+    if (ok) {
+        file_p->records++;
+        if (file_p->buffer.size >= AEROSPIKE_EXPORT_FLUSH_SIZE) {
+            ok = export_file_flush(file_p);
+        }
+    }
+
+    if (!export_p->per_thread) {
+        pthread_mutex_unlock(&export_p->lock);
+    }
+    if (!ok) {
+        export_fail(export_p, "Unable to write to the export file");
+    }
+    return ok;
+}
+
+/*
+ *******************************************************************************************************
+ * Scans a set in the Aerospike DB and writes its records to a file.
+ *
+ * @param as_object_p               The C client's aerospike object.
+ * @param error_p                   The C client's as_error to be set to the encountered error.
+ * @param namespace_p               The namespace to scan.
+ * @param set_p                     The set to scan.
+ * @param path_p                    The file to write. Part files are named
+ *                                  <path>.part<n> when scanning concurrently.
+ * @param format                    One of the FILE_FORMAT_* values.
+ * @param stats_p                   Set to the records and bytes written and
+ *                                  the list of files.
+ * @param bins_ht_p                 The HashTable for optional filter bins array.
+ *                                  Required for FILE_FORMAT_CSV (the columns).
+ * @param options_p                 The optional policy.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ ******************************************************************************************************
+ */
+extern as_status
+aerospike_scan_to_file(aerospike* as_object_p, as_error* error_p,
+        char* namespace_p, char* set_p, char* path_p, long format,
+        zval* stats_p, HashTable* bins_ht_p, zval* options_p TSRMLS_DC)
+{
+    aerospike_export    export;
+    as_scan             scan;
+    as_policy_scan      scan_policy;
+    uint32_t            serializer_policy = -1;
+    zval                *files_p = NULL;
+    zval                **gzip_pp = NULL;
+    zval                **bin_names_pp = NULL;
+    HashPosition        pos;
+    struct stat         file_stat;
+    uint64_t            records = 0;
+    uint64_t            bytes = 0;
+    uint32_t            i = 0;
+    bool                started = false;
+
+    memset(&export, 0, sizeof(export));
+    pthread_mutex_init(&export.lock, NULL);
+    as_error_init(&export.error);
+    as_scan_init(&scan, namespace_p, set_p);
+
+    if ((format != FILE_FORMAT_NDJSON) && (format != FILE_FORMAT_CSV) &&
+            (format != FILE_FORMAT_MSGPACK)) {
+        DEBUG_PHP_EXT_DEBUG("Invalid file format");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM, "Invalid file format");
+        goto exit;
+    }
+    if ((format == FILE_FORMAT_CSV) && (!bins_ht_p || !zend_hash_num_elements(bins_ht_p))) {
+        DEBUG_PHP_EXT_DEBUG("FILE_FORMAT_CSV requires the bins to be selected");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                "FILE_FORMAT_CSV requires the bins to be selected");
+        goto exit;
+    }
+
+    set_policy_scan(&scan_policy, &serializer_policy, &scan, options_p, error_p TSRMLS_CC);
+    if (AEROSPIKE_OK != (error_p->code)) {
+        DEBUG_PHP_EXT_DEBUG("Unable to set policy");
+        goto exit;
+    }
+
+    if (options_p && (zend_hash_index_find(Z_ARRVAL_P(options_p), OPT_FILE_GZIP,
+                    (void **) &gzip_pp) == SUCCESS)) {
+        export.gzip = (Z_TYPE_PP(gzip_pp) == IS_BOOL && Z_BVAL_PP(gzip_pp));
+    }
+
+    if (bins_ht_p) {
+        as_scan_select_init(&scan, zend_hash_num_elements(bins_ht_p));
+        export.bin_names_pp = ecalloc(zend_hash_num_elements(bins_ht_p), sizeof(char *));
+        foreach_hashtable(bins_ht_p, pos, bin_names_pp) {
+            if (Z_TYPE_PP(bin_names_pp) != IS_STRING) {
+                convert_to_string_ex(bin_names_pp);
+            }
+            as_scan_select(&scan, Z_STRVAL_PP(bin_names_pp));
+            export.bin_names_pp[export.n_bins++] = Z_STRVAL_PP(bin_names_pp);
+        }
+    }
+
+    export.id = __sync_add_and_fetch(&aerospike_export_serial, 1);
+    export.path_p = path_p;
+    export.format = format;
+    export.per_thread = scan.concurrent;
+
+    if (!export.per_thread) {
+        /* a scan without matches still leaves an (empty) file behind */
+        if (NULL == export_file_open(&export)) {
+            DEBUG_PHP_EXT_DEBUG("Unable to open the export file");
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT, "Unable to open the export file");
+            goto exit;
+        }
+    }
+
+    started = true;
+    if (AEROSPIKE_OK != AEROSPIKE_STATS_NET(as_object_p, NULL, namespace_p, set_p, 0,
+                aerospike_scan_foreach(as_object_p, error_p,
+                    &scan_policy, &scan, export_record, &export))) {
+        DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
+    }
+
+exit:
+    for (i = 0; i < export.n_files; i++) {
+        if (!export_file_close(export.files_pp[i])) {
+            export_fail(&export, "Unable to write to the export file");
+        }
+        if (0 == stat(export.files_pp[i]->path, &file_stat)) {
+            bytes += file_stat.st_size;
+        }
+        records += export.files_pp[i]->records;
+    }
+    if (export.failed) {
+        as_error_copy(error_p, &export.error);
+    }
+
+    if (stats_p && started) {
+        add_assoc_long(stats_p, AEROSPIKE_EXPORT_RECORDS, records);
+        add_assoc_long(stats_p, AEROSPIKE_EXPORT_BYTES, bytes);
+        MAKE_STD_ZVAL(files_p);
+        array_init(files_p);
+        for (i = 0; i < export.n_files; i++) {
+            add_next_index_string(files_p, export.files_pp[i]->path, 1);
+        }
+        add_assoc_zval(stats_p, AEROSPIKE_EXPORT_FILES, files_p);
+    }
+
+    for (i = 0; i < export.n_files; i++) {
+        free(export.files_pp[i]->buffer.data_p);
+        free(export.files_pp[i]);
+    }
+    free(export.files_pp);
+    if (export.bin_names_pp) {
+        efree(export.bin_names_pp);
+    }
+    as_scan_destroy(&scan);
+    pthread_mutex_destroy(&export.lock);
+    return error_p->code;
+}
@@ -7,12 +7,18 @@
 #include "aerospike/as_status.h"
 #include "aerospike/as_record.h"
 #include "aerospike/aerospike.h"
+#include "aerospike/aerospike_info.h"
 #include "pthread.h"
 #include "aerospike_common.h"
+#include "aerospike_policy.h"
 
 #define SAVE_PATH_DELIMITER "|"
 #define IP_PORT_DELIMITER ":"
 #define HOST_DELIMITER ","
+#define SAVE_PATH_OPTION_DELIMITER "&"
+#define CLUSTER_DELIMITER ";"
+
+extern int persist;
 
 /*
  *******************************************************************************************************
@@ -37,11 +43,10 @@ as_log_level php_log_level_set = __AEROSPIKE_PHP_CLIENT_LOG_LEVEL__;
 
 /*
  *******************************************************************************************************
- * Callback for C client's logger.
- * This function shall be invoked by:
- * 1. C client's logger statements.
- * 2. PHP client's logger statements.
- * 
+ * Callback for the PHP client's logger statements (the C client's go to
+ * aerospike_log_client_callback). With a handler registered the message is
+ * queued for it, otherwise it is printed to stderr.
+ *
  * @param level             The as_log_level to be used by the callback.
  * @param func              The function name generating the log.
  * @param file              The file name containing the func generating the log.
@@ -54,59 +59,19 @@ as_log_level php_log_level_set = __AEROSPIKE_PHP_CLIENT_LOG_LEVEL__;
 extern bool
 aerospike_helper_log_callback(as_log_level level, const char * func TSRMLS_DC, const char * file, uint32_t line, const char * fmt, ...)
 {
-    if (level & 0x08) {
+    va_list ap;
+
+    va_start(ap, fmt);
+    if (is_callback_registered) {
+        aerospike_log_queue(level, func, file, line, fmt, ap);
+    } else if (level & 0x08) {
         char msg[1024] = {0};
-        va_list ap;
 
-        va_start(ap, fmt);
         vsnprintf(msg, 1024, fmt, ap);
         msg[1023] = '\0';
-        va_end(ap);
-        if (!is_callback_registered) { 
-            fprintf(stderr, "PHP EXTn: level %d func %s file %s line %d msg %s \n", level, func, file, line, msg);
-	    }
-    }
-
-    if (is_callback_registered) { 
-        int16_t   iter = 0;
-        zval**    params[4];
-        zval*     z_func = NULL;
-        zval*     z_file = NULL;
-        zval*     z_line = NULL; 
-        zval*     z_level = NULL;
-        func_callback_retval_p = NULL;
-
-        ALLOC_INIT_ZVAL(z_level);
-        ZVAL_LONG(z_level, level);
-        params[0] = &z_level;
-
-        ALLOC_INIT_ZVAL(z_func);
-        ZVAL_STRING(z_func, func, 1);
-        params[1] = &z_func;
-
-        ALLOC_INIT_ZVAL(z_file);
-        ZVAL_STRING(z_file, file, 1);
-        params[2] = &z_file;
-
-        ALLOC_INIT_ZVAL(z_line);
-        ZVAL_LONG(z_line, line);
-        params[3] = &z_line;
-
-        func_call_info.param_count = 4;
-        func_call_info.params = params;
-        func_call_info.retval_ptr_ptr = &func_callback_retval_p;
-   
-        if (zend_call_function(&func_call_info, &func_call_info_cache TSRMLS_CC) == SUCCESS && 
-            func_call_info.retval_ptr_ptr && *func_call_info.retval_ptr_ptr) {
-                //TODO: COPY_PZVAL_TO_ZVAL(*return_value, *func_call_info.retval_ptr_ptr);
-        } else {
-                // TODO: Handle failure in zend_call_function
-        }
-
-        for (iter = 0; iter < 4; iter++) {
-            zval_ptr_dtor(params[iter]);
-        }
+        fprintf(stderr, "PHP EXTn: level %d func %s file %s line %d msg %s \n", level, func, file, line, msg);
     }
+    va_end(ap);
 
     return true;
 }
@@ -145,6 +110,9 @@ aerospike_helper_set_error(zend_class_entry *ce_p, zval *object_p TSRMLS_DC)
 
     zval_ptr_dtor(&err_code_p);
     zval_ptr_dtor(&err_msg_p);
+
+    /* The end of every API call is a safe point to run the log handler. */
+    aerospike_log_drain(TSRMLS_C);
 }
 
 /*
@@ -159,6 +127,12 @@ do {                                                                          \
         as_object_p->as_ref_p->as_p = NULL;                                   \
         as_object_p->as_ref_p->ref_as_p = 0;                                  \
         as_object_p->as_ref_p->ref_hosts_entry = 0;                           \
+        as_object_p->as_ref_p->created = time(NULL);                          \
+        as_object_p->as_ref_p->last_used = as_object_p->as_ref_p->created;    \
+        as_object_p->as_ref_p->shm_owner_pid = 0;                             \
+        as_object_p->as_ref_p->shm_takeovers = 0;                             \
+        as_object_p->as_ref_p->config_key_p = NULL;                           \
+        as_object_p->as_ref_p->config_key_len = 0;                            \
     }                                                                         \
     as_object_p->as_ref_p->as_p = aerospike_new(conf);                        \
     as_object_p->as_ref_p->ref_as_p = 1;                                      \
@@ -166,69 +140,333 @@ do {                                                                          \
 
 /*
  *******************************************************************************************************
- * This macro is defined to register a new resource and to add hash to it.
+ * Registry of the persistent C client's aerospike objects, keyed by the
+ * normalised as_config (hosts in any order, user, password, policies,
+ * timeouts, shm and lua settings), so that only a connection built from the
+ * same config is ever reused. The table is indexed by a hash of the config
+ * key, and every hit is confirmed against the key kept by the aerospike_ref.
+ *
+ * The registry is an immutable open addressing table published through an
+ * atomic pointer. Lookups take no lock; inserts copy the table under
+ * aerospike_mutex and publish the copy. The tables replaced
+ * may still be read by a concurrent lookup, so they are kept on a chain and
+ * freed with the persistent list.
  *******************************************************************************************************
  */
-#define ZEND_HASH_CREATE_ALIAS_NEW(alias, alias_len, new_flag)                 \
-do {                                                                           \
-    ZEND_CREATE_AEROSPIKE_REFERENCE_OBJECT();                                  \
-    ZEND_REGISTER_RESOURCE(rsrc_result, as_object_p->as_ref_p->as_p,           \
-            val_persist);                                                      \
-    new_le.ptr = as_object_p->as_ref_p;                                        \
-    new_le.type = val_persist;                                                 \
-    if (new_flag) {                                                            \
-        pthread_rwlock_wrlock(&AEROSPIKE_G(aerospike_mutex));                  \
-        zend_hash_add(persistent_list, alias, alias_len,                       \
-                (void *) &new_le, sizeof(zend_rsrc_list_entry), NULL);         \
-        ((aerospike_ref *) new_le.ptr)->ref_hosts_entry++;                     \
-        pthread_rwlock_unlock(&AEROSPIKE_G(aerospike_mutex));                  \
-    } else {                                                                   \
-        pthread_rwlock_wrlock(&AEROSPIKE_G(aerospike_mutex));                  \
-        zend_hash_update(persistent_list,                                      \
-                alias, alias_len, (void *) &new_le,                            \
-                sizeof(zend_rsrc_list_entry), (void **) &le);                  \
-        ((aerospike_ref *) new_le.ptr)->ref_hosts_entry++;                     \
-        pthread_rwlock_unlock(&AEROSPIKE_G(aerospike_mutex));                  \
-    }                                                                          \
-} while(0)
+typedef struct aerospike_registry_entry_s {
+    uint64_t        hash;
+    aerospike_ref   *ref_p;
+} aerospike_registry_entry;
+
+struct aerospike_registry_s {
+    struct aerospike_registry_s *retired_p;
+    uint32_t                    capacity;
+    uint32_t                    size;
+    aerospike_registry_entry    entries[1];
+};
+
+#define AEROSPIKE_REGISTRY_MIN_CAPACITY 16
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME 0x100000001B3ULL
+
+static inline uint64_t
+registry_hash_bytes(uint64_t hash, const void *data_p, size_t size)
+{
+    const unsigned char *byte_p = (const unsigned char *) data_p;
+    size_t              i = 0;
+
+    for (i = 0; i < size; i++) {
+        hash ^= byte_p[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
 
+static inline uint64_t
+registry_hash_mix(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static int
+registry_host_compare(const void *a_p, const void *b_p)
+{
+    return strcmp(*((char * const *) a_p), *((char * const *) b_p));
+}
+
+static inline char *
+registry_key_append(char *pos_p, const void *data_p, size_t size)
+{
+    memcpy(pos_p, data_p, size);
+    return pos_p + size;
+}
 
 /*
  *******************************************************************************************************
- * This macro is defined to match the config details with the stored object
- * details in the resource and if match use the existing one.
+ * Builds the key of a normalised as_config: the hosts, lowercased and
+ * sorted so that their order does not matter, followed by the other
+ * settings the connection is built from.
+ *
+ * The policies are copied byte by byte, so the as_config must have been
+ * zeroed before as_config_init().
+ *
+ * @param conf                  The as_config.
+ * @param len_p                 Populated with the length of the key.
+ *
+ * @return The key, to be efree'd by the caller.
  *******************************************************************************************************
  */
-#define ZEND_CONFIG_MATCH_USER_STORED(alias, alias_len)                       \
-do {                                                                          \
-    tmp_ref = le->ptr;                                                        \
-    for(itr_user=0; itr_user < conf->hosts_size; itr_user++ ) {               \
-        for(itr_stored=0; itr_stored < tmp_ref->as_p->config.hosts_size;      \
-                itr_stored++) {                                               \
-            if(strlen(conf->hosts[itr_user].addr) ==                          \
-                    strlen(tmp_ref->as_p->config.hosts[itr_stored].addr) &&   \
-                    (conf->hosts[itr_user].port ==                            \
-                     tmp_ref->as_p->config.hosts[itr_stored].port &&          \
-                     (strncasecmp(conf->hosts[itr_user].addr,                 \
-                                  tmp_ref->as_p->config.hosts[                \
-                                  itr_stored].addr,                           \
-                                  strlen(conf->hosts[itr_user].addr           \
-                                      )) == 0))) {                            \
-                goto use_existing;                                            \
-            }                                                                 \
-        }                                                                     \
-    }                                                                         \
-    ZEND_HASH_CREATE_ALIAS_NEW(alias, alias_len, 0);                          \
-} while(0)
+static char *
+registry_config_key(as_config *conf, size_t *len_p)
+{
+    char        *hosts_pp[AS_CONFIG_HOSTS_SIZE];
+    char        *key_p = NULL;
+    char        *pos_p = NULL;
+    char        *c_p = NULL;
+    size_t      len = 0;
+    uint32_t    i = 0;
+
+    for (i = 0; i < conf->hosts_size; i++) {
+        spprintf(&hosts_pp[i], 0, "%s:%d",
+                conf->hosts[i].addr ? conf->hosts[i].addr : "", conf->hosts[i].port);
+        for (c_p = hosts_pp[i]; *c_p; c_p++) {
+            *c_p = tolower(*c_p);
+        }
+        len += strlen(hosts_pp[i]) + 1;
+    }
+    qsort(hosts_pp, conf->hosts_size, sizeof(char *), registry_host_compare);
+
+    len += sizeof(conf->hosts_size) +
+        strlen(conf->user) + 1 + strlen(conf->password) + 1 +
+        sizeof(conf->conn_timeout_ms) + sizeof(conf->policies) +
+        sizeof(conf->use_shm) + sizeof(conf->shm_max_nodes) +
+        sizeof(conf->shm_max_namespaces) +
+        strlen(conf->lua.system_path) + 1 + strlen(conf->lua.user_path) + 1 +
+        sizeof(conf->lua.cache_enabled);
+    key_p = pos_p = emalloc(len);
+
+    pos_p = registry_key_append(pos_p, &conf->hosts_size, sizeof(conf->hosts_size));
+    for (i = 0; i < conf->hosts_size; i++) {
+        pos_p = registry_key_append(pos_p, hosts_pp[i], strlen(hosts_pp[i]) + 1);
+        efree(hosts_pp[i]);
+    }
+    pos_p = registry_key_append(pos_p, conf->user, strlen(conf->user) + 1);
+    pos_p = registry_key_append(pos_p, conf->password, strlen(conf->password) + 1);
+    pos_p = registry_key_append(pos_p, &conf->conn_timeout_ms, sizeof(conf->conn_timeout_ms));
+    pos_p = registry_key_append(pos_p, &conf->policies, sizeof(conf->policies));
+    pos_p = registry_key_append(pos_p, &conf->use_shm, sizeof(conf->use_shm));
+    pos_p = registry_key_append(pos_p, &conf->shm_max_nodes, sizeof(conf->shm_max_nodes));
+    pos_p = registry_key_append(pos_p, &conf->shm_max_namespaces, sizeof(conf->shm_max_namespaces));
+    pos_p = registry_key_append(pos_p, conf->lua.system_path, strlen(conf->lua.system_path) + 1);
+    pos_p = registry_key_append(pos_p, conf->lua.user_path, strlen(conf->lua.user_path) + 1);
+    registry_key_append(pos_p, &conf->lua.cache_enabled, sizeof(conf->lua.cache_enabled));
+
+    *len_p = len;
+    return key_p;
+}
+
+static inline uint64_t
+registry_hash_key(const char *key_p, size_t len)
+{
+    return registry_hash_mix(registry_hash_bytes(FNV_OFFSET_BASIS, key_p, len));
+}
+
+/*
+ *******************************************************************************************************
+ * Looks a config key up in a registry table. Lock-free; a hash match is
+ * only a hit if the aerospike_ref was built from the very same key.
+ *******************************************************************************************************
+ */
+static aerospike_ref *
+registry_lookup(aerospike_registry *registry_p, uint64_t hash,
+        const char *key_p, size_t len)
+{
+    aerospike_ref   *ref_p = NULL;
+    uint32_t        slot = 0;
+
+    if (!registry_p) {
+        return NULL;
+    }
+    for (slot = (uint32_t) hash & (registry_p->capacity - 1);
+            NULL != (ref_p = registry_p->entries[slot].ref_p);
+            slot = (slot + 1) & (registry_p->capacity - 1)) {
+        if (registry_p->entries[slot].hash == hash &&
+                ref_p->config_key_len == len &&
+                !memcmp(ref_p->config_key_p, key_p, len)) {
+            return ref_p;
+        }
+    }
+    return NULL;
+}
+
+/*
+ *******************************************************************************************************
+ * Publishes a copy of the registry table with the new entry added. Must be
+ * called with aerospike_mutex held for writing.
+ *******************************************************************************************************
+ */
+static bool
+registry_insert(aerospike_registry **registry_pp, uint64_t hash,
+        aerospike_ref *ref_p)
+{
+    aerospike_registry  *old_p = *registry_pp;
+    aerospike_registry  *new_p = NULL;
+    uint32_t            capacity = old_p ? old_p->capacity : AEROSPIKE_REGISTRY_MIN_CAPACITY;
+    uint32_t            slot = 0;
+    uint32_t            i = 0;
+
+    if (old_p && ((old_p->size + 1) * 2 > capacity)) {
+        capacity *= 2;
+    }
+    if (NULL == (new_p = pecalloc(1, sizeof(aerospike_registry) +
+                    (capacity - 1) * sizeof(aerospike_registry_entry), 1))) {
+        return false;
+    }
+    new_p->capacity = capacity;
+    new_p->retired_p = old_p;
+
+    for (i = 0; old_p && i < old_p->capacity; i++) {
+        if (old_p->entries[i].ref_p) {
+            for (slot = (uint32_t) old_p->entries[i].hash & (capacity - 1);
+                    new_p->entries[slot].ref_p; slot = (slot + 1) & (capacity - 1));
+            new_p->entries[slot] = old_p->entries[i];
+            new_p->size++;
+        }
+    }
+    for (slot = (uint32_t) hash & (capacity - 1);
+            new_p->entries[slot].ref_p; slot = (slot + 1) & (capacity - 1));
+    new_p->entries[slot].hash = hash;
+    new_p->entries[slot].ref_p = ref_p;
+    new_p->size++;
 
-#define MAX_PORT_SIZE 6
+    __atomic_store_n(registry_pp, new_p, __ATOMIC_RELEASE);
+    return true;
+}
 
 /*
  *******************************************************************************************************
- * Function to retrieve a C Client's aerospike object either from the zend
- * persistent store if an already hashed object (with the addr+port as the hash) exists, or by
- * creating a new aerospike object if it doesn't and pushing it on the zend persistent store
- * for further reuse.
+ * Frees the registry table and the tables it replaced. To be called before
+ * the persistent list owning the aerospike_refs is destroyed.
+ *
+ * @param registry_pp           The registry of the module globals.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_helper_registry_destroy(aerospike_registry **registry_pp)
+{
+    aerospike_registry  *registry_p = *registry_pp;
+    aerospike_registry  *retired_p = NULL;
+
+    *registry_pp = NULL;
+    while (registry_p) {
+        retired_p = registry_p->retired_p;
+        pefree(registry_p, 1);
+        registry_p = retired_p;
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Checks whether an aerospike_ref is one of the given aerospike_refs.
+ *******************************************************************************************************
+ */
+static bool
+registry_refs_contain(aerospike_ref **refs_pp, uint32_t refs_count,
+        aerospike_ref *ref_p)
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < refs_count; i++) {
+        if (refs_pp[i] == ref_p) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*
+ *******************************************************************************************************
+ * Publishes a copy of the registry table without the entries of the given
+ * aerospike_refs. Must be called with aerospike_mutex held for writing.
+ *******************************************************************************************************
+ */
+static bool
+registry_remove(aerospike_registry **registry_pp, aerospike_ref **refs_pp,
+        uint32_t refs_count)
+{
+    aerospike_registry  *old_p = *registry_pp;
+    aerospike_registry  *new_p = NULL;
+    uint32_t            slot = 0;
+    uint32_t            i = 0;
+
+    if (!old_p) {
+        return true;
+    }
+    if (NULL == (new_p = pecalloc(1, sizeof(aerospike_registry) +
+                    (old_p->capacity - 1) * sizeof(aerospike_registry_entry), 1))) {
+        return false;
+    }
+    new_p->capacity = old_p->capacity;
+    new_p->retired_p = old_p;
+
+    for (i = 0; i < old_p->capacity; i++) {
+        if ((!old_p->entries[i].ref_p) ||
+                registry_refs_contain(refs_pp, refs_count, old_p->entries[i].ref_p)) {
+            continue;
+        }
+        for (slot = (uint32_t) old_p->entries[i].hash & (new_p->capacity - 1);
+                new_p->entries[slot].ref_p; slot = (slot + 1) & (new_p->capacity - 1));
+        new_p->entries[slot] = old_p->entries[i];
+        new_p->size++;
+    }
+
+    __atomic_store_n(registry_pp, new_p, __ATOMIC_RELEASE);
+    return true;
+}
+
+/*
+ *******************************************************************************************************
+ * Adds a new aerospike_ref to the persistent list, which owns it (and
+ * destroys it on shutdown) under the config key as its alias, and publishes
+ * it in the registry. The aerospike_ref keeps a copy of the key. Must be
+ * called with aerospike_mutex held for writing.
+ *******************************************************************************************************
+ */
+static void
+registry_add(HashTable *persistent_list, int val_persist, uint64_t hash,
+        const char *key_p, size_t len, aerospike_ref *ref_p TSRMLS_DC)
+{
+    zend_rsrc_list_entry    new_le;
+    zval                    *rsrc_result = NULL;
+
+    ZEND_REGISTER_RESOURCE(rsrc_result, ref_p->as_p, val_persist);
+    new_le.ptr = ref_p;
+    new_le.type = val_persist;
+
+    ref_p->config_key_p = pemalloc(len, 1);
+    memcpy(ref_p->config_key_p, key_p, len);
+    ref_p->config_key_len = len;
+
+    zend_hash_add(persistent_list, ref_p->config_key_p, len,
+            (void *) &new_le, sizeof(zend_rsrc_list_entry), NULL);
+    ref_p->ref_hosts_entry++;
+
+    if (!registry_insert(&AEROSPIKE_G(registry_g), hash, ref_p)) {
+        DEBUG_PHP_EXT_WARNING("Unable to register the persistent connection");
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Function to retrieve a C Client's aerospike object either from the
+ * registry of persistent objects if one was created from the same config,
+ * or by creating a new aerospike object if it doesn't and pushing it on the
+ * zend persistent store for further reuse.
  * 
  * @param as_object_p               The instance of Aerospike_object structure containing 
  *                                  the C Client's aerospike object.
@@ -248,14 +486,11 @@ aerospike_helper_object_from_alias_hash(Aerospike_object* as_object_p,
                                         HashTable *persistent_list,
                                         int val_persist TSRMLS_DC)
 {
-    zend_rsrc_list_entry *le, new_le;
-    zval* rsrc_result = NULL;
     as_status status = AEROSPIKE_OK;
-    int itr_user = 0, itr_stored = 0;
     aerospike_ref *tmp_ref = NULL;
-    char *alias_to_search = NULL;
-    char *alias_to_hash = NULL;
-    char port[MAX_PORT_SIZE];
+    uint64_t hash = 0;
+    char *key_p = NULL;
+    size_t key_len = 0;
 
     if (!(as_object_p) && !(conf)) {
         status = AEROSPIKE_ERR_PARAM;
@@ -267,83 +502,348 @@ aerospike_helper_object_from_alias_hash(Aerospike_object* as_object_p,
         goto exit;
     }
 
-    /*
-     * Iterate over list of hosts and check if the one of them is already
-     * hashed and can be reused.
-     */
+    key_p = registry_config_key(conf, &key_len);
+    hash = registry_hash_key(key_p, key_len);
 
-    for (itr_user=0; itr_user < conf->hosts_size; itr_user++) {
-        alias_to_search = (char*) emalloc(strlen(conf->hosts[itr_user].addr) + MAX_PORT_SIZE + 1);
-        sprintf(port, "%d", conf->hosts[itr_user].port);
-        strcpy(alias_to_search, conf->hosts[itr_user].addr);
-        strcat(alias_to_search, ":");
-        strcat(alias_to_search, port);
-        pthread_rwlock_rdlock(&AEROSPIKE_G(aerospike_mutex));
-        if (zend_hash_find(persistent_list, alias_to_search,
-                strlen(alias_to_search), (void **) &le) == SUCCESS) {
-            if (alias_to_search) {
-                efree(alias_to_search);
-                alias_to_search = NULL;
-            }
-            pthread_rwlock_unlock(&AEROSPIKE_G(aerospike_mutex));
-            tmp_ref = le->ptr;
-            goto use_existing;
-        }
-        pthread_rwlock_unlock(&AEROSPIKE_G(aerospike_mutex));
-        if (alias_to_search) {
-            efree(alias_to_search);
-            alias_to_search = NULL;
-        }
+    if (NULL != (tmp_ref = registry_lookup(
+                    __atomic_load_n(&AEROSPIKE_G(registry_g), __ATOMIC_ACQUIRE),
+                    hash, key_p, key_len))) {
+        goto use_existing;
     }
 
-    alias_to_search = (char*) emalloc(strlen(conf->hosts[0].addr) + MAX_PORT_SIZE + 1);
-    sprintf(port, "%d", conf->hosts[0].port);
-    strcpy(alias_to_search, conf->hosts[0].addr);
-    strcat(alias_to_search, ":");
-    strcat(alias_to_search, port);
-    ZEND_HASH_CREATE_ALIAS_NEW(alias_to_search, strlen(alias_to_search), 1);
-
-    /*
-     * Iterate over remaining list of hosts and hash them into the persistent
-     * list, each pointing to the same aerospike_ref object.
-     * Increment corresponding ref_hosts_entry within the aerospike_ref object.
-     */
-
-    for (itr_user=1; itr_user < conf->hosts_size; itr_user++ ) {
-        alias_to_hash = (char*) emalloc(strlen(conf->hosts[itr_user].addr) + MAX_PORT_SIZE + 1);
-        sprintf(port, "%d", conf->hosts[itr_user].port);
-        strcpy(alias_to_hash, conf->hosts[itr_user].addr);
-        strcat(alias_to_hash, ":");
-        strcat(alias_to_hash, port);
-        pthread_rwlock_wrlock(&AEROSPIKE_G(aerospike_mutex));
-        zend_hash_add(persistent_list, alias_to_hash,
-                strlen(alias_to_hash), (void *) &new_le, sizeof(zend_rsrc_list_entry), NULL);
-        ((aerospike_ref *) new_le.ptr)->ref_hosts_entry++;
+    pthread_rwlock_wrlock(&AEROSPIKE_G(aerospike_mutex));
+    if (NULL != (tmp_ref = registry_lookup(AEROSPIKE_G(registry_g), hash,
+                    key_p, key_len))) {
         pthread_rwlock_unlock(&AEROSPIKE_G(aerospike_mutex));
-        efree(alias_to_hash);
-        alias_to_hash = NULL;
+        goto use_existing;
     }
+
+    ZEND_CREATE_AEROSPIKE_REFERENCE_OBJECT();
+    registry_add(persistent_list, val_persist, hash, key_p, key_len,
+            as_object_p->as_ref_p TSRMLS_CC);
+    pthread_rwlock_unlock(&AEROSPIKE_G(aerospike_mutex));
     goto exit;
 
 use_existing:
     /*
      * config details have matched, use the existing one obtained from the
-     * storage.
+     * registry.
      * Increment corresponding ref_as_p of the aerospike_ref object.
      */
     as_object_p->is_conn_16 = AEROSPIKE_CONN_STATE_TRUE;
     as_object_p->as_ref_p = tmp_ref;
     as_object_p->as_ref_p->ref_as_p++;
+    as_object_p->as_ref_p->last_used = time(NULL);
+    aerospike_info_shm_observe(as_object_p->as_ref_p);
     DEBUG_PHP_EXT_DEBUG("\nCount is: %d",as_object_p->as_ref_p->ref_as_p);
-    goto exit;
 exit:
-    if (alias_to_search) {
-        efree(alias_to_search);
-        alias_to_search = NULL;
+    if (key_p) {
+        efree(key_p);
     }
     return (status);
 }
 
+/*
+ *******************************************************************************************************
+ * Thread of the socket warm-up of aerospike_helper_preconnect(). The threads
+ * wait until all are started and then each send an info request to all the
+ * nodes, so that the requests overlap and each takes a socket of its own
+ * from the node's pool, where it is returned when done.
+ *******************************************************************************************************
+ */
+typedef struct preconnect_warmer_s {
+    aerospike           *as_p;
+    pthread_mutex_t     lock;
+    pthread_cond_t      start;
+    bool                started;
+    uint32_t            failed;
+    char                message[AS_ERROR_MESSAGE_MAX_SIZE];
+} preconnect_warmer;
+
+static bool
+preconnect_info_callback(const as_error *err, const as_node *node,
+        const char *req, char *res, void *udata)
+{
+    return true;
+}
+
+static void *
+preconnect_warm_sockets(void *udata)
+{
+    preconnect_warmer   *warmer_p = (preconnect_warmer *) udata;
+    as_error            error;
+
+    pthread_mutex_lock(&warmer_p->lock);
+    while (!warmer_p->started) {
+        pthread_cond_wait(&warmer_p->start, &warmer_p->lock);
+    }
+    pthread_mutex_unlock(&warmer_p->lock);
+    if (AEROSPIKE_OK != aerospike_info_foreach(warmer_p->as_p, &error, NULL,
+                "node", preconnect_info_callback, NULL)) {
+        /* reported by the PHP thread, once the warm-up is over */
+        pthread_mutex_lock(&warmer_p->lock);
+        warmer_p->failed++;
+        strncpy(warmer_p->message, error.message, sizeof(warmer_p->message) - 1);
+        warmer_p->message[sizeof(warmer_p->message) - 1] = '\0';
+        pthread_mutex_unlock(&warmer_p->lock);
+    }
+    return NULL;
+}
+
+/*
+ *******************************************************************************************************
+ * Connects one cluster of aerospike.preconnect and registers it as a
+ * persistent connection, built from the same as_config as
+ * Aerospike::__construct() with these hosts and no options would use.
+ *
+ * @param hosts_p               The comma separated addr:port of the seeds,
+ *                              modified by the parsing.
+ * @param sockets               The number of sockets to open per node.
+ *******************************************************************************************************
+ */
+static void
+preconnect_cluster(char *hosts_p, uint32_t sockets TSRMLS_DC)
+{
+    as_config           config;
+    as_error            error;
+    aerospike_ref       *ref_p = NULL;
+    preconnect_warmer   warmer;
+    pthread_t           *threads_p = NULL;
+    char                *host_p = NULL;
+    char                *port_p = NULL;
+    char                *saved = NULL;
+    uint32_t            started = 0;
+    uint32_t            i = 0;
+    uint64_t            hash = 0;
+    char                *key_p = NULL;
+    size_t              key_len = 0;
+
+    memset(&config, 0, sizeof(as_config));
+    as_config_init(&config);
+    strcpy(config.lua.system_path, LUA_SYSTEM_PATH_PHP_INI);
+    strcpy(config.lua.user_path, LUA_USER_PATH_PHP_INI);
+    config.lua.cache_enabled = LUA_CACHE_ENABLED_PHP_INI;
+    aerospike_helper_check_and_configure_shm(&config TSRMLS_CC);
+    as_error_init(&error);
+
+    for (host_p = strtok_r(hosts_p, HOST_DELIMITER, &saved); host_p;
+            host_p = strtok_r(NULL, HOST_DELIMITER, &saved)) {
+        while (isspace(*host_p)) {
+            host_p++;
+        }
+        if ((NULL == (port_p = strrchr(host_p, ':'))) || (port_p == host_p) ||
+                (config.hosts_size == AS_CONFIG_HOSTS_SIZE)) {
+            php_error_docref(NULL TSRMLS_CC, E_WARNING,
+                    "Invalid host %s in aerospike.preconnect", host_p);
+            goto exit;
+        }
+        *port_p++ = '\0';
+        config.hosts[config.hosts_size].addr = pestrdup(host_p, 1);
+        config.hosts[config.hosts_size].port = atoi(port_p);
+        config.hosts_size++;
+    }
+    if (!config.hosts_size) {
+        goto exit;
+    }
+
+    set_general_policies(&config, NULL, &error TSRMLS_CC);
+    if (AEROSPIKE_OK != error.code) {
+        php_error_docref(NULL TSRMLS_CC, E_WARNING,
+                "Unable to set policies for aerospike.preconnect: %s", error.message);
+        goto exit;
+    }
+
+    key_p = registry_config_key(&config, &key_len);
+    hash = registry_hash_key(key_p, key_len);
+    if (registry_lookup(AEROSPIKE_G(registry_g), hash, key_p, key_len)) {
+        /* already connected by this process */
+        goto exit;
+    }
+
+    /*
+     * Unlike Aerospike::__construct() the cluster is only registered once
+     * connected, so that a failed preconnect leaves nothing behind.
+     */
+    if ((NULL == (ref_p = pecalloc(1, sizeof(aerospike_ref), 1))) ||
+            (NULL == (ref_p->as_p = aerospike_new(&config)))) {
+        php_error_docref(NULL TSRMLS_CC, E_WARNING,
+                "Unable to create a cluster of aerospike.preconnect");
+        goto exit;
+    }
+    /* the aerospike object owns the hosts from now on */
+    config.hosts_size = 0;
+    ref_p->created = time(NULL);
+    ref_p->last_used = ref_p->created;
+
+    if (AEROSPIKE_OK != aerospike_connect(ref_p->as_p, &error)) {
+        php_error_docref(NULL TSRMLS_CC, E_WARNING,
+                "Unable to connect to a cluster of aerospike.preconnect: %s",
+                error.message);
+        goto exit;
+    }
+
+    if (sockets >= 1) {
+        threads_p = emalloc(sockets * sizeof(pthread_t));
+        warmer.as_p = ref_p->as_p;
+        warmer.started = false;
+        warmer.failed = 0;
+        warmer.message[0] = '\0';
+        pthread_mutex_init(&warmer.lock, NULL);
+        pthread_cond_init(&warmer.start, NULL);
+        for (started = 0; started < sockets; started++) {
+            if (0 != pthread_create(&threads_p[started], NULL,
+                        preconnect_warm_sockets, &warmer)) {
+                php_error_docref(NULL TSRMLS_CC, E_WARNING,
+                        "Unable to start the socket warm-up of aerospike.preconnect");
+                break;
+            }
+        }
+        pthread_mutex_lock(&warmer.lock);
+        warmer.started = true;
+        pthread_cond_broadcast(&warmer.start);
+        pthread_mutex_unlock(&warmer.lock);
+        for (i = 0; i < started; i++) {
+            pthread_join(threads_p[i], NULL);
+        }
+        if (warmer.failed) {
+            php_error_docref(NULL TSRMLS_CC, E_WARNING,
+                    "%u of %u socket warm-ups of aerospike.preconnect failed: %s",
+                    warmer.failed, started, warmer.message);
+        }
+        pthread_cond_destroy(&warmer.start);
+        pthread_mutex_destroy(&warmer.lock);
+        efree(threads_p);
+    }
+
+    /* no PHP object holds the preconnected cluster, so ref_as_p stays 0 */
+    pthread_rwlock_wrlock(&AEROSPIKE_G(aerospike_mutex));
+    registry_add(AEROSPIKE_G(persistent_list_g), persist, hash, key_p, key_len,
+            ref_p TSRMLS_CC);
+    pthread_rwlock_unlock(&AEROSPIKE_G(aerospike_mutex));
+    ref_p = NULL;
+exit:
+    if (ref_p) {
+        if (ref_p->as_p) {
+            for (i = 0; i < ref_p->as_p->config.hosts_size; i++) {
+                pefree((char *) ref_p->as_p->config.hosts[i].addr, 1);
+            }
+            aerospike_close(ref_p->as_p, &error);
+            aerospike_destroy(ref_p->as_p);
+        }
+        pefree(ref_p, 1);
+    }
+    for (i = 0; i < config.hosts_size; i++) {
+        pefree((char *) config.hosts[i].addr, 1);
+    }
+    if (key_p) {
+        efree(key_p);
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Connects the clusters listed in aerospike.preconnect, so that the first
+ * Aerospike::__construct() of the process finds them connected in the
+ * registry of persistent connections. The clusters are separated by ';',
+ * each a comma separated list of addr:port.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_helper_preconnect(TSRMLS_D)
+{
+    char        *clusters_p = PRECONNECT_PHP_INI;
+    char        *copy_p = NULL;
+    char        *cluster_p = NULL;
+    char        *saved = NULL;
+    long        sockets = PRECONNECT_SOCKETS_PHP_INI;
+
+    if ((!clusters_p) || (!*clusters_p)) {
+        return;
+    }
+
+    copy_p = estrdup(clusters_p);
+    for (cluster_p = strtok_r(copy_p, CLUSTER_DELIMITER, &saved); cluster_p;
+            cluster_p = strtok_r(NULL, CLUSTER_DELIMITER, &saved)) {
+        preconnect_cluster(cluster_p, (sockets > 0) ? (uint32_t) sockets : 0 TSRMLS_CC);
+    }
+    efree(copy_p);
+}
+
+/*
+ *******************************************************************************************************
+ * Closes and destroys the persistent connections that no PHP object holds
+ * (ref_as_p is 0) and that have been idle for longer than
+ * aerospike.persistent.idle_timeout_sec, or that are older than
+ * aerospike.persistent.max_age_sec. Called at RSHUTDOWN: the registry and the
+ * persistent list are module globals of this thread, so no lookup of this
+ * thread can race the reaping, and the tables retired by the registry are
+ * freed here as well.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_helper_reap_persistent(TSRMLS_D)
+{
+    aerospike_registry  *registry_p = AEROSPIKE_G(registry_g);
+    aerospike_registry  *retired_p = NULL;
+    aerospike_ref       *ref_p = NULL;
+    aerospike_ref       **reaped_pp = NULL;
+    uint32_t            reaped_count = 0;
+    uint32_t            i = 0;
+    long                idle_timeout = PERSISTENT_IDLE_TIMEOUT_SEC_PHP_INI;
+    long                max_age = PERSISTENT_MAX_AGE_SEC_PHP_INI;
+    time_t              now = 0;
+
+    if ((!registry_p) || (idle_timeout <= 0 && max_age <= 0)) {
+        return;
+    }
+
+    now = time(NULL);
+    for (i = 0; i < registry_p->capacity; i++) {
+        if (NULL == (ref_p = registry_p->entries[i].ref_p)) {
+            continue;
+        }
+        if (ref_p->ref_as_p > 0) {
+            ref_p->last_used = now;
+            continue;
+        }
+        if ((idle_timeout > 0 && now - ref_p->last_used >= idle_timeout) ||
+                (max_age > 0 && now - ref_p->created >= max_age)) {
+            if (!reaped_pp) {
+                reaped_pp = emalloc(registry_p->size * sizeof(aerospike_ref *));
+            }
+            reaped_pp[reaped_count++] = ref_p;
+        }
+    }
+    if (!reaped_count) {
+        return;
+    }
+
+    pthread_rwlock_wrlock(&AEROSPIKE_G(aerospike_mutex));
+    if (registry_remove(&AEROSPIKE_G(registry_g), reaped_pp, reaped_count)) {
+        for (i = 0; i < registry_p->capacity; i++) {
+            ref_p = registry_p->entries[i].ref_p;
+            if ((!ref_p) || (!registry_refs_contain(reaped_pp, reaped_count, ref_p))) {
+                continue;
+            }
+            DEBUG_PHP_EXT_DEBUG("Reaping persistent connection, idle for %ld seconds",
+                    (long) (now - ref_p->last_used));
+            /* the persistent list destructor closes and destroys the ref */
+            zend_hash_del(AEROSPIKE_G(persistent_list_g), ref_p->config_key_p,
+                    ref_p->config_key_len);
+        }
+
+        registry_p = AEROSPIKE_G(registry_g);
+        while (NULL != (retired_p = registry_p->retired_p)) {
+            registry_p->retired_p = retired_p->retired_p;
+            pefree(retired_p, 1);
+        }
+    } else {
+        DEBUG_PHP_EXT_WARNING("Unable to reap the idle persistent connections");
+    }
+    pthread_rwlock_unlock(&AEROSPIKE_G(aerospike_mutex));
+    efree(reaped_pp);
+}
+
 /*
  *******************************************************************************************************
  * Function to destroy all as_* types initiated within the as_static_pool.
@@ -382,42 +882,22 @@ aerospike_helper_free_static_pool(as_static_pool *static_pool)
 
 /*
  *******************************************************************************************************
- * Callback for as_scan_foreach and as_query_foreach functions.
- * It processes the as_val and translates it into an equivalent zval array.
- * It then calls the user registered callback passing the zval array as an
- * argument.
+ * Translates a record of a scan or query stream into the array passed to
+ * the user: key, metadata and bins.
  *
- * @param p_val             The current as_val to be passed on to the user
- *                          callback as an argument.
- * @param udata             The userland_callback instance filled with fci and
- *                          fcc.
- * @return true if callback is successful; else false.
+ * @param current_as_rec    The current record of the stream.
+ * @param outer_container_p An initialized array zval to be populated.
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
  *******************************************************************************************************
  */
-extern bool
-aerospike_helper_record_stream_callback(const as_val* p_val, void* udata)
+extern as_status
+aerospike_helper_record_stream_to_zval(as_record* current_as_rec,
+        zval* outer_container_p TSRMLS_DC)
 {
     as_status               status = AEROSPIKE_OK;
     as_error                error;
-    userland_callback       *user_func_p;
-    zend_fcall_info         *fci_p = NULL;
-    zend_fcall_info_cache   *fcc_p = NULL;
     zval                    *record_p = NULL;
-    zval                    **args[1];
-    zval                    *retval = NULL;
-    bool                    do_continue = true;
     foreach_callback_udata  foreach_record_callback_udata;
-    zval                    *outer_container_p = NULL;
-    TSRMLS_FETCH();
-    if (!p_val) {
-        DEBUG_PHP_EXT_INFO("callback is null; stream complete.");
-        return true;
-    }
-    as_record* current_as_rec = as_record_fromval(p_val);
-    if (!current_as_rec) {
-        DEBUG_PHP_EXT_WARNING("stream returned a non-as_record object to the callback.");
-        return true;
-    }
 
     MAKE_STD_ZVAL(record_p);
     array_init(record_p);
@@ -428,46 +908,61 @@ aerospike_helper_record_stream_callback(const as_val* p_val, void* udata)
         &foreach_record_callback_udata)) {
         DEBUG_PHP_EXT_WARNING("stream callback failed to transform the as_record to an array zval.");
         zval_ptr_dtor(&record_p);
-        return true;
+        return AEROSPIKE_ERR;
     }
 
-    MAKE_STD_ZVAL(outer_container_p);
-    array_init(outer_container_p);
-
     if (AEROSPIKE_OK != (status = aerospike_get_key_meta_bins_of_record(current_as_rec,
                     &(current_as_rec->key), outer_container_p, NULL, false TSRMLS_CC))) {
         DEBUG_PHP_EXT_DEBUG("Unable to get a record and metadata");
         zval_ptr_dtor(&record_p);
-        zval_ptr_dtor(&outer_container_p);
-        return true;
+        return status;
     }
 
     if (0 != add_assoc_zval(outer_container_p, PHP_AS_RECORD_DEFINE_FOR_BINS, record_p)) {
         DEBUG_PHP_EXT_DEBUG("Unable to get a record");
         zval_ptr_dtor(&record_p);
-        zval_ptr_dtor(&outer_container_p);
-        return true;
+        return AEROSPIKE_ERR;
     }
+    return AEROSPIKE_OK;
+}
+
+/*
+ *******************************************************************************************************
+ * Calls the userland callback of a scan or query stream with one argument
+ * (a record, or an array of records when OPT_CALLBACK_BATCH_SIZE is set).
+ * Must be called from the PHP thread (see aerospike_stream_run).
+ *
+ * @param arg_p             The argument to be passed to the user callback.
+ * @param user_func_p       The userland_callback instance filled with fci and
+ *                          fcc.
+ * @return false if the user callback asked to stop the stream; else true.
+ *******************************************************************************************************
+ */
+extern bool
+aerospike_helper_record_stream_call(zval* arg_p,
+        userland_callback* user_func_p TSRMLS_DC)
+{
+    zend_fcall_info         *fci_p = NULL;
+    zend_fcall_info_cache   *fcc_p = NULL;
+    zval                    **args[1];
+    zval                    *retval = NULL;
+    bool                    do_continue = true;
 
     /*
-     * Call the userland function with the array representing the record.
+     * Call the userland function with the array representing the record(s).
      */
-    user_func_p = (userland_callback *) udata;
     fci_p = user_func_p->fci_p;
     fcc_p = user_func_p->fcc_p;
-    args[0] = &outer_container_p;
+    args[0] = &arg_p;
     fci_p->param_count = 1;
     fci_p->params = args;
     fci_p->retval_ptr_ptr = &retval;
     if (zend_call_function(fci_p, fcc_p TSRMLS_CC) == FAILURE) {
         DEBUG_PHP_EXT_WARNING("stream callback could not invoke the userland function.");
         php_error_docref(NULL TSRMLS_CC, E_WARNING, "stream callback could not invoke userland function.");
-        zval_ptr_dtor(&outer_container_p);
         return true;
     }
 
-    zval_ptr_dtor(&outer_container_p);
-
     if (retval) {
         if ((Z_TYPE_P(retval) == IS_BOOL) && !Z_BVAL_P(retval)) {
             do_continue = false;
@@ -479,6 +974,41 @@ aerospike_helper_record_stream_callback(const as_val* p_val, void* udata)
     return do_continue;
 }
 
+/*
+ *******************************************************************************************************
+ * Dispatches a record of a scan or query stream to the userland callback.
+ * It translates the as_record into an equivalent zval array and calls the
+ * user registered callback passing the zval array as an argument.
+ * Must be called from the PHP thread (see aerospike_stream_run).
+ *
+ * @param current_as_rec    The current record of the stream.
+ * @param user_func_p       The userland_callback instance filled with fci and
+ *                          fcc.
+ * @return false if the user callback asked to stop the stream; else true.
+ *******************************************************************************************************
+ */
+extern bool
+aerospike_helper_record_stream_dispatch(as_record* current_as_rec,
+        userland_callback* user_func_p TSRMLS_DC)
+{
+    bool                    do_continue = true;
+    zval                    *outer_container_p = NULL;
+
+    MAKE_STD_ZVAL(outer_container_p);
+    array_init(outer_container_p);
+
+    if (AEROSPIKE_OK != aerospike_helper_record_stream_to_zval(current_as_rec,
+                outer_container_p TSRMLS_CC)) {
+        zval_ptr_dtor(&outer_container_p);
+        return true;
+    }
+
+    do_continue = aerospike_helper_record_stream_call(outer_container_p,
+            user_func_p TSRMLS_CC);
+    zval_ptr_dtor(&outer_container_p);
+    return do_continue;
+}
+
 /*
  *******************************************************************************************************
  * Callback for as_query_foreach function in case of Aerospike::aggregate().
@@ -603,10 +1133,108 @@ trim_white_space(const char *str, size_t len)
     return out_size;
 }
 
+/*
+ *******************************************************************************************************
+ * Function to parse the options of the session save path, the optional
+ * fourth segment of it: name=value pairs separated by '&'.
+ *
+ * @param options_p         The options segment, modified by the parsing.
+ * @param session_p         The aerospike_session object whose options are
+ *                          to be set.
+ * @param error_p           The C SDK's as_error object to be populated by this
+ *                          method in case of any errors if encountered.
+ *
+ * @return AEROSPIKE::OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+static as_status
+parse_save_path_options(char *options_p, aerospike_session *session_p,
+        as_error *error_p TSRMLS_DC)
+{
+    char        *tok = NULL;
+    char        *saved = NULL;
+    char        *value_p = NULL;
+
+    for (tok = strtok_r(options_p, SAVE_PATH_OPTION_DELIMITER, &saved); tok;
+            tok = strtok_r(NULL, SAVE_PATH_OPTION_DELIMITER, &saved)) {
+        if (NULL == (value_p = strchr(tok, '='))) {
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                    "SAVE_PATH options must be given as name=value");
+            DEBUG_PHP_EXT_DEBUG("SAVE_PATH option %s has no value", tok);
+            goto exit;
+        }
+        *value_p++ = '\0';
+
+        if (!strcmp(tok, "lazy_touch")) {
+            session_p->lazy_touch_sec = (uint32_t) strtoul(value_p, NULL, 10);
+        } else if (!strcmp(tok, "concurrency")) {
+            if (!strcmp(value_p, "generation")) {
+                session_p->check_gen = true;
+            } else if (!strcmp(value_p, "none")) {
+                session_p->check_gen = false;
+            } else {
+                PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                        "SAVE_PATH option concurrency must be generation or none");
+                DEBUG_PHP_EXT_DEBUG("Invalid SAVE_PATH concurrency %s", value_p);
+                goto exit;
+            }
+        } else if (!strcmp(tok, "conflict")) {
+            if (!strcmp(value_p, "merge")) {
+                session_p->merge_on_conflict = true;
+            } else if (!strcmp(value_p, "fail")) {
+                session_p->merge_on_conflict = false;
+            } else {
+                PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                        "SAVE_PATH option conflict must be merge or fail");
+                DEBUG_PHP_EXT_DEBUG("Invalid SAVE_PATH conflict %s", value_p);
+                goto exit;
+            }
+        } else if (!strcmp(tok, "encoding")) {
+            if (!strcmp(value_p, "bytes")) {
+                session_p->bytes_encoding = true;
+            } else if (!strcmp(value_p, "string")) {
+                session_p->bytes_encoding = false;
+            } else {
+                PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                        "SAVE_PATH option encoding must be string or bytes");
+                DEBUG_PHP_EXT_DEBUG("Invalid SAVE_PATH encoding %s", value_p);
+                goto exit;
+            }
+        } else if (!strcmp(tok, "compress")) {
+            session_p->compress_threshold = (uint32_t) strtoul(value_p, NULL, 10);
+        } else if (!strcmp(tok, "read_touch")) {
+            session_p->read_touch = (0 != strtoul(value_p, NULL, 10));
+        } else if (!strcmp(tok, "read_timeout")) {
+            session_p->read_timeout_ms = (uint32_t) strtoul(value_p, NULL, 10);
+        } else if (!strcmp(tok, "write_timeout")) {
+            session_p->write_timeout_ms = (uint32_t) strtoul(value_p, NULL, 10);
+        } else if (!strcmp(tok, "replica")) {
+            if (!strcmp(value_p, "master")) {
+                session_p->replica = AS_POLICY_REPLICA_MASTER;
+            } else if (!strcmp(value_p, "any")) {
+                session_p->replica = AS_POLICY_REPLICA_ANY;
+            } else {
+                PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                        "SAVE_PATH option replica must be master or any");
+                DEBUG_PHP_EXT_DEBUG("Invalid SAVE_PATH replica %s", value_p);
+                goto exit;
+            }
+        } else {
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                    "Unknown SAVE_PATH option");
+            DEBUG_PHP_EXT_DEBUG("Unknown SAVE_PATH option %s", tok);
+            goto exit;
+        }
+    }
+
+exit:
+    return error_p->code;
+}
+
 /*
  *******************************************************************************************************
  * Function to parse the session save path.
- * It sets the ns and set in aerospike_session by allocating memory to it.
+ * It sets the ns, set and options in aerospike_session.
  * It also sets the host within as_config.
  *
  * @param save_path         The session save path to be parsed.
@@ -626,7 +1254,9 @@ parse_save_path(char *save_path, aerospike_session *session_p,
 {
     char        *tok = NULL;
     char        *saved = NULL;
-    char        port[INET_PORT];
+    char        *hosts_p = NULL;
+    char        *hosts_saved = NULL;
+    char        *options_p = NULL;
     int16_t     iter_host = 0;
     char        *copy = NULL;
     
@@ -656,8 +1286,12 @@ parse_save_path(char *save_path, aerospike_session *session_p,
     strncpy(session_p->set_p, tok, strlen(tok));
     session_p->set_p[strlen(tok)] = '\0';
 
+    hosts_p = strtok_r(NULL, SAVE_PATH_DELIMITER, &saved);
+    options_p = strtok_r(NULL, SAVE_PATH_DELIMITER, &saved);
+
+    tok = hosts_p;
     while (tok != NULL) {
-        tok = strtok_r(NULL, IP_PORT_DELIMITER, &saved);
+        tok = strtok_r(iter_host ? NULL : hosts_p, IP_PORT_DELIMITER, &hosts_saved);
         if (tok == NULL) {
             if (iter_host == 0) {
                 PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
@@ -673,7 +1307,7 @@ parse_save_path(char *save_path, aerospike_session *session_p,
         strncpy(addr, tok, strlen(tok) + 1);
         config_p->hosts[iter_host].addr = addr;
 
-        tok = strtok_r(NULL, HOST_DELIMITER, &saved);
+        tok = strtok_r(NULL, HOST_DELIMITER, &hosts_saved);
         if (tok == NULL) {
             if (iter_host == 0) {
                 PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
@@ -690,6 +1324,23 @@ parse_save_path(char *save_path, aerospike_session *session_p,
         iter_host++;
     }
 
+    if (iter_host == 0) {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
+                "Could not read SAVE_PATH settings");
+        DEBUG_PHP_EXT_DEBUG("Could not read SAVE_PATH settings");
+        goto exit;
+    }
+
+    if (options_p && AEROSPIKE_OK != parse_save_path_options(options_p,
+                session_p, error_p TSRMLS_CC)) {
+        goto exit;
+    }
+
+    if (session_p->compress_threshold > 0) {
+        /* compressed data can only be stored as bytes */
+        session_p->bytes_encoding = true;
+    }
+
 exit:
     if (copy) {
         efree(copy);
@@ -725,9 +1376,11 @@ aerospike_helper_check_and_set_config_for_session(as_config *config_p,
 
     as_error_init(error_p);
 
+    memset(config_p, 0, sizeof(as_config));
     as_config_init(config_p);
     strcpy(config_p->lua.system_path, LUA_SYSTEM_PATH_PHP_INI);
     strcpy(config_p->lua.user_path, LUA_USER_PATH_PHP_INI);
+    config_p->lua.cache_enabled = LUA_CACHE_ENABLED_PHP_INI;
 
     if (!strncmp(SAVE_HANDLER_PHP_INI, AEROSPIKE_SESSION, AEROSPIKE_SESSION_LEN)) {
         if (!save_path) {
@@ -753,3 +1406,56 @@ aerospike_helper_check_and_set_config_for_session(as_config *config_p,
 exit:
     return error_p->code;
 }
+
+/*
+ *******************************************************************************************************
+ * Describes the persistent cluster clients of the process: how many PHP
+ * objects hold each one, and its age, idle time and shared memory use.
+ *
+ * @param return_p          An initialized array zval to be populated.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_helper_persistent_info(zval *return_p TSRMLS_DC)
+{
+    aerospike_registry  *registry_p = __atomic_load_n(&AEROSPIKE_G(registry_g),
+                                                      __ATOMIC_ACQUIRE);
+    aerospike_ref       *ref_p = NULL;
+    zval                *clients_p = NULL;
+    zval                *client_p = NULL;
+    time_t              now = time(NULL);
+    uint32_t            i = 0;
+    uint32_t            j = 0;
+    char                hosts[512];
+    size_t              hosts_len = 0;
+
+    MAKE_STD_ZVAL(clients_p);
+    array_init(clients_p);
+
+    for (i = 0; registry_p && i < registry_p->capacity; i++) {
+        if ((!(ref_p = registry_p->entries[i].ref_p)) || (!ref_p->as_p)) {
+            continue;
+        }
+
+        hosts[0] = '\0';
+        hosts_len = 0;
+        for (j = 0; j < ref_p->as_p->config.hosts_size && hosts_len < sizeof(hosts); j++) {
+            hosts_len += snprintf(hosts + hosts_len, sizeof(hosts) - hosts_len, "%s%s:%d",
+                    j ? "," : "", ref_p->as_p->config.hosts[j].addr,
+                    ref_p->as_p->config.hosts[j].port);
+        }
+
+        MAKE_STD_ZVAL(client_p);
+        array_init(client_p);
+        add_assoc_string(client_p, "hosts", hosts, 1);
+        add_assoc_long(client_p, "refs", (long) ref_p->ref_as_p);
+        add_assoc_long(client_p, "age_sec", (long) (now - ref_p->created));
+        add_assoc_long(client_p, "idle_sec", ref_p->ref_as_p > 0 ? 0 :
+                (long) (now - ref_p->last_used));
+        add_assoc_bool(client_p, "shm", ref_p->as_p->config.use_shm ? 1 : 0);
+        add_next_index_zval(clients_p, client_p);
+    }
+
+    add_assoc_long(return_p, "count", (long) zend_hash_num_elements(Z_ARRVAL_P(clients_p)));
+    add_assoc_zval(return_p, "clients", clients_p);
+}
@@ -0,0 +1,693 @@
+#include <string.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "php.h"
+#include "ext/json/php_json.h"
+#include "ext/standard/php_smart_str.h"
+#include "aerospike/as_log.h"
+#include "aerospike/as_error.h"
+#include "aerospike/as_status.h"
+#include "aerospike/as_key.h"
+#include "aerospike/as_record.h"
+#include "aerospike/aerospike.h"
+#include "aerospike/aerospike_key.h"
+#include "aerospike_common.h"
+#include "aerospike_policy.h"
+
+/*
+ *******************************************************************************************************
+ * Aerospike::importFile() support. The PHP thread reads and decodes the
+ * file, and translates each row into an as_record with the same rules as
+ * Aerospike::put(). The writes are then handed to a pool of worker threads,
+ * so that up to OPT_IMPORT_CONCURRENCY of them are in flight at once.
+ *
+ * The records built by the put transformation point into the decoded zval
+ * and into a static pool, so each in-flight write owns a job slot keeping
+ * them alive. Slots are only ever filled and released by the PHP thread;
+ * workers just run the write. Files may be gzip'd (detected automatically).
+ *******************************************************************************************************
+ */
+#define AEROSPIKE_IMPORT_DEFAULT_CONCURRENCY    16
+#define AEROSPIKE_IMPORT_PROGRESS_INTERVAL      10000
+#define AEROSPIKE_IMPORT_READ_SIZE              8192
+
+#define AEROSPIKE_IMPORT_RECORDS                "records"
+#define AEROSPIKE_IMPORT_WRITTEN                "written"
+#define AEROSPIKE_IMPORT_FAILED                 "failed"
+#define AEROSPIKE_IMPORT_INVALID                "invalid"
+#define AEROSPIKE_IMPORT_ERRORS                 "errors"
+
+typedef enum aerospike_import_job_state_e {
+    IMPORT_JOB_FREE,
+    IMPORT_JOB_QUEUED,
+    IMPORT_JOB_RUNNING,
+    IMPORT_JOB_DONE
+} aerospike_import_job_state;
+
+typedef struct aerospike_import_job_s {
+    aerospike_import_job_state  state;
+    zval                        *row_p;
+    as_static_pool              *static_pool_p;
+    as_record                   record;
+    as_key                      key;
+    as_status                   status;
+} aerospike_import_job;
+
+typedef struct aerospike_import_s {
+    aerospike               *as_object_p;
+    as_policy_write         write_policy;
+    pthread_mutex_t         lock;
+    pthread_cond_t          queued_cond;
+    pthread_cond_t          done_cond;
+    aerospike_import_job    *jobs_p;
+    uint32_t                n_jobs;
+    pthread_t               *workers_p;
+    uint32_t                n_workers;
+    bool                    shutdown;
+    long                    records;
+    long                    written;
+    long                    failed;
+    long                    invalid;
+    zval                    *errors_p;
+} aerospike_import;
+
+typedef struct aerospike_import_reader_s {
+    gzFile      file;
+    char        *line_p;
+    size_t      line_len;
+    size_t      line_capacity;
+} aerospike_import_reader;
+
+/*
+ *******************************************************************************************************
+ * Worker thread: runs the writes of queued jobs until shutdown.
+ *******************************************************************************************************
+ */
+static void *
+import_worker(void *udata_p)
+{
+    aerospike_import        *import_p = (aerospike_import *) udata_p;
+    aerospike_import_job    *job_p = NULL;
+    as_error                error;
+    uint32_t                i = 0;
+
+    pthread_mutex_lock(&import_p->lock);
+    while (true) {
+        job_p = NULL;
+        for (i = 0; i < import_p->n_jobs; i++) {
+            if (import_p->jobs_p[i].state == IMPORT_JOB_QUEUED) {
+                job_p = &import_p->jobs_p[i];
+                break;
+            }
+        }
+        if (!job_p) {
+            if (import_p->shutdown) {
+                break;
+            }
+            pthread_cond_wait(&import_p->queued_cond, &import_p->lock);
+            continue;
+        }
+
+        job_p->state = IMPORT_JOB_RUNNING;
+        pthread_mutex_unlock(&import_p->lock);
+
+        as_error_init(&error);
+        aerospike_key_put(import_p->as_object_p, &error, &import_p->write_policy,
+                &job_p->key, &job_p->record);
+
+        pthread_mutex_lock(&import_p->lock);
+        job_p->status = error.code;
+        job_p->state = IMPORT_JOB_DONE;
+        pthread_cond_signal(&import_p->done_cond);
+    }
+    pthread_mutex_unlock(&import_p->lock);
+    return NULL;
+}
+
+/*
+ *******************************************************************************************************
+ * Counts a failed record against its status code.
+ *******************************************************************************************************
+ */
+static void
+import_count_error(aerospike_import *import_p, as_status status TSRMLS_DC)
+{
+    zval        **count_pp = NULL;
+
+    import_p->failed++;
+    if (zend_hash_index_find(Z_ARRVAL_P(import_p->errors_p), (ulong) status,
+                (void **) &count_pp) == SUCCESS) {
+        Z_LVAL_PP(count_pp)++;
+    } else {
+        add_index_long(import_p->errors_p, (ulong) status, 1);
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Releases what a job holds, making the slot free again. PHP thread only.
+ *******************************************************************************************************
+ */
+static void
+import_job_release(aerospike_import_job *job_p)
+{
+    as_record_destroy(&job_p->record);
+    as_key_destroy(&job_p->key);
+    aerospike_helper_free_static_pool(job_p->static_pool_p);
+    memset(job_p->static_pool_p, 0, sizeof(as_static_pool));
+    if (job_p->row_p) {
+        zval_ptr_dtor(&job_p->row_p);
+        job_p->row_p = NULL;
+    }
+    job_p->state = IMPORT_JOB_FREE;
+}
+
+/*
+ *******************************************************************************************************
+ * Returns a free job slot, waiting for an in-flight write to complete if
+ * needed. Completed writes are accounted for on the way. PHP thread only.
+ *******************************************************************************************************
+ */
+static aerospike_import_job *
+import_job_acquire(aerospike_import *import_p TSRMLS_DC)
+{
+    aerospike_import_job    *job_p = NULL;
+    uint32_t                i = 0;
+
+    pthread_mutex_lock(&import_p->lock);
+    while (!job_p) {
+        for (i = 0; (!job_p) && i < import_p->n_jobs; i++) {
+            if (import_p->jobs_p[i].state == IMPORT_JOB_FREE) {
+                job_p = &import_p->jobs_p[i];
+            }
+        }
+        for (i = 0; (!job_p) && i < import_p->n_jobs; i++) {
+            if (import_p->jobs_p[i].state == IMPORT_JOB_DONE) {
+                job_p = &import_p->jobs_p[i];
+                if (AEROSPIKE_OK == job_p->status) {
+                    import_p->written++;
+                } else {
+                    import_count_error(import_p, job_p->status TSRMLS_CC);
+                }
+                import_job_release(job_p);
+            }
+        }
+        if (!job_p) {
+            pthread_cond_wait(&import_p->done_cond, &import_p->lock);
+        }
+    }
+    pthread_mutex_unlock(&import_p->lock);
+    return job_p;
+}
+
+/*
+ *******************************************************************************************************
+ * Waits for all the in-flight writes and stops the workers.
+ *******************************************************************************************************
+ */
+static void
+import_drain(aerospike_import *import_p TSRMLS_DC)
+{
+    uint32_t    i = 0;
+
+    for (i = 0; i < import_p->n_jobs; i++) {
+        pthread_mutex_lock(&import_p->lock);
+        while ((import_p->jobs_p[i].state == IMPORT_JOB_QUEUED) ||
+                (import_p->jobs_p[i].state == IMPORT_JOB_RUNNING)) {
+            pthread_cond_wait(&import_p->done_cond, &import_p->lock);
+        }
+        if (import_p->jobs_p[i].state == IMPORT_JOB_DONE) {
+            if (AEROSPIKE_OK == import_p->jobs_p[i].status) {
+                import_p->written++;
+            } else {
+                import_count_error(import_p, import_p->jobs_p[i].status TSRMLS_CC);
+            }
+            import_job_release(&import_p->jobs_p[i]);
+        }
+        pthread_mutex_unlock(&import_p->lock);
+    }
+
+    pthread_mutex_lock(&import_p->lock);
+    import_p->shutdown = true;
+    pthread_cond_broadcast(&import_p->queued_cond);
+    pthread_mutex_unlock(&import_p->lock);
+    for (i = 0; i < import_p->n_workers; i++) {
+        pthread_join(import_p->workers_p[i], NULL);
+    }
+    import_p->n_workers = 0;
+}
+
+/*
+ *******************************************************************************************************
+ * Reads the next line of the file, without its line terminator.
+ *
+ * @return false at the end of the file.
+ *******************************************************************************************************
+ */
+static bool
+import_read_line(aerospike_import_reader *reader_p, bool append)
+{
+    size_t      chunk_len = 0;
+    bool        read = false;
+
+    if (!append) {
+        reader_p->line_len = 0;
+    }
+    while (true) {
+        if (reader_p->line_capacity - reader_p->line_len < AEROSPIKE_IMPORT_READ_SIZE) {
+            reader_p->line_capacity += AEROSPIKE_IMPORT_READ_SIZE;
+            reader_p->line_p = erealloc(reader_p->line_p, reader_p->line_capacity);
+        }
+        if (NULL == gzgets(reader_p->file, reader_p->line_p + reader_p->line_len,
+                    AEROSPIKE_IMPORT_READ_SIZE)) {
+            break;
+        }
+        read = true;
+        chunk_len = strlen(reader_p->line_p + reader_p->line_len);
+        reader_p->line_len += chunk_len;
+        if (chunk_len && reader_p->line_p[reader_p->line_len - 1] == '\n') {
+            break;
+        }
+    }
+    if (!read) {
+        return false;
+    }
+    while (reader_p->line_len && (reader_p->line_p[reader_p->line_len - 1] == '\n' ||
+                reader_p->line_p[reader_p->line_len - 1] == '\r')) {
+        reader_p->line_len--;
+    }
+    reader_p->line_p[reader_p->line_len] = '\0';
+    return true;
+}
+
+/*
+ *******************************************************************************************************
+ * Splits a CSV row into its fields, calling field_cb for each of them.
+ * Quoted fields are unquoted; rows with quoted line breaks must have been
+ * joined by the caller.
+ *******************************************************************************************************
+ */
+typedef void (*import_csv_field_cb)(uint32_t index, char *value_p, size_t len,
+        bool quoted, void *udata_p TSRMLS_DC);
+
+static void
+import_parse_csv(char *line_p, size_t len, import_csv_field_cb field_cb,
+        void *udata_p TSRMLS_DC)
+{
+    smart_str   field = {0};
+    uint32_t    index = 0;
+    size_t      i = 0;
+    bool        quoted = false;
+    bool        in_quotes = false;
+
+    for (i = 0; i <= len; i++) {
+        if (in_quotes) {
+            if (line_p[i] == '"' && i + 1 < len && line_p[i + 1] == '"') {
+                smart_str_appendc(&field, '"');
+                i++;
+            } else if (line_p[i] == '"') {
+                in_quotes = false;
+            } else if (i < len) {
+                smart_str_appendc(&field, line_p[i]);
+            }
+        } else if (i == len || line_p[i] == ',') {
+            smart_str_0(&field);
+            field_cb(index++, field.c ? field.c : "", field.len, quoted, udata_p TSRMLS_CC);
+            field.len = 0;
+            quoted = false;
+        } else if (line_p[i] == '"' && !field.len) {
+            in_quotes = quoted = true;
+        } else {
+            smart_str_appendc(&field, line_p[i]);
+        }
+    }
+    smart_str_free(&field);
+}
+
+static bool
+import_csv_line_complete(const char *line_p, size_t len)
+{
+    size_t      quotes = 0;
+    size_t      i = 0;
+
+    for (i = 0; i < len; i++) {
+        if (line_p[i] == '"') {
+            quotes++;
+        }
+    }
+    return !(quotes % 2);
+}
+
+typedef struct import_csv_row_s {
+    zval        *row_p;
+    char        **names_pp;
+    uint32_t    n_names;
+} import_csv_row;
+
+static void
+import_csv_header_field(uint32_t index, char *value_p, size_t len, bool quoted,
+        void *udata_p TSRMLS_DC)
+{
+    import_csv_row  *header_p = (import_csv_row *) udata_p;
+
+    header_p->names_pp = erealloc(header_p->names_pp, (index + 1) * sizeof(char *));
+    header_p->names_pp[index] = estrndup(value_p, len);
+    header_p->n_names = index + 1;
+}
+
+/*
+ * Unquoted integers become integer bins, other fields string bins. Empty
+ * unquoted fields leave the bin out.
+ */
+static void
+import_csv_row_field(uint32_t index, char *value_p, size_t len, bool quoted,
+        void *udata_p TSRMLS_DC)
+{
+    import_csv_row  *row_p = (import_csv_row *) udata_p;
+    long            lval = 0;
+    double          dval = 0;
+
+    if (index >= row_p->n_names || (!quoted && !len)) {
+        return;
+    }
+    if (!quoted && (IS_LONG == is_numeric_string(value_p, len, &lval, &dval, 0))) {
+        add_assoc_long(row_p->row_p, row_p->names_pp[index], lval);
+    } else {
+        add_assoc_stringl(row_p->row_p, row_p->names_pp[index], value_p, len, 1);
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Decodes an NDJSON line. Lines shaped like the records written by
+ * scanToFile() (with a 'bins' array) are imported with their bins and ttl;
+ * any other JSON object is taken as the bins.
+ *******************************************************************************************************
+ */
+static zval *
+import_decode_json(char *line_p, size_t len, zval ***bins_ppp, uint32_t *ttl_p TSRMLS_DC)
+{
+    zval        *row_p = NULL;
+    zval        **bins_pp = NULL;
+    zval        **metadata_pp = NULL;
+    zval        **ttl_pp = NULL;
+
+    MAKE_STD_ZVAL(row_p);
+#if PHP_VERSION_ID < 50400
+    php_json_decode(row_p, line_p, len, 1, PHP_JSON_PARSER_DEFAULT_DEPTH TSRMLS_CC);
+#else
+    php_json_decode_ex(row_p, line_p, len, PHP_JSON_OBJECT_AS_ARRAY,
+            PHP_JSON_PARSER_DEFAULT_DEPTH TSRMLS_CC);
+#endif
+    if (Z_TYPE_P(row_p) != IS_ARRAY) {
+        zval_ptr_dtor(&row_p);
+        return NULL;
+    }
+
+    *ttl_p = 0;
+    if ((zend_hash_find(Z_ARRVAL_P(row_p), "bins", sizeof("bins"),
+                    (void **) &bins_pp) == SUCCESS) && (Z_TYPE_PP(bins_pp) == IS_ARRAY)) {
+        *bins_ppp = bins_pp;
+        if ((zend_hash_find(Z_ARRVAL_P(row_p), "metadata", sizeof("metadata"),
+                        (void **) &metadata_pp) == SUCCESS) &&
+                (Z_TYPE_PP(metadata_pp) == IS_ARRAY) &&
+                (zend_hash_find(Z_ARRVAL_PP(metadata_pp), "ttl", sizeof("ttl"),
+                                (void **) &ttl_pp) == SUCCESS) &&
+                (Z_TYPE_PP(ttl_pp) == IS_LONG) && (Z_LVAL_PP(ttl_pp) > 0)) {
+            *ttl_p = (uint32_t) Z_LVAL_PP(ttl_pp);
+        }
+    } else {
+        *bins_ppp = NULL;
+    }
+    return row_p;
+}
+
+/*
+ *******************************************************************************************************
+ * Fills the stats array with the counters of the import.
+ *******************************************************************************************************
+ */
+static void
+import_set_stats(aerospike_import *import_p, zval *stats_p TSRMLS_DC)
+{
+    zval        *errors_p = NULL;
+
+    zval_dtor(stats_p);
+    array_init(stats_p);
+    add_assoc_long(stats_p, AEROSPIKE_IMPORT_RECORDS, import_p->records);
+    add_assoc_long(stats_p, AEROSPIKE_IMPORT_WRITTEN, import_p->written);
+    add_assoc_long(stats_p, AEROSPIKE_IMPORT_FAILED, import_p->failed);
+    add_assoc_long(stats_p, AEROSPIKE_IMPORT_INVALID, import_p->invalid);
+    MAKE_STD_ZVAL(errors_p);
+    array_init(errors_p);
+    zend_hash_copy(Z_ARRVAL_P(errors_p), Z_ARRVAL_P(import_p->errors_p),
+            (copy_ctor_func_t) zval_add_ref, NULL, sizeof(zval *));
+    add_assoc_zval(stats_p, AEROSPIKE_IMPORT_ERRORS, errors_p);
+}
+
+/*
+ *******************************************************************************************************
+ * Calls the user's progress callback with the stats so far.
+ *******************************************************************************************************
+ */
+static void
+import_report_progress(aerospike_import *import_p, userland_callback *progress_p TSRMLS_DC)
+{
+    zval        *stats_p = NULL;
+    zval        *retval_p = NULL;
+    zval        **args[1];
+
+    MAKE_STD_ZVAL(stats_p);
+    array_init(stats_p);
+    import_set_stats(import_p, stats_p TSRMLS_CC);
+
+    args[0] = &stats_p;
+    progress_p->fci_p->param_count = 1;
+    progress_p->fci_p->params = args;
+    progress_p->fci_p->retval_ptr_ptr = &retval_p;
+    if (zend_call_function(progress_p->fci_p, progress_p->fcc_p TSRMLS_CC) == FAILURE) {
+        DEBUG_PHP_EXT_WARNING("importFile could not invoke the progress callback.");
+        php_error_docref(NULL TSRMLS_CC, E_WARNING, "importFile could not invoke the progress callback.");
+    }
+    if (retval_p) {
+        zval_ptr_dtor(&retval_p);
+    }
+    zval_ptr_dtor(&stats_p);
+}
+
+/*
+ *******************************************************************************************************
+ * Imports the records of an NDJSON or CSV file into a set of the Aerospike
+ * DB, with several writes in flight at once.
+ *
+ * @param as_object_p               The C client's aerospike object.
+ * @param error_p                   The C client's as_error to be set to the encountered error.
+ * @param path_p                    The file to read. It may be gzip'd.
+ * @param namespace_p               The namespace to write to.
+ * @param set_p                     The set to write to.
+ * @param key_field_p               The field holding the key of each record.
+ * @param format                    FILE_FORMAT_NDJSON or FILE_FORMAT_CSV.
+ * @param stats_p                   Set to the counters of the import.
+ * @param options_p                 The optional write policy.
+ * @param progress_p                The optional progress callback.
+ *
+ * @return AEROSPIKE_OK if the file was read. Failed writes are only counted
+ *         in stats_p. Otherwise AEROSPIKE_x.
+ ******************************************************************************************************
+ */
+extern as_status
+aerospike_import_file(aerospike* as_object_p, as_error* error_p, char* path_p,
+        char* namespace_p, char* set_p, char* key_field_p, long format,
+        zval* stats_p, zval* options_p, userland_callback* progress_p TSRMLS_DC)
+{
+    aerospike_import        import;
+    aerospike_import_reader reader;
+    aerospike_import_job    *job_p = NULL;
+    import_csv_row          csv = {0};
+    uint32_t                serializer_policy = -1;
+    uint32_t                concurrency = AEROSPIKE_IMPORT_DEFAULT_CONCURRENCY;
+    uint32_t                ttl = 0;
+    zval                    *row_p = NULL;
+    zval                    **bins_pp = NULL;
+    zval                    **key_pp = NULL;
+    as_error                record_error;
+    uint32_t                i = 0;
+
+    memset(&import, 0, sizeof(import));
+    memset(&reader, 0, sizeof(reader));
+    import.as_object_p = as_object_p;
+    pthread_mutex_init(&import.lock, NULL);
+    pthread_cond_init(&import.queued_cond, NULL);
+    pthread_cond_init(&import.done_cond, NULL);
+    MAKE_STD_ZVAL(import.errors_p);
+    array_init(import.errors_p);
+
+    if ((format != FILE_FORMAT_NDJSON) && (format != FILE_FORMAT_CSV)) {
+        DEBUG_PHP_EXT_DEBUG("Invalid file format for import");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM, "Invalid file format for import");
+        goto exit;
+    }
+
+    set_policy(NULL, &import.write_policy, NULL, NULL, NULL, NULL, NULL,
+            &serializer_policy, options_p, error_p TSRMLS_CC);
+    if (AEROSPIKE_OK != (error_p->code)) {
+        DEBUG_PHP_EXT_DEBUG("Unable to set policy");
+        goto exit;
+    }
+
+    get_import_concurrency(options_p, &concurrency, error_p TSRMLS_CC);
+    if (AEROSPIKE_OK != (error_p->code)) {
+        DEBUG_PHP_EXT_DEBUG("Unable to set import concurrency");
+        goto exit;
+    }
+
+    if (NULL == (reader.file = gzopen(path_p, "rb"))) {
+        DEBUG_PHP_EXT_DEBUG("Unable to open the import file");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM, "Unable to open the import file");
+        goto exit;
+    }
+
+    if (format == FILE_FORMAT_CSV) {
+        if (!import_read_line(&reader, false)) {
+            DEBUG_PHP_EXT_DEBUG("The CSV file has no header");
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM, "The CSV file has no header");
+            goto exit;
+        }
+        import_parse_csv(reader.line_p, reader.line_len, import_csv_header_field,
+                &csv TSRMLS_CC);
+    }
+
+    import.jobs_p = ecalloc(concurrency, sizeof(aerospike_import_job));
+    import.n_jobs = concurrency;
+    for (i = 0; i < import.n_jobs; i++) {
+        import.jobs_p[i].static_pool_p = ecalloc(1, sizeof(as_static_pool));
+    }
+    import.workers_p = ecalloc(concurrency, sizeof(pthread_t));
+    for (i = 0; i < concurrency; i++) {
+        if (0 != pthread_create(&import.workers_p[import.n_workers], NULL,
+                    import_worker, &import)) {
+            break;
+        }
+        import.n_workers++;
+    }
+    if (!import.n_workers) {
+        DEBUG_PHP_EXT_DEBUG("Unable to start the import threads");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT, "Unable to start the import threads");
+        goto exit;
+    }
+
+    while (import_read_line(&reader, false)) {
+        if (format == FILE_FORMAT_CSV) {
+            while (!import_csv_line_complete(reader.line_p, reader.line_len) &&
+                    import_read_line(&reader, true)) {
+                /* a quoted field spans lines: keep reading the row */
+            }
+        }
+        if (!reader.line_len) {
+            continue;
+        }
+        import.records++;
+
+        if (format == FILE_FORMAT_CSV) {
+            MAKE_STD_ZVAL(row_p);
+            array_init(row_p);
+            csv.row_p = row_p;
+            import_parse_csv(reader.line_p, reader.line_len, import_csv_row_field,
+                    &csv TSRMLS_CC);
+            bins_pp = &row_p;
+            ttl = 0;
+        } else if (NULL != (row_p = import_decode_json(reader.line_p, reader.line_len,
+                        &bins_pp, &ttl TSRMLS_CC))) {
+            if (!bins_pp) {
+                bins_pp = &row_p;
+            }
+        }
+
+        if ((!row_p) || (zend_hash_find(Z_ARRVAL_PP(bins_pp), key_field_p,
+                        strlen(key_field_p) + 1, (void **) &key_pp) != SUCCESS) ||
+                ((Z_TYPE_PP(key_pp) != IS_LONG) && (Z_TYPE_PP(key_pp) != IS_STRING))) {
+            import.invalid++;
+            if (row_p) {
+                zval_ptr_dtor(&row_p);
+            }
+            continue;
+        }
+
+        job_p = import_job_acquire(&import TSRMLS_CC);
+        job_p->row_p = row_p;
+        if (bins_pp == &row_p) {
+            bins_pp = &job_p->row_p;
+        }
+        row_p = NULL;
+        if (Z_TYPE_PP(key_pp) == IS_LONG) {
+            as_key_init_int64(&job_p->key, namespace_p, set_p, (int64_t) Z_LVAL_PP(key_pp));
+        } else {
+            as_key_init_str(&job_p->key, namespace_p, set_p, Z_STRVAL_PP(key_pp));
+        }
+        as_record_init(&job_p->record, zend_hash_num_elements(Z_ARRVAL_PP(bins_pp)));
+        job_p->record.ttl = ttl;
+
+        as_error_init(&record_error);
+        aerospike_transform_iterate_records(bins_pp, &job_p->record,
+                job_p->static_pool_p, serializer_policy, &record_error TSRMLS_CC);
+        if (AEROSPIKE_OK != record_error.code) {
+            DEBUG_PHP_EXT_DEBUG("%s", record_error.message);
+            pthread_mutex_lock(&import.lock);
+            import_count_error(&import, record_error.code TSRMLS_CC);
+            import_job_release(job_p);
+            pthread_mutex_unlock(&import.lock);
+        } else {
+            pthread_mutex_lock(&import.lock);
+            job_p->state = IMPORT_JOB_QUEUED;
+            pthread_cond_signal(&import.queued_cond);
+            pthread_mutex_unlock(&import.lock);
+        }
+
+        if (progress_p && !(import.records % AEROSPIKE_IMPORT_PROGRESS_INTERVAL)) {
+            import_report_progress(&import, progress_p TSRMLS_CC);
+        }
+    }
+
+    if (!gzeof(reader.file)) {
+        DEBUG_PHP_EXT_DEBUG("Unable to read the import file");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT, "Unable to read the import file");
+    }
+
+exit:
+    if (import.n_workers) {
+        import_drain(&import TSRMLS_CC);
+    }
+    if (stats_p) {
+        import_set_stats(&import, stats_p TSRMLS_CC);
+    }
+    if (progress_p && import.records && (AEROSPIKE_OK == error_p->code)) {
+        import_report_progress(&import, progress_p TSRMLS_CC);
+    }
+
+    for (i = 0; i < import.n_jobs; i++) {
+        efree(import.jobs_p[i].static_pool_p);
+    }
+    if (import.jobs_p) {
+        efree(import.jobs_p);
+    }
+    if (import.workers_p) {
+        efree(import.workers_p);
+    }
+    for (i = 0; i < csv.n_names; i++) {
+        efree(csv.names_pp[i]);
+    }
+    if (csv.names_pp) {
+        efree(csv.names_pp);
+    }
+    if (reader.line_p) {
+        efree(reader.line_p);
+    }
+    if (reader.file) {
+        gzclose(reader.file);
+    }
+    zval_ptr_dtor(&import.errors_p);
+    pthread_cond_destroy(&import.done_cond);
+    pthread_cond_destroy(&import.queued_cond);
+    pthread_mutex_destroy(&import.lock);
+    return error_p->code;
+}
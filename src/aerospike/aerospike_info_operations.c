@@ -1,9 +1,14 @@
 #include "php.h"
+#include "php_aerospike.h"
 #include "aerospike/as_status.h"
 #include "aerospike/aerospike_key.h"
 #include "aerospike/as_error.h"
 #include "aerospike/as_record.h"
 #include "aerospike/aerospike_info.h"
+#include "aerospike/as_cluster.h"
+#include "aerospike/as_shm_cluster.h"
+#include "citrusleaf/cf_clock.h"
+#include "citrusleaf/cf_queue.h"
 #include <arpa/inet.h>
 
 #include "aerospike_common.h"
@@ -455,3 +460,196 @@ exit:
     }
     return error_p->code;
 }
+
+/*
+ *******************************************************************************************************
+ * Samples the shared memory cluster map of a persistent connection and
+ * counts a takeover whenever the PID of its tender has changed since the
+ * last sample. Cheap enough to be done each time the connection is reused.
+ *
+ * @param as_ref_p              The aerospike_ref holding the C client's aerospike object.
+ *
+ *******************************************************************************************************
+ */
+extern void
+aerospike_info_shm_observe(aerospike_ref* as_ref_p)
+{
+    as_cluster_shm*             cluster_shm_p = NULL;
+    uint32_t                    owner_pid = 0;
+
+    if ((!as_ref_p) || (!as_ref_p->as_p) || (!as_ref_p->as_p->cluster) ||
+            (!as_ref_p->as_p->cluster->shm_info) ||
+            (!(cluster_shm_p = as_ref_p->as_p->cluster->shm_info->cluster_shm))) {
+        return;
+    }
+
+    owner_pid = cluster_shm_p->owner_pid;
+    if (owner_pid && as_ref_p->shm_owner_pid != owner_pid) {
+        if (as_ref_p->shm_owner_pid) {
+            as_ref_p->shm_takeovers++;
+        }
+        as_ref_p->shm_owner_pid = owner_pid;
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Helper function to describe the shared memory cluster map of a
+ * connection: its tender, how long ago it was tended and its nodes.
+ *
+ * @param as_ref_p              The aerospike_ref holding the C client's aerospike object.
+ * @param error_p               The as_error to be populated by the function
+ *                              with the encountered error if any.
+ * @param return_p              The return zval to be populated with the
+ *                              statistics by this method.
+ *
+ *******************************************************************************************************
+ */
+extern as_status
+aerospike_info_shm_stats(aerospike_ref* as_ref_p, as_error* error_p,
+        zval* return_p TSRMLS_DC)
+{
+    as_shm_info*                shm_info_p = NULL;
+    as_cluster_shm*             cluster_shm_p = NULL;
+    uint64_t                    now = 0;
+
+    if ((!as_ref_p) || (!as_ref_p->as_p) || (!as_ref_p->as_p->cluster) ||
+            (!as_ref_p->as_p->config.use_shm) ||
+            (!(shm_info_p = as_ref_p->as_p->cluster->shm_info)) ||
+            (!(cluster_shm_p = shm_info_p->cluster_shm))) {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
+                "Shared memory cluster tending is not in use");
+        DEBUG_PHP_EXT_DEBUG("Shared memory cluster tending is not in use");
+        goto exit;
+    }
+
+    aerospike_info_shm_observe(as_ref_p);
+    now = cf_getms();
+
+    add_assoc_long(return_p, "tender_pid", (long) cluster_shm_p->owner_pid);
+    add_assoc_bool(return_p, "is_tender", shm_info_p->is_tend_master ? 1 : 0);
+    add_assoc_long(return_p, "map_age_ms",
+            (long) ((now > cluster_shm_p->timestamp) ? now - cluster_shm_p->timestamp : 0));
+    add_assoc_long(return_p, "nodes", (long) cluster_shm_p->nodes_size);
+    add_assoc_long(return_p, "partition_generation",
+            (long) cluster_shm_p->partition_generation);
+    add_assoc_bool(return_p, "ready", cluster_shm_p->ready ? 1 : 0);
+    add_assoc_long(return_p, "takeover_threshold_ms",
+            (long) shm_info_p->takeover_threshold_ms);
+    add_assoc_long(return_p, "takeovers", (long) as_ref_p->shm_takeovers);
+
+exit:
+    return error_p->code;
+}
+
+/*
+ *******************************************************************************************************
+ * Helper function to describe each node of the cluster as the client sees
+ * it: its address, the connections pooled for it by the C client, its tend
+ * failures, and the counters kept for the single-record commands sent to it
+ * by this process (see aerospike_stats.c).
+ *
+ * @param as_object_p           The C client's aerospike object.
+ * @param error_p               The as_error to be populated by the function
+ *                              with the encountered error if any.
+ * @param return_p              The return zval to be populated with an
+ *                              array per node, keyed by node name.
+ *
+ *******************************************************************************************************
+ */
+extern as_status
+aerospike_info_node_stats(aerospike* as_object_p, as_error* error_p,
+        zval* return_p TSRMLS_DC)
+{
+    as_nodes*                   nodes_p = NULL;
+    as_node*                    node_p = NULL;
+    struct sockaddr_in*         addr_p = NULL;
+    zval*                       node_stats_p = NULL;
+    zval**                      node_stats_pp = NULL;
+    char                        ip[INET_ADDRSTRLEN];
+    uint32_t                    i = 0;
+
+    if ((!as_object_p) || (!as_object_p->cluster)) {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLUSTER,
+                "nodeStats: the cluster is not connected");
+        DEBUG_PHP_EXT_DEBUG("nodeStats: the cluster is not connected");
+        goto exit;
+    }
+
+    nodes_p = as_nodes_reserve(as_object_p->cluster);
+    node_stats_pp = ecalloc(nodes_p->size ? nodes_p->size : 1, sizeof(zval *));
+    for (i = 0; i < nodes_p->size; i++) {
+        node_p = nodes_p->array[i];
+        addr_p = as_node_get_address(node_p);
+
+        MAKE_STD_ZVAL(node_stats_p);
+        array_init(node_stats_p);
+        if (inet_ntop(addr_p->sin_family, &addr_p->sin_addr, ip, INET_ADDRSTRLEN)) {
+            add_assoc_string(node_stats_p, "addr", ip, 1);
+        }
+        add_assoc_long(node_stats_p, "port", (long) ntohs(addr_p->sin_port));
+        add_assoc_bool(node_stats_p, "active", node_p->active ? 1 : 0);
+        add_assoc_long(node_stats_p, "partition_generation",
+                (long) node_p->partition_generation);
+        add_assoc_long(node_stats_p, "conn_pooled",
+                (long) (node_p->conn_q ? cf_queue_sz(node_p->conn_q) : 0));
+        add_assoc_long(node_stats_p, "tend_failures", (long) node_p->failures);
+        node_stats_pp[i] = node_stats_p;
+    }
+    aerospike_stats_nodes_get(as_object_p->cluster, nodes_p, node_stats_pp TSRMLS_CC);
+    for (i = 0; i < nodes_p->size; i++) {
+        add_assoc_zval(return_p, nodes_p->array[i]->name, node_stats_pp[i]);
+    }
+    efree(node_stats_pp);
+    as_nodes_release(nodes_p);
+
+exit:
+    return error_p->code;
+}
+
+/*
+ *******************************************************************************************************
+ * Helper function to describe the runtime state of the extension in this
+ * process, for Aerospike::runtimeInfo() and phpinfo(): the policy values
+ * taken from php.ini, the persistent cluster clients, the shared memory
+ * settings, the cumulative operation counters and the dropped log messages.
+ *
+ * @param return_p              An initialized array zval to be populated.
+ *
+ *******************************************************************************************************
+ */
+extern void
+aerospike_info_runtime(zval* return_p TSRMLS_DC)
+{
+    zval*                       section_p = NULL;
+
+    add_assoc_string(return_p, "version", PHP_AEROSPIKE_VERSION, 1);
+
+    MAKE_STD_ZVAL(section_p);
+    array_init(section_p);
+    aerospike_policy_ini_info(section_p TSRMLS_CC);
+    add_assoc_zval(return_p, "policies", section_p);
+
+    MAKE_STD_ZVAL(section_p);
+    array_init(section_p);
+    aerospike_helper_persistent_info(section_p TSRMLS_CC);
+    add_assoc_zval(return_p, "persistent", section_p);
+
+    MAKE_STD_ZVAL(section_p);
+    array_init(section_p);
+    add_assoc_bool(section_p, "use", AEROSPIKE_G(shm_use) ? 1 : 0);
+    add_assoc_long(section_p, "max_nodes", AEROSPIKE_G(shm_max_nodes));
+    add_assoc_long(section_p, "max_namespaces", AEROSPIKE_G(shm_max_namespaces));
+    add_assoc_long(section_p, "takeover_threshold_sec", AEROSPIKE_G(shm_takeover_threshold_sec));
+    add_assoc_zval(return_p, "shm", section_p);
+
+    MAKE_STD_ZVAL(section_p);
+    array_init(section_p);
+    aerospike_stats_counters(section_p TSRMLS_CC);
+    add_assoc_zval(return_p, "operations", section_p);
+
+    MAKE_STD_ZVAL(section_p);
+    array_init(section_p);
+    add_assoc_long(section_p, "dropped", (long) aerospike_log_dropped_count());
+    add_assoc_zval(return_p, "log", section_p);
+}
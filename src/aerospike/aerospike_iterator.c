@@ -0,0 +1,346 @@
+#include "php.h"
+#include "zend_interfaces.h"
+#include "aerospike/as_log.h"
+#include "aerospike/as_error.h"
+#include "aerospike/as_status.h"
+#include "aerospike/as_record.h"
+#include "aerospike/aerospike.h"
+#include "aerospike_common.h"
+
+/*
+ *******************************************************************************************************
+ * AerospikeIterator: the object returned by Aerospike::scanIterator() and
+ * Aerospike::queryIterator(). It implements the Iterator interface over a
+ * record stream (see aerospike_stream.c): the C client fills a bounded
+ * buffer in the background and each iteration step pulls one record from
+ * it. The iterator is forward-only. Destroying it cancels the scan/query.
+ * Live iterators are linked from their Aerospike object, so that closing
+ * the connection first cancels their scans/queries.
+ *******************************************************************************************************
+ */
+static zend_class_entry *AerospikeIterator_ce;
+static zend_object_handlers AerospikeIterator_handlers;
+
+typedef struct AerospikeIterator_object {
+    zend_object         std;
+    aerospike_stream    *stream_p;
+    zval                *owner_p;
+    Aerospike_object    *aerospike_obj_p;
+    struct AerospikeIterator_object *next_p;
+    zval                *current_p;
+    long                position;
+    bool                started;
+    as_error            error;
+} AerospikeIterator_object;
+
+#define PHP_AEROSPIKE_ITERATOR_GET_OBJECT    (AerospikeIterator_object *)(zend_object_store_get_object(getThis() TSRMLS_CC))
+
+/*
+ *******************************************************************************************************
+ * Unlinks the iterator from the live iterators of its Aerospike object once
+ * its stream has been destroyed.
+ *
+ * @param intern_p          The iterator object.
+ *******************************************************************************************************
+ */
+static void
+aerospike_iterator_unlink(AerospikeIterator_object *intern_p)
+{
+    AerospikeIterator_object    **iter_pp = NULL;
+
+    if (!intern_p->aerospike_obj_p) {
+        return;
+    }
+
+    for (iter_pp = &intern_p->aerospike_obj_p->iterators_p; *iter_pp;
+            iter_pp = &(*iter_pp)->next_p) {
+        if (*iter_pp == intern_p) {
+            *iter_pp = intern_p->next_p;
+            break;
+        }
+    }
+    intern_p->aerospike_obj_p = NULL;
+    intern_p->next_p = NULL;
+}
+
+/*
+ *******************************************************************************************************
+ * Pulls the next record of the stream into the iterator's current value.
+ * Once the stream is exhausted it is destroyed and its final status is
+ * kept for errorno()/error().
+ *
+ * @param intern_p          The iterator object.
+ *******************************************************************************************************
+ */
+static void
+aerospike_iterator_fetch(AerospikeIterator_object *intern_p TSRMLS_DC)
+{
+    as_record       *record_p = NULL;
+
+    if (intern_p->current_p) {
+        zval_ptr_dtor(&intern_p->current_p);
+        intern_p->current_p = NULL;
+    }
+
+    while (intern_p->stream_p) {
+        if (NULL == (record_p = aerospike_stream_next(intern_p->stream_p))) {
+            aerospike_stream_destroy(intern_p->stream_p, &intern_p->error, true);
+            intern_p->stream_p = NULL;
+            aerospike_iterator_unlink(intern_p);
+            break;
+        }
+
+        MAKE_STD_ZVAL(intern_p->current_p);
+        array_init(intern_p->current_p);
+        if (AEROSPIKE_OK == aerospike_helper_record_stream_to_zval(record_p,
+                    intern_p->current_p TSRMLS_CC)) {
+            as_record_destroy(record_p);
+            break;
+        }
+
+        /* same as the callback API: records which cannot be converted are skipped */
+        zval_ptr_dtor(&intern_p->current_p);
+        intern_p->current_p = NULL;
+        as_record_destroy(record_p);
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Fetches the first record on first use of the iterator.
+ *
+ * @param intern_p          The iterator object.
+ *******************************************************************************************************
+ */
+static void
+aerospike_iterator_ensure_started(AerospikeIterator_object *intern_p TSRMLS_DC)
+{
+    if (!intern_p->started) {
+        intern_p->started = true;
+        aerospike_iterator_fetch(intern_p TSRMLS_CC);
+    }
+}
+
+/* {{{ proto void AerospikeIterator::rewind( void )
+   Starts the iteration. The iterator is forward-only, later calls have no effect */
+PHP_METHOD(AerospikeIterator, rewind)
+{
+    AerospikeIterator_object*   intern_p = PHP_AEROSPIKE_ITERATOR_GET_OBJECT;
+
+    aerospike_iterator_ensure_started(intern_p TSRMLS_CC);
+}
+/* }}} */
+
+/* {{{ proto bool AerospikeIterator::valid( void )
+   Checks whether a record is available at the current position */
+PHP_METHOD(AerospikeIterator, valid)
+{
+    AerospikeIterator_object*   intern_p = PHP_AEROSPIKE_ITERATOR_GET_OBJECT;
+
+    aerospike_iterator_ensure_started(intern_p TSRMLS_CC);
+    RETURN_BOOL(intern_p->current_p != NULL);
+}
+/* }}} */
+
+/* {{{ proto array AerospikeIterator::current( void )
+   Returns the current record (key, metadata and bins) */
+PHP_METHOD(AerospikeIterator, current)
+{
+    AerospikeIterator_object*   intern_p = PHP_AEROSPIKE_ITERATOR_GET_OBJECT;
+
+    aerospike_iterator_ensure_started(intern_p TSRMLS_CC);
+    if (!intern_p->current_p) {
+        RETURN_NULL();
+    }
+    RETURN_ZVAL(intern_p->current_p, 1, 0);
+}
+/* }}} */
+
+/* {{{ proto int AerospikeIterator::key( void )
+   Returns the position of the current record in the stream */
+PHP_METHOD(AerospikeIterator, key)
+{
+    AerospikeIterator_object*   intern_p = PHP_AEROSPIKE_ITERATOR_GET_OBJECT;
+
+    RETURN_LONG(intern_p->position);
+}
+/* }}} */
+
+/* {{{ proto void AerospikeIterator::next( void )
+   Moves to the next record, waiting for the cluster if none is buffered */
+PHP_METHOD(AerospikeIterator, next)
+{
+    AerospikeIterator_object*   intern_p = PHP_AEROSPIKE_ITERATOR_GET_OBJECT;
+
+    if (!intern_p->started) {
+        aerospike_iterator_ensure_started(intern_p TSRMLS_CC);
+    }
+    intern_p->position++;
+    aerospike_iterator_fetch(intern_p TSRMLS_CC);
+}
+/* }}} */
+
+/* {{{ proto int AerospikeIterator::errorno( void )
+   Displays the status code the scan/query ended with */
+PHP_METHOD(AerospikeIterator, errorno)
+{
+    AerospikeIterator_object*   intern_p = PHP_AEROSPIKE_ITERATOR_GET_OBJECT;
+
+    RETURN_LONG(intern_p->error.code);
+}
+/* }}} */
+
+/* {{{ proto string AerospikeIterator::error( void )
+   Displays the error message the scan/query ended with */
+PHP_METHOD(AerospikeIterator, error)
+{
+    AerospikeIterator_object*   intern_p = PHP_AEROSPIKE_ITERATOR_GET_OBJECT;
+
+    RETURN_STRING(intern_p->error.message, 1);
+}
+/* }}} */
+
+/*
+ ********************************************************************
+ *  The function entries for the AerospikeIterator class.
+ ********************************************************************
+ */
+static zend_function_entry AerospikeIterator_class_functions[] =
+{
+    PHP_ME(AerospikeIterator, rewind, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(AerospikeIterator, valid, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(AerospikeIterator, current, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(AerospikeIterator, key, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(AerospikeIterator, next, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(AerospikeIterator, errorno, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(AerospikeIterator, error, NULL, ZEND_ACC_PUBLIC)
+    { NULL, NULL, NULL }
+};
+
+/*
+ ********************************************************************
+ * AerospikeIterator object freeing up on scope termination.
+ * Cancels the scan/query if it is still running.
+ ********************************************************************
+ */
+static void AerospikeIterator_object_free_storage(void *object TSRMLS_DC)
+{
+    AerospikeIterator_object    *intern_p = (AerospikeIterator_object *) object;
+
+    if (intern_p->stream_p) {
+        aerospike_stream_destroy(intern_p->stream_p, NULL, true);
+        intern_p->stream_p = NULL;
+    }
+    aerospike_iterator_unlink(intern_p);
+    if (intern_p->current_p) {
+        zval_ptr_dtor(&intern_p->current_p);
+    }
+    if (intern_p->owner_p) {
+        zval_ptr_dtor(&intern_p->owner_p);
+    }
+    zend_object_std_dtor(&intern_p->std TSRMLS_CC);
+    efree(intern_p);
+}
+
+/*
+ ********************************************************************
+ * AerospikeIterator class new method
+ ********************************************************************
+ */
+static zend_object_value AerospikeIterator_object_new(zend_class_entry *ce TSRMLS_DC)
+{
+    zend_object_value retval = {0};
+    AerospikeIterator_object *intern_p;
+
+    intern_p = ecalloc(1, sizeof(AerospikeIterator_object));
+    zend_object_std_init(&(intern_p->std), ce TSRMLS_CC);
+#if PHP_VERSION_ID < 50399
+    zend_hash_copy(intern_p->std.properties, &ce->default_properties, (copy_ctor_func_t) zval_add_ref, NULL, sizeof(zval *));
+#else
+    object_properties_init((zend_object*) &(intern_p->std), ce);
+#endif
+    as_error_init(&intern_p->error);
+
+    retval.handle = zend_objects_store_put(intern_p, NULL, (zend_objects_free_object_storage_t) AerospikeIterator_object_free_storage, NULL TSRMLS_CC);
+    retval.handlers = &AerospikeIterator_handlers;
+    return (retval);
+}
+
+/*
+ *******************************************************************************************************
+ * Wraps a started record stream into a new AerospikeIterator object.
+ *
+ * @param iterator_p        The zval to be initialized with the iterator.
+ * @param owner_p           The Aerospike object the stream was started on.
+ *                          Kept alive for as long as the iterator, which
+ *                          is linked from it until the stream ends.
+ * @param stream_p          The started record stream, owned by the
+ *                          iterator from now on.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_iterator_init(zval *iterator_p, zval *owner_p,
+        aerospike_stream *stream_p TSRMLS_DC)
+{
+    AerospikeIterator_object    *intern_p = NULL;
+
+    object_init_ex(iterator_p, AerospikeIterator_ce);
+    intern_p = (AerospikeIterator_object *) zend_object_store_get_object(iterator_p TSRMLS_CC);
+    intern_p->stream_p = stream_p;
+    if (owner_p) {
+        Z_ADDREF_P(owner_p);
+        intern_p->owner_p = owner_p;
+        intern_p->aerospike_obj_p = (Aerospike_object *) zend_object_store_get_object(owner_p TSRMLS_CC);
+        intern_p->next_p = intern_p->aerospike_obj_p->iterators_p;
+        intern_p->aerospike_obj_p->iterators_p = intern_p;
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Cancels the scans/queries of all the live iterators of an Aerospike
+ * object and waits for them, before its connection is closed or destroyed.
+ * The iterators end after their current record, with ERR_SCAN_ABORTED (or
+ * the status the stream had already ended with).
+ *
+ * @param aerospike_obj_p   The Aerospike object.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_iterator_close_all(Aerospike_object *aerospike_obj_p TSRMLS_DC)
+{
+    AerospikeIterator_object    *intern_p = NULL;
+
+    while (NULL != (intern_p = aerospike_obj_p->iterators_p)) {
+        if (intern_p->stream_p) {
+            aerospike_stream_destroy(intern_p->stream_p, &intern_p->error, true);
+            intern_p->stream_p = NULL;
+        }
+        aerospike_iterator_unlink(intern_p);
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Registers the AerospikeIterator class. Called from the module init.
+ *
+ * @return SUCCESS or FAILURE.
+ *******************************************************************************************************
+ */
+extern int
+aerospike_iterator_register_class(TSRMLS_D)
+{
+    zend_class_entry ce = {0};
+
+    INIT_CLASS_ENTRY(ce, "AerospikeIterator", AerospikeIterator_class_functions);
+    if (!(AerospikeIterator_ce = zend_register_internal_class(&ce TSRMLS_CC))) {
+        return FAILURE;
+    }
+    AerospikeIterator_ce->create_object = AerospikeIterator_object_new;
+    AerospikeIterator_ce->ce_flags |= ZEND_ACC_FINAL_CLASS;
+    zend_class_implements(AerospikeIterator_ce TSRMLS_CC, 1, zend_ce_iterator);
+
+    memcpy(&AerospikeIterator_handlers, zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+    AerospikeIterator_handlers.clone_obj = NULL;
+    return SUCCESS;
+}
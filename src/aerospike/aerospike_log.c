@@ -0,0 +1,285 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include "php.h"
+#include "pthread.h"
+#include "php_aerospike.h"
+#include "aerospike/as_log.h"
+#include "aerospike/as_error.h"
+#include "aerospike/as_status.h"
+#include "aerospike_common.h"
+
+/*
+ *******************************************************************************************************
+ * Log messages bound for the handler registered with setLogHandler() go
+ * through a ring instead of calling into PHP where they are emitted: the C
+ * client logs from its tend and node threads, where the Zend engine must not
+ * be touched, and a userland call per message would sit in the middle of
+ * every command. Producers check the level before formatting anything, then
+ * claim a cell with a single CAS and copy the message into it. The PHP
+ * thread drains the ring in one go at safe points: the end of each API call
+ * and the end of the request.
+ *
+ * The ring is bounded and never blocks a producer; once full, messages are
+ * counted as dropped and the count is reported to the handler on the next
+ * drain. Cells only keep pointers to func and file, which are string
+ * literals (__func__ and __FILE__) at every call site.
+ *******************************************************************************************************
+ */
+#define AEROSPIKE_LOG_RING_SIZE     512
+#define AEROSPIKE_LOG_MSG_SIZE      256
+#define AEROSPIKE_LOG_PARAMS        5
+
+typedef struct aerospike_log_cell_s {
+    volatile uint64_t   sequence;
+    as_log_level        level;
+    uint32_t            line;
+    const char          *func;
+    const char          *file;
+    char                msg[AEROSPIKE_LOG_MSG_SIZE];
+} aerospike_log_cell;
+
+static aerospike_log_cell   aerospike_log_cells[AEROSPIKE_LOG_RING_SIZE];
+static volatile uint64_t    aerospike_log_enqueue_pos = 0;
+static volatile uint64_t    aerospike_log_dequeue_pos = 0;
+static volatile uint64_t    aerospike_log_dropped = 0;
+static volatile uint64_t    aerospike_log_dropped_reported = 0;
+static pthread_once_t       aerospike_log_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t      aerospike_log_drain_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ *******************************************************************************************************
+ * Stamps every cell with the position that may claim it first.
+ *******************************************************************************************************
+ */
+static void
+aerospike_log_ring_init(void)
+{
+    uint64_t    iter = 0;
+
+    for (iter = 0; iter < AEROSPIKE_LOG_RING_SIZE; iter++) {
+        aerospike_log_cells[iter].sequence = iter;
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Claims a cell in the ring and formats the message into it.
+ * Safe to call concurrently from any thread; never blocks.
+ *
+ * @param level             The as_log_level of the message (possibly
+ *                          flagged as coming from the PHP extension).
+ * @param func              The function name generating the log.
+ * @param file              The file name containing the func generating the log.
+ * @param line              The line number in file where the log was generated.
+ * @param fmt               The format specifier for logger.
+ * @param ap                The arguments for fmt.
+ *******************************************************************************************************
+ */
+static void
+aerospike_log_push(as_log_level level, const char *func, const char *file,
+        uint32_t line, const char *fmt, va_list ap)
+{
+    aerospike_log_cell      *cell_p = NULL;
+    uint64_t                pos = 0;
+    int64_t                 diff = 0;
+
+    pthread_once(&aerospike_log_once, aerospike_log_ring_init);
+    pos = aerospike_log_enqueue_pos;
+
+    for (;;) {
+        cell_p = &aerospike_log_cells[pos % AEROSPIKE_LOG_RING_SIZE];
+        diff = (int64_t) cell_p->sequence - (int64_t) pos;
+        if (diff == 0) {
+            if (__sync_bool_compare_and_swap(&aerospike_log_enqueue_pos, pos, pos + 1)) {
+                break;
+            }
+            pos = aerospike_log_enqueue_pos;
+        } else if (diff < 0) {
+            __sync_add_and_fetch(&aerospike_log_dropped, 1);
+            return;
+        } else {
+            pos = aerospike_log_enqueue_pos;
+        }
+    }
+
+    cell_p->level = level;
+    cell_p->line = line;
+    cell_p->func = func;
+    cell_p->file = file;
+    vsnprintf(cell_p->msg, AEROSPIKE_LOG_MSG_SIZE, fmt, ap);
+    __sync_synchronize();
+    cell_p->sequence = pos + 1;
+}
+
+/*
+ *******************************************************************************************************
+ * Callback registered with the C client's logger by setLogHandler().
+ * May be invoked on any C client thread, so it only queues the message.
+ *
+ * @param level             The as_log_level of the message.
+ * @param func              The function name generating the log.
+ * @param file              The file name containing the func generating the log.
+ * @param line              The line number in file where the log was generated.
+ * @param fmt               The format specifier for logger.
+ *
+ * @return true always.
+ *******************************************************************************************************
+ */
+extern bool
+aerospike_log_client_callback(as_log_level level, const char *func,
+        const char *file, uint32_t line, const char *fmt, ...)
+{
+    va_list     ap;
+
+    if (!is_callback_registered || level > g_as_log.level) {
+        return true;
+    }
+
+    va_start(ap, fmt);
+    aerospike_log_push(level, func, file, line, fmt, ap);
+    va_end(ap);
+    return true;
+}
+
+/*
+ *******************************************************************************************************
+ * Queues a log message of the PHP extension for the registered handler.
+ * The caller has already compared the level against php_log_level_set.
+ *
+ * @param level             The as_log_level of the message, flagged 0x08.
+ * @param func              The function name generating the log.
+ * @param file              The file name containing the func generating the log.
+ * @param line              The line number in file where the log was generated.
+ * @param fmt               The format specifier for logger.
+ * @param ap                The arguments for fmt.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_log_queue(as_log_level level, const char *func, const char *file,
+        uint32_t line, const char *fmt, va_list ap)
+{
+    aerospike_log_push(level, func, file, line, fmt, ap);
+}
+
+/*
+ *******************************************************************************************************
+ * Returns the number of messages dropped so far because the ring was full.
+ *******************************************************************************************************
+ */
+extern uint64_t
+aerospike_log_dropped_count(void)
+{
+    return aerospike_log_dropped;
+}
+
+/*
+ *******************************************************************************************************
+ * Invokes the registered PHP log handler with one message, reusing the
+ * parameter zvals across the calls of a drain unless the handler kept a
+ * reference to one of them.
+ *
+ * @param params            The handler's parameters, allocated by the caller.
+ * @param level             The as_log_level of the message.
+ * @param func              The function name generating the log.
+ * @param file              The file name containing the func generating the log.
+ * @param line              The line number in file where the log was generated.
+ * @param msg               The formatted message.
+ *******************************************************************************************************
+ */
+static void
+aerospike_log_dispatch(zval **params, as_log_level level, const char *func,
+        const char *file, uint32_t line, const char *msg TSRMLS_DC)
+{
+    zval**      params_pp[AEROSPIKE_LOG_PARAMS];
+    int16_t     iter = 0;
+
+    for (iter = 0; iter < AEROSPIKE_LOG_PARAMS; iter++) {
+        if (Z_REFCOUNT_P(params[iter]) > 1) {
+            zval_ptr_dtor(&params[iter]);
+            ALLOC_INIT_ZVAL(params[iter]);
+        } else {
+            zval_dtor(params[iter]);
+        }
+        params_pp[iter] = &params[iter];
+    }
+
+    ZVAL_LONG(params[0], level);
+    ZVAL_STRING(params[1], func, 1);
+    ZVAL_STRING(params[2], file, 1);
+    ZVAL_LONG(params[3], line);
+    ZVAL_STRING(params[4], msg, 1);
+
+    func_callback_retval_p = NULL;
+    func_call_info.param_count = AEROSPIKE_LOG_PARAMS;
+    func_call_info.params = params_pp;
+    func_call_info.retval_ptr_ptr = &func_callback_retval_p;
+
+    zend_call_function(&func_call_info, &func_call_info_cache TSRMLS_CC);
+    if (func_callback_retval_p) {
+        zval_ptr_dtor(&func_callback_retval_p);
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Hands every queued log message to the registered PHP log handler, then
+ * reports the messages dropped since the last drain, if any. Must only be
+ * called from the PHP thread at a point where userland code may run; a
+ * drain already in progress (including one on the stack, if the handler
+ * itself calls the client) makes this a no-op.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_log_drain(TSRMLS_D)
+{
+    aerospike_log_cell      *cell_p = NULL;
+    zval*                   params[AEROSPIKE_LOG_PARAMS];
+    uint64_t                pos = 0;
+    uint64_t                dropped = 0;
+    int16_t                 iter = 0;
+    char                    msg[AEROSPIKE_LOG_MSG_SIZE];
+
+    if (!is_callback_registered ||
+            (aerospike_log_dequeue_pos == aerospike_log_enqueue_pos &&
+             aerospike_log_dropped == aerospike_log_dropped_reported)) {
+        return;
+    }
+
+    if (pthread_mutex_trylock(&aerospike_log_drain_lock) != 0) {
+        return;
+    }
+
+    for (iter = 0; iter < AEROSPIKE_LOG_PARAMS; iter++) {
+        ALLOC_INIT_ZVAL(params[iter]);
+    }
+
+    for (;;) {
+        pos = aerospike_log_dequeue_pos;
+        cell_p = &aerospike_log_cells[pos % AEROSPIKE_LOG_RING_SIZE];
+        if (cell_p->sequence != pos + 1) {
+            break;
+        }
+
+        __sync_synchronize();
+        aerospike_log_dequeue_pos = pos + 1;
+        aerospike_log_dispatch(params, cell_p->level, cell_p->func,
+                cell_p->file, cell_p->line, cell_p->msg TSRMLS_CC);
+        __sync_synchronize();
+        cell_p->sequence = pos + AEROSPIKE_LOG_RING_SIZE;
+    }
+
+    dropped = aerospike_log_dropped;
+    if (dropped != aerospike_log_dropped_reported) {
+        snprintf(msg, AEROSPIKE_LOG_MSG_SIZE, "%llu log messages dropped, log ring full",
+                (unsigned long long) (dropped - aerospike_log_dropped_reported));
+        aerospike_log_dropped_reported = dropped;
+        aerospike_log_dispatch(params, AS_LOG_LEVEL_WARN, __func__,
+                __FILE__, __LINE__, msg TSRMLS_CC);
+    }
+
+    for (iter = 0; iter < AEROSPIKE_LOG_PARAMS; iter++) {
+        zval_ptr_dtor(&params[iter]);
+    }
+
+    pthread_mutex_unlock(&aerospike_log_drain_lock);
+}
@@ -13,7 +13,6 @@
 #define CONNECT_TIMEOUT_PHP_INI INI_STR("aerospike.connect_timeout") ? (uint32_t) atoi(INI_STR("aerospike.connect_timeout")) : 0
 #define READ_TIMEOUT_PHP_INI INI_STR("aerospike.read_timeout") ? (uint32_t) atoi(INI_STR("aerospike.read_timeout")) : 0
 #define WRITE_TIMEOUT_PHP_INI INI_STR("aerospike.write_timeout") ? (uint32_t) atoi(INI_STR("aerospike.write_timeout")) : 0
-#define LOG_PATH_PHP_INI INI_STR("aerospike.log_path") ? INI_STR("aerospike.log_path") : NULL
 #define LOG_LEVEL_PHP_INI INI_STR("aerospike.log_level") ? INI_STR("aerospike.log_level") : NULL
 #define SERIALIZER_PHP_INI INI_STR("aerospike.serializer") ? (uint32_t) atoi(INI_STR("aerospike.serializer")) : 0
 #define KEY_POLICY_PHP_INI INI_STR("aerospike.key_policy") ? (uint32_t) atoi(INI_STR("aerospike.key_policy")) : 0
@@ -282,7 +281,96 @@ exit:
     return;
 }
 
+/*
+ *******************************************************************************************************
+ * Function for getting a positive integer option from the user's optional
+ * policy options (if set). The value is left
+ * untouched if the option is not set.
+ *
+ * @param options_p             The optional parameters.
+ * @param option_key            The OPT_* key to be looked up.
+ * @param error_msg_p           The message to be set on an invalid value.
+ * @param value_p               The value to be set.
+ * @param error_p               The as_error to be populated by the function
+ *                              with the encountered error if any.
+ *******************************************************************************************************
+ */
+static void
+get_positive_option_value(zval* options_p, ulong option_key,
+        const char* error_msg_p, uint32_t* value_p, as_error *error_p TSRMLS_DC)
+{
+    zval**                  value_pp = NULL;
+
+    if (options_p && (zend_hash_index_find(Z_ARRVAL_P(options_p),
+                    option_key, (void **) &value_pp) == SUCCESS)) {
+        if ((Z_TYPE_PP(value_pp) != IS_LONG) || (Z_LVAL_PP(value_pp) <= 0)) {
+            DEBUG_PHP_EXT_DEBUG("%s", error_msg_p);
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM, error_msg_p);
+            goto exit;
+        }
+        *value_p = (uint32_t) Z_LVAL_PP(value_pp);
+    }
+
+exit:
+    return;
+}
+
+/*
+ *******************************************************************************************************
+ * Function for getting the number of records to be buffered between the C
+ * client and the PHP thread by a scan/query stream, from the user's optional
+ * policy options (if set) else the default.
+ *
+ * @param options_p             The optional parameters.
+ * @param buffer_size_p         The buffer size to be set.
+ * @param error_p               The as_error to be populated by the function
+ *                              with the encountered error if any.
+ *******************************************************************************************************
+ */
+extern void
+get_stream_buffer_size(zval* options_p, uint32_t* buffer_size_p, as_error *error_p TSRMLS_DC)
+{
+    get_positive_option_value(options_p, OPT_STREAM_BUFFER_SIZE,
+            "Unable to set policy: Invalid Value for OPT_STREAM_BUFFER_SIZE", buffer_size_p, error_p TSRMLS_CC);
+}
+
+/*
+ *******************************************************************************************************
+ * Function for getting the number of records to be passed per call to a
+ * scan/query callback, from the user's optional policy options (if set)
+ * else the default (0: one record per call, not wrapped in an array).
+ *
+ * @param options_p             The optional parameters.
+ * @param batch_size_p          The batch size to be set.
+ * @param error_p               The as_error to be populated by the function
+ *                              with the encountered error if any.
+ *******************************************************************************************************
+ */
+extern void
+get_callback_batch_size(zval* options_p, uint32_t* batch_size_p, as_error *error_p TSRMLS_DC)
+{
+    get_positive_option_value(options_p, OPT_CALLBACK_BATCH_SIZE,
+            "Unable to set policy: Invalid Value for OPT_CALLBACK_BATCH_SIZE", batch_size_p, error_p TSRMLS_CC);
+}
 
+/*
+ *******************************************************************************************************
+ * Function for getting the number of concurrent writes of
+ * Aerospike::importFile(), from the user's optional policy options (if set)
+ * else the default.
+ *
+ * @param options_p             The optional parameters.
+ * @param concurrency_p         The number of concurrent writes to be set.
+ * @param error_p               The as_error to be populated by the function
+ *                              with the encountered error if any.
+ *******************************************************************************************************
+ */
+extern void
+get_import_concurrency(zval* options_p, uint32_t* concurrency_p, as_error *error_p TSRMLS_DC)
+{
+    get_positive_option_value(options_p, OPT_IMPORT_CONCURRENCY,
+            "Unable to set policy: Invalid Value for OPT_IMPORT_CONCURRENCY", concurrency_p, error_p TSRMLS_CC);
+}
 
 /*
  *******************************************************************************************************
@@ -701,6 +789,42 @@ set_policy_ex(as_config *as_config_p,
                         goto exit;
                     }
                     break;
+                case OPT_STREAM_BUFFER_SIZE:
+                    if ((!scan_policy_p) && (!query_policy_p)) {
+                        DEBUG_PHP_EXT_DEBUG("Unable to set policy: Invalid Value for OPT_STREAM_BUFFER_SIZE");
+                        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR,
+                                "Unable to set policy: Invalid Value for OPT_STREAM_BUFFER_SIZE");
+                        goto exit;
+                    }
+                    /* consumed by get_stream_buffer_size() */
+                    break;
+                case OPT_CALLBACK_BATCH_SIZE:
+                    if ((!scan_policy_p) && (!query_policy_p)) {
+                        DEBUG_PHP_EXT_DEBUG("Unable to set policy: Invalid Value for OPT_CALLBACK_BATCH_SIZE");
+                        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR,
+                                "Unable to set policy: Invalid Value for OPT_CALLBACK_BATCH_SIZE");
+                        goto exit;
+                    }
+                    /* consumed by get_callback_batch_size() */
+                    break;
+                case OPT_FILE_GZIP:
+                    if ((!scan_policy_p) || (Z_TYPE_PP(options_value) != IS_BOOL)) {
+                        DEBUG_PHP_EXT_DEBUG("Unable to set policy: Invalid Value for OPT_FILE_GZIP");
+                        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                                "Unable to set policy: Invalid Value for OPT_FILE_GZIP");
+                        goto exit;
+                    }
+                    /* consumed by aerospike_scan_to_file() */
+                    break;
+                case OPT_IMPORT_CONCURRENCY:
+                    if (!write_policy_p) {
+                        DEBUG_PHP_EXT_DEBUG("Unable to set policy: Invalid Value for OPT_IMPORT_CONCURRENCY");
+                        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR,
+                                "Unable to set policy: Invalid Value for OPT_IMPORT_CONCURRENCY");
+                        goto exit;
+                    }
+                    /* consumed by get_import_concurrency() */
+                    break;
                 default:
                     DEBUG_PHP_EXT_DEBUG("Unable to set policy: Invalid Policy Constant Key");
                     PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR,
@@ -843,3 +967,32 @@ set_general_policies(as_config *as_config_p,
 exit:
     return;
 }
+
+/*
+ *******************************************************************************************************
+ * Function for describing the policy values taken from php.ini, as applied
+ * by set_policy_ex(). A value of 0 leaves the C client's default in place.
+ *
+ * @param return_p              An initialized array zval to be populated.
+ *
+ *******************************************************************************************************
+ */
+extern void
+aerospike_policy_ini_info(zval *return_p TSRMLS_DC)
+{
+    long        connect_timeout = CONNECT_TIMEOUT_PHP_INI;
+    long        read_timeout = READ_TIMEOUT_PHP_INI;
+    long        write_timeout = WRITE_TIMEOUT_PHP_INI;
+    long        key_policy = KEY_POLICY_PHP_INI;
+    long        key_gen = GEN_POLICY_PHP_INI;
+    long        nesting_depth = NESTING_DEPTH_PHP_INI;
+    char        *serializer_p = INI_STR("aerospike.serializer");
+
+    add_assoc_long(return_p, "connect_timeout", connect_timeout);
+    add_assoc_long(return_p, "read_timeout", read_timeout);
+    add_assoc_long(return_p, "write_timeout", write_timeout);
+    add_assoc_long(return_p, "key_policy", key_policy);
+    add_assoc_long(return_p, "key_gen", key_gen);
+    add_assoc_long(return_p, "nesting_depth", nesting_depth);
+    add_assoc_string(return_p, "serializer", serializer_p ? serializer_p : "", 1);
+}
@@ -22,7 +22,11 @@ enum Aerospike_constants {
     OPT_POLICY_GEN,
     OPT_POLICY_REPLICA,       /* set to one of Aerospike::POLICY_REPLICA_* */
     OPT_POLICY_CONSISTENCY,   /* set to one of Aerospike::POLICY_CONSISTENCY_* */
-    OPT_POLICY_COMMIT_LEVEL   /* set to one of Aerospike::POLICY_COMMIT_LEVEL_* */
+    OPT_POLICY_COMMIT_LEVEL,  /* set to one of Aerospike::POLICY_COMMIT_LEVEL_* */
+    OPT_STREAM_BUFFER_SIZE,   /* records buffered by scan/query streams, default: 256 */
+    OPT_CALLBACK_BATCH_SIZE,  /* records passed per scan/query callback call, default: unbatched */
+    OPT_FILE_GZIP,            /* boolean value, gzip the files of scanToFile(), default: false */
+    OPT_IMPORT_CONCURRENCY    /* writes in flight during importFile(), default: 16 */
 };
 
 /*
@@ -40,6 +44,34 @@ enum Aerospike_serializer_values {
 
 #define SERIALIZER_DEFAULT "1"
 
+/*
+ *******************************************************************************************************
+ * Enum for PHP client's FILE_FORMAT_* constant values. Possible values for
+ * the format of Aerospike::scanToFile() and Aerospike::importFile().
+ *******************************************************************************************************
+ */
+enum Aerospike_file_format_values {
+    FILE_FORMAT_NDJSON,                                 /* one JSON record per line */
+    FILE_FORMAT_CSV,
+    FILE_FORMAT_MSGPACK,
+};
+
+/*
+ *******************************************************************************************************
+ * Enum for PHP client's AGG_* constant values. Possible values for the "op"
+ * of the aggregations of Aerospike::scanAggregate() and
+ * Aerospike::queryAggregate().
+ *******************************************************************************************************
+ */
+enum Aerospike_aggregation_values {
+    AGG_COUNT,
+    AGG_SUM,
+    AGG_MIN,
+    AGG_MAX,
+    AGG_DISTINCT,                                       /* estimated distinct count */
+    AGG_HISTOGRAM,
+};
+
 #define MAX_CONSTANT_STR_SIZE 512
 /*
  *******************************************************************************************************
@@ -75,6 +107,10 @@ AerospikeConstants aerospike_constants[] = {
     { OPT_POLICY_REPLICA                    ,   "OPT_POLICY_REPLICA"                },
     { OPT_POLICY_CONSISTENCY                ,   "OPT_POLICY_CONSISTENCY"            },
     { OPT_POLICY_COMMIT_LEVEL               ,   "OPT_POLICY_COMMIT_LEVEL"           },
+    { OPT_STREAM_BUFFER_SIZE                ,   "OPT_STREAM_BUFFER_SIZE"            },
+    { OPT_CALLBACK_BATCH_SIZE               ,   "OPT_CALLBACK_BATCH_SIZE"           },
+    { OPT_FILE_GZIP                         ,   "OPT_FILE_GZIP"                     },
+    { OPT_IMPORT_CONCURRENCY                ,   "OPT_IMPORT_CONCURRENCY"            },
     { AS_POLICY_RETRY_NONE                  ,   "POLICY_RETRY_NONE"                 },
     { AS_POLICY_RETRY_ONCE                  ,   "POLICY_RETRY_ONCE"                 },
     { AS_POLICY_EXISTS_IGNORE               ,   "POLICY_EXISTS_IGNORE"              },
@@ -86,6 +122,15 @@ AerospikeConstants aerospike_constants[] = {
     { SERIALIZER_PHP                        ,   "SERIALIZER_PHP"                    },
     { SERIALIZER_JSON                       ,   "SERIALIZER_JSON"                   },
     { SERIALIZER_USER                       ,   "SERIALIZER_USER"                   },
+    { FILE_FORMAT_NDJSON                    ,   "FILE_FORMAT_NDJSON"                },
+    { FILE_FORMAT_CSV                       ,   "FILE_FORMAT_CSV"                   },
+    { FILE_FORMAT_MSGPACK                   ,   "FILE_FORMAT_MSGPACK"               },
+    { AGG_COUNT                             ,   "AGG_COUNT"                         },
+    { AGG_SUM                               ,   "AGG_SUM"                           },
+    { AGG_MIN                               ,   "AGG_MIN"                           },
+    { AGG_MAX                               ,   "AGG_MAX"                           },
+    { AGG_DISTINCT                          ,   "AGG_DISTINCT"                      },
+    { AGG_HISTOGRAM                         ,   "AGG_HISTOGRAM"                     },
     { AS_UDF_TYPE_LUA                       ,   "UDF_TYPE_LUA"                      },
     { AS_SCAN_PRIORITY_AUTO 		        ,   "SCAN_PRIORITY_AUTO" 		        },
     { AS_SCAN_PRIORITY_LOW 		            ,   "SCAN_PRORITY_LOW" 			        },
@@ -139,31 +139,35 @@ exit:
 
 /*
  ******************************************************************************************************
- Executes a query in the Aerospike DB.
+ Starts a query in the Aerospike DB whose records are streamed to the PHP
+ thread through a bounded buffer (see aerospike_stream.c).
  *
  * @param as_object_p               The C client's aerospike object.
  * @param error_p                   The C client's as_error to be set to the encountered error.
  * @param namespace_p               The namespace to scan.
  * @param set_p                     The set to scan.
- * @param user_func_p               The user's callback to be applied per record
- *                                  that is scanned.
  * @param bins_ht_p                 The HashTable for optional filter bins array.
  * @param predicate_p               The HashTable for Query Predicate array.
  * @param options_p                 The optional policy.
+ * @param stream_pp                 Set to the started stream on success. It
+ *                                  owns the query and must be released with
+ *                                  aerospike_stream_destroy().
  *
  * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
  ******************************************************************************************************
  */
 extern as_status
-aerospike_query_run(aerospike* as_object_p, as_error* error_p, char* namespace_p,
-        char* set_p, userland_callback* user_func_p, HashTable* bins_ht_p,
-        HashTable* predicate_ht_p, zval* options_p TSRMLS_DC)
+aerospike_query_stream(aerospike* as_object_p, as_error* error_p,
+        char* namespace_p, char* set_p, HashTable* bins_ht_p,
+        HashTable* predicate_ht_p, zval* options_p,
+        aerospike_stream** stream_pp TSRMLS_DC)
 {
-    as_query            query;
-    bool                is_init_query = false;
+    as_query*           query_p = NULL;
     as_policy_query     query_policy;
+    uint32_t            buffer_size = AEROSPIKE_STREAM_DEFAULT_CAPACITY;
+    aerospike_stream*   stream_p = NULL;
 
-    if ((!as_object_p) || (!error_p) || (!namespace_p) || (!set_p)) {
+    if ((!as_object_p) || (!error_p) || (!namespace_p) || (!set_p) || (!stream_pp)) {
         DEBUG_PHP_EXT_DEBUG("Unable to initiate query");
         PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR, "Unable to initiate query");
         goto exit;
@@ -176,54 +180,122 @@ aerospike_query_run(aerospike* as_object_p, as_error* error_p, char* namespace_p
         goto exit;
     }
 
-    as_query_init(&query, namespace_p, set_p);
-    is_init_query = true;
+    get_stream_buffer_size(options_p, &buffer_size, error_p TSRMLS_CC);
+    if (AEROSPIKE_OK != (error_p->code)) {
+        DEBUG_PHP_EXT_DEBUG("Unable to set stream buffer size");
+        goto exit;
+    }
+
+    /*
+     * The query outlives this call (it is run by the stream's worker
+     * thread), so it is allocated on the heap and owned by the stream.
+     */
+    if (NULL == (query_p = as_query_new(namespace_p, set_p))) {
+        DEBUG_PHP_EXT_DEBUG("Unable to initialize a query");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR, "Unable to initiate query");
+        goto exit;
+    }
 
     if (predicate_ht_p) {
-        as_query_where_inita(&query, 1);
+        as_query_where_init(query_p, 1);
     }
 
-    if (AEROSPIKE_OK != (aerospike_query_define(&query, error_p, namespace_p,
+    if (AEROSPIKE_OK != (aerospike_query_define(query_p, error_p, namespace_p,
                     set_p, predicate_ht_p, NULL, NULL, NULL TSRMLS_CC))) {
         DEBUG_PHP_EXT_DEBUG("Unable to define scan");
         goto exit;
     }
 
     if (bins_ht_p) {
-        as_query_select_inita(&query, zend_hash_num_elements(bins_ht_p));
+        as_query_select_init(query_p, zend_hash_num_elements(bins_ht_p));
         HashPosition pos;
         zval **bin_names_pp = NULL;
         foreach_hashtable(bins_ht_p, pos, bin_names_pp) {
             if (Z_TYPE_PP(bin_names_pp) != IS_STRING) {
                 convert_to_string_ex(bin_names_pp);
             }
-            if (!as_query_select(&query, Z_STRVAL_PP(bin_names_pp))) {
+            if (!as_query_select(query_p, Z_STRVAL_PP(bin_names_pp))) {
                 DEBUG_PHP_EXT_DEBUG("Unable to apply filter bins to the query");
                 PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR,
                         "Unable to apply filter bins to the query");
                 goto exit;
             }
         }
-        if (AEROSPIKE_OK != (aerospike_query_foreach(as_object_p, error_p,
-                        &query_policy, &query,
-                        aerospike_helper_record_stream_callback,
-                        user_func_p))) {
-            DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
-            goto exit;
-        }
-    } else if (AEROSPIKE_OK != (aerospike_query_foreach(as_object_p, error_p,
-                    NULL, &query, aerospike_helper_record_stream_callback,
-                    user_func_p))) {
+    }
+
+    /*
+     * Records are handed over from the C client's node threads through a
+     * bounded ring and are consumed on this thread only.
+     */
+    if (NULL == (stream_p = aerospike_stream_create(as_object_p, buffer_size))) {
+        DEBUG_PHP_EXT_DEBUG("Unable to create the record stream");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT, "Unable to create the record stream");
+        goto exit;
+    }
+
+    if (AEROSPIKE_OK != aerospike_stream_start_query(stream_p, &query_policy,
+                query_p, true, error_p)) {
         DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
+        aerospike_stream_destroy(stream_p, NULL, false);
+        query_p = NULL;
         goto exit;
     }
+
+    query_p = NULL;
+    *stream_pp = stream_p;
 exit:
-    if (is_init_query) {
-        as_query_destroy(&query);
+    if (query_p) {
+        as_query_destroy(query_p);
     }
     return error_p->code;
 }
 
+/*
+ ******************************************************************************************************
+ Executes a query in the Aerospike DB.
+ *
+ * @param as_object_p               The C client's aerospike object.
+ * @param error_p                   The C client's as_error to be set to the encountered error.
+ * @param namespace_p               The namespace to scan.
+ * @param set_p                     The set to scan.
+ * @param user_func_p               The user's callback to be applied per record
+ *                                  that is scanned.
+ * @param bins_ht_p                 The HashTable for optional filter bins array.
+ * @param predicate_p               The HashTable for Query Predicate array.
+ * @param options_p                 The optional policy.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ ******************************************************************************************************
+ */
+extern as_status
+aerospike_query_run(aerospike* as_object_p, as_error* error_p, char* namespace_p,
+        char* set_p, userland_callback* user_func_p, HashTable* bins_ht_p,
+        HashTable* predicate_ht_p, zval* options_p TSRMLS_DC)
+{
+    aerospike_stream*   stream_p = NULL;
+    uint32_t            batch_size = 0;
+
+    get_callback_batch_size(options_p, &batch_size, error_p TSRMLS_CC);
+    if (AEROSPIKE_OK != error_p->code) {
+        goto exit;
+    }
+
+    if (AEROSPIKE_OK != aerospike_query_stream(as_object_p, error_p,
+                namespace_p, set_p, bins_ht_p, predicate_ht_p, options_p,
+                &stream_p TSRMLS_CC)) {
+        goto exit;
+    }
+
+    /* only the waits for the records are timed as network time */
+    if (AEROSPIKE_OK != aerospike_stream_run(stream_p, user_func_p, batch_size,
+                error_p TSRMLS_CC)) {
+        DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
+        goto exit;
+    }
+exit:
+    return error_p->code;
+}
+
 /*
  ******************************************************************************************************
  Executes a query aggregation in the Aerospike DB by applying the UDF.
@@ -337,14 +409,17 @@ aerospike_query_aggregate(aerospike* as_object_p, as_error* error_p,
             }
         }
 
-        if (AEROSPIKE_OK != (aerospike_query_foreach(as_object_p, error_p,
-                        &query_policy, &query,
-                        aerospike_helper_aggregate_callback,
-                        &aggregate_result_callback_udata))) {
+        if (AEROSPIKE_OK != AEROSPIKE_STATS_NET(as_object_p, NULL, namespace_p, set_p,
+                        zend_hash_num_elements(bins_ht_p),
+                        aerospike_query_foreach(as_object_p, error_p,
+                            &query_policy, &query,
+                            aerospike_helper_aggregate_callback,
+                            &aggregate_result_callback_udata))) {
             DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
             goto exit;
         }
-    } else if (AEROSPIKE_OK != (aerospike_query_foreach(as_object_p, error_p,
+    } else if (AEROSPIKE_OK != AEROSPIKE_STATS_NET(as_object_p, NULL, namespace_p, set_p, 0,
+                aerospike_query_foreach(as_object_p, error_p,
                     &query_policy, &query, aerospike_helper_aggregate_callback,
                     &aggregate_result_callback_udata))) {
         DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
@@ -421,3 +496,90 @@ exit:
     aerospike_helper_free_static_pool(&udf_pool);
     return error_p->code;
 }
+
+/*
+ ******************************************************************************************************
+ * Queries a set in the Aerospike DB and reduces the matching records with
+ * the built-in reducers of aerospike_reduce.c. Only the bins the
+ * aggregations read are fetched from the cluster.
+ *
+ * @param as_object_p               The C client's aerospike object.
+ * @param error_p                   The C client's as_error to be set to the encountered error.
+ * @param namespace_p               The namespace to query.
+ * @param set_p                     The set to query.
+ * @param predicate_ht_p            The HashTable for Query Predicate array.
+ * @param aggregations_ht_p         The HashTable of the named aggregations.
+ * @param result_p                  The array to be filled with one result
+ *                                  per aggregation.
+ * @param options_p                 The optional policy.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ ******************************************************************************************************
+ */
+extern as_status
+aerospike_query_reduce(aerospike* as_object_p, as_error* error_p,
+        char* namespace_p, char* set_p, HashTable* predicate_ht_p,
+        HashTable* aggregations_ht_p, zval* result_p, zval* options_p TSRMLS_DC)
+{
+    as_query            query;
+    as_policy_query     query_policy;
+    aerospike_reducer*  reducer_p = NULL;
+    bool                is_init_query = false;
+    uint32_t            n_bins = 0;
+    uint32_t            i = 0;
+
+    if (NULL == (reducer_p = aerospike_reducer_create(aggregations_ht_p, error_p TSRMLS_CC))) {
+        goto exit;
+    }
+
+    set_policy(NULL, NULL, NULL, NULL, NULL, NULL, &query_policy, NULL,
+            options_p, error_p TSRMLS_CC);
+    if (AEROSPIKE_OK != (error_p->code)) {
+        DEBUG_PHP_EXT_DEBUG("Unable to set policy");
+        goto exit;
+    }
+
+    if (NULL == as_query_init(&query, namespace_p, set_p)) {
+        DEBUG_PHP_EXT_DEBUG("Unable to initialize a query");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR, "Unable to initialize a query");
+        goto exit;
+    }
+
+    is_init_query = true;
+    as_query_where_init(&query, 1);
+    if (AEROSPIKE_OK != (aerospike_query_define(&query, error_p, namespace_p,
+                    set_p, predicate_ht_p, NULL, NULL, NULL TSRMLS_CC))) {
+        DEBUG_PHP_EXT_DEBUG("Unable to define query");
+        goto exit;
+    }
+
+    while (aerospike_reducer_bin(reducer_p, n_bins)) {
+        n_bins++;
+    }
+    if (n_bins) {
+        as_query_select_init(&query, n_bins);
+        for (i = 0; i < n_bins; i++) {
+            if (!as_query_select(&query, aerospike_reducer_bin(reducer_p, i))) {
+                DEBUG_PHP_EXT_DEBUG("Unable to apply filter bins to the query");
+                PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR,
+                        "Unable to apply filter bins to the query");
+                goto exit;
+            }
+        }
+    }
+
+    if (AEROSPIKE_OK != AEROSPIKE_STATS_NET(as_object_p, NULL, namespace_p, set_p, n_bins,
+                aerospike_query_foreach(as_object_p, error_p,
+                    &query_policy, &query, aerospike_reducer_callback, reducer_p))) {
+        DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
+        goto exit;
+    }
+
+    aerospike_reducer_result(reducer_p, result_p, error_p TSRMLS_CC);
+exit:
+    aerospike_reducer_destroy(reducer_p);
+    if (is_init_query) {
+        as_query_destroy(&query);
+    }
+    return error_p->code;
+}
@@ -142,8 +142,10 @@ extern as_status aerospike_record_operations_exists(aerospike* as_object_p,
         goto exit;
     }
 
-    if (AEROSPIKE_OK != aerospike_key_exists(as_object_p, error_p,
-                    &read_policy, as_key_p, &record_p)) {
+    if (AEROSPIKE_OK != AEROSPIKE_STATS_NET_READ(as_object_p, as_key_p,
+                read_policy.replica, 0,
+                aerospike_key_exists(as_object_p, error_p,
+                    &read_policy, as_key_p, &record_p))) {
         goto exit;
     }
 
@@ -195,7 +197,8 @@ aerospike_record_operations_remove(Aerospike_object* aerospike_obj_p,
     }
 
     get_generation_value(options_p, &remove_policy.generation, error_p TSRMLS_CC);
-    aerospike_key_remove(as_object_p, error_p, &remove_policy, as_key_p);
+    AEROSPIKE_STATS_NET(as_object_p, as_key_p, NULL, NULL, 0,
+            aerospike_key_remove(as_object_p, error_p, &remove_policy, as_key_p));
 
 exit: 
     return error_p->code;
@@ -264,8 +267,11 @@ aerospike_record_operations_general(Aerospike_object* aerospike_obj_p,
         goto exit;
     }
 
-    aerospike_key_operate(as_object_p, error_p,
-                    &operate_policy, as_key_p, &ops, NULL);
+    AEROSPIKE_STATS_NET_READ(as_object_p, as_key_p,
+            aerospike_stats_operate_replica(&ops, operate_policy.replica),
+            ops.binops.size,
+            aerospike_key_operate(as_object_p, error_p,
+                    &operate_policy, as_key_p, &ops, NULL));
 
 exit: 
      if (get_rec) {
@@ -368,8 +374,11 @@ aerospike_record_operations_operate(Aerospike_object* aerospike_obj_p,
         }
     }
 
-    if (AEROSPIKE_OK != (status = aerospike_key_operate(as_object_p, error_p,
-                    &operate_policy, as_key_p, &ops, &get_rec))) {
+    if (AEROSPIKE_OK != (status = AEROSPIKE_STATS_NET_READ(as_object_p, as_key_p,
+                    aerospike_stats_operate_replica(&ops, operate_policy.replica),
+                    ops.binops.size,
+                    aerospike_key_operate(as_object_p, error_p,
+                        &operate_policy, as_key_p, &ops, &get_rec)))) {
         DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
         goto exit;
     } else {
@@ -452,8 +461,10 @@ aerospike_record_operations_remove_bin(Aerospike_object* aerospike_obj_p,
     }
 
     get_generation_value(options_p, &rec.gen, error_p TSRMLS_CC);
-    if (AEROSPIKE_OK != (status = aerospike_key_put(as_object_p, error_p,
-                    NULL, as_key_p, &rec))) {
+    if (AEROSPIKE_OK != (status = AEROSPIKE_STATS_NET(as_object_p, as_key_p, NULL, NULL,
+                    rec.bins.size,
+                    aerospike_key_put(as_object_p, error_p,
+                        NULL, as_key_p, &rec)))) {
          goto exit;
     }
 
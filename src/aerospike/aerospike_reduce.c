@@ -0,0 +1,664 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "php.h"
+#include "aerospike/as_log.h"
+#include "aerospike/as_error.h"
+#include "aerospike/as_status.h"
+#include "aerospike/as_record.h"
+#include "aerospike/aerospike.h"
+#include "aerospike_common.h"
+#include "aerospike_policy.h"
+
+/*
+ *******************************************************************************************************
+ * Built-in reducers of Aerospike::scanAggregate() and
+ * Aerospike::queryAggregate(). They run in the C client's callback, which
+ * may be invoked from the node threads, so each thread accumulates its own
+ * partial results (no locking per record) and the partials are merged on
+ * the PHP thread once the scan/query is over. Nothing PHP is touched from
+ * the callback.
+ *******************************************************************************************************
+ */
+#define AEROSPIKE_REDUCE_BUCKET     "bucket"
+#define AEROSPIKE_REDUCE_HLL_BITS   12
+#define AEROSPIKE_REDUCE_HLL_SIZE   (1 << AEROSPIKE_REDUCE_HLL_BITS)
+
+/*
+ * Histogram buckets, counted in an open addressing hash table.
+ */
+typedef struct aerospike_reduce_histogram_s {
+    int64_t     *buckets_p;
+    uint64_t    *counts_p;
+    bool        *used_p;
+    uint32_t    capacity;
+    uint32_t    size;
+} aerospike_reduce_histogram;
+
+typedef struct aerospike_reduce_state_s {
+    uint64_t                    count;
+    int64_t                     value;
+    bool                        has_value;
+    uint8_t                     *registers_p;
+    aerospike_reduce_histogram  histogram;
+} aerospike_reduce_state;
+
+typedef struct aerospike_reduce_partial_s {
+    aerospike_reduce_state      *states_p;
+} aerospike_reduce_partial;
+
+typedef struct aerospike_reduce_spec_s {
+    char        *name_p;
+    uint        name_len;
+    long        op;
+    char        bin[AS_BIN_NAME_MAX_SIZE];
+    int64_t     bucket;
+} aerospike_reduce_spec;
+
+struct aerospike_reducer_s {
+    uint64_t                    id;
+    aerospike_reduce_spec       *specs_p;
+    uint32_t                    n_specs;
+    pthread_mutex_t             lock;
+    aerospike_reduce_partial    **partials_pp;
+    uint32_t                    n_partials;
+    uint32_t                    partials_capacity;
+    volatile bool               failed;
+};
+
+/*
+ * Each node thread remembers its partial results, tagged with the id of
+ * the reducer they belong to so that a later aggregation never reuses them.
+ */
+static uint64_t aerospike_reduce_serial = 0;
+static __thread uint64_t aerospike_reduce_tls_id = 0;
+static __thread aerospike_reduce_partial *aerospike_reduce_tls_partial_p = NULL;
+
+/*
+ *******************************************************************************************************
+ * Histogram helpers.
+ *******************************************************************************************************
+ */
+static uint32_t
+reduce_histogram_slot(const aerospike_reduce_histogram *histogram_p, int64_t bucket)
+{
+    uint64_t    hash = (uint64_t) bucket * 0x9E3779B97F4A7C15ULL;
+    uint32_t    slot = (uint32_t) (hash >> 32) & (histogram_p->capacity - 1);
+
+    while (histogram_p->used_p[slot] && histogram_p->buckets_p[slot] != bucket) {
+        slot = (slot + 1) & (histogram_p->capacity - 1);
+    }
+    return slot;
+}
+
+static bool
+reduce_histogram_add(aerospike_reduce_histogram *histogram_p, int64_t bucket, uint64_t count)
+{
+    aerospike_reduce_histogram  grown = {0};
+    uint32_t                    slot = 0;
+    uint32_t                    i = 0;
+
+    if ((histogram_p->size + 1) * 10 > histogram_p->capacity * 7) {
+        grown.capacity = histogram_p->capacity ? histogram_p->capacity * 2 : 64;
+        grown.buckets_p = malloc(grown.capacity * sizeof(int64_t));
+        grown.counts_p = malloc(grown.capacity * sizeof(uint64_t));
+        grown.used_p = calloc(grown.capacity, sizeof(bool));
+        if (!grown.buckets_p || !grown.counts_p || !grown.used_p) {
+            free(grown.buckets_p);
+            free(grown.counts_p);
+            free(grown.used_p);
+            return false;
+        }
+        for (i = 0; i < histogram_p->capacity; i++) {
+            if (histogram_p->used_p[i]) {
+                slot = reduce_histogram_slot(&grown, histogram_p->buckets_p[i]);
+                grown.used_p[slot] = true;
+                grown.buckets_p[slot] = histogram_p->buckets_p[i];
+                grown.counts_p[slot] = histogram_p->counts_p[i];
+                grown.size++;
+            }
+        }
+        free(histogram_p->buckets_p);
+        free(histogram_p->counts_p);
+        free(histogram_p->used_p);
+        *histogram_p = grown;
+    }
+
+    slot = reduce_histogram_slot(histogram_p, bucket);
+    if (!histogram_p->used_p[slot]) {
+        histogram_p->used_p[slot] = true;
+        histogram_p->buckets_p[slot] = bucket;
+        histogram_p->counts_p[slot] = 0;
+        histogram_p->size++;
+    }
+    histogram_p->counts_p[slot] += count;
+    return true;
+}
+
+static int
+reduce_histogram_compare(const void *a_p, const void *b_p)
+{
+    int64_t     a = ((const int64_t *) a_p)[0];
+    int64_t     b = ((const int64_t *) b_p)[0];
+
+    return (a > b) - (a < b);
+}
+
+/*
+ *******************************************************************************************************
+ * Distinct count sketch: a HyperLogLog of 2^12 registers (about 1.6%
+ * standard error). Integers, strings and bytes are hashed.
+ *******************************************************************************************************
+ */
+static uint64_t
+reduce_hash_mix(uint64_t hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static uint64_t
+reduce_hash_bytes(const uint8_t *data_p, uint32_t size, uint64_t seed)
+{
+    uint64_t    hash = 0xCBF29CE484222325ULL ^ seed;
+    uint32_t    i = 0;
+
+    for (i = 0; i < size; i++) {
+        hash ^= data_p[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return reduce_hash_mix(hash);
+}
+
+static void
+reduce_hll_add(uint8_t *registers_p, uint64_t hash)
+{
+    uint32_t    index = (uint32_t) (hash >> (64 - AEROSPIKE_REDUCE_HLL_BITS));
+    uint64_t    rest = hash << AEROSPIKE_REDUCE_HLL_BITS;
+    uint8_t     rank = 1;
+
+    while (rank <= 64 - AEROSPIKE_REDUCE_HLL_BITS && !(rest & (1ULL << 63))) {
+        rank++;
+        rest <<= 1;
+    }
+    if (registers_p[index] < rank) {
+        registers_p[index] = rank;
+    }
+}
+
+static uint64_t
+reduce_hll_estimate(const uint8_t *registers_p)
+{
+    double      m = AEROSPIKE_REDUCE_HLL_SIZE;
+    double      sum = 0;
+    double      estimate = 0;
+    uint32_t    zeros = 0;
+    uint32_t    i = 0;
+
+    for (i = 0; i < AEROSPIKE_REDUCE_HLL_SIZE; i++) {
+        sum += ldexp(1.0, -registers_p[i]);
+        if (!registers_p[i]) {
+            zeros++;
+        }
+    }
+    estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+    if (estimate <= 2.5 * m && zeros) {
+        /* small range correction: linear counting */
+        estimate = m * log(m / zeros);
+    }
+    return (uint64_t) (estimate + 0.5);
+}
+
+/*
+ *******************************************************************************************************
+ * Accumulates one record into the partial results of the calling thread.
+ *******************************************************************************************************
+ */
+static bool
+reduce_record(aerospike_reducer *reducer_p, aerospike_reduce_partial *partial_p,
+        const as_record *record_p)
+{
+    aerospike_reduce_spec   *spec_p = NULL;
+    aerospike_reduce_state  *state_p = NULL;
+    as_val                  *val_p = NULL;
+    int64_t                 value = 0;
+    int64_t                 bucket = 0;
+    uint32_t                i = 0;
+
+    for (i = 0; i < reducer_p->n_specs; i++) {
+        spec_p = &reducer_p->specs_p[i];
+        state_p = &partial_p->states_p[i];
+        val_p = spec_p->bin[0] ?
+            (as_val *) as_record_get((as_record *) record_p, spec_p->bin) : NULL;
+
+        if (spec_p->op == AGG_COUNT) {
+            if (!spec_p->bin[0] || val_p) {
+                state_p->count++;
+            }
+            continue;
+        }
+        if (!val_p) {
+            continue;
+        }
+        if (spec_p->op == AGG_DISTINCT) {
+            switch (as_val_type(val_p)) {
+                case AS_INTEGER:
+                    value = as_integer_get((as_integer *) val_p);
+                    reduce_hll_add(state_p->registers_p, reduce_hash_mix((uint64_t) value));
+                    break;
+                case AS_STRING:
+                    reduce_hll_add(state_p->registers_p, reduce_hash_bytes(
+                                (uint8_t *) as_string_get((as_string *) val_p),
+                                as_string_len((as_string *) val_p), AS_STRING));
+                    break;
+                case AS_BYTES:
+                    reduce_hll_add(state_p->registers_p, reduce_hash_bytes(
+                                as_bytes_get((as_bytes *) val_p),
+                                as_bytes_size((as_bytes *) val_p), AS_BYTES));
+                    break;
+                default:
+                    break;
+            }
+            continue;
+        }
+        if (as_val_type(val_p) != AS_INTEGER) {
+            continue;
+        }
+        value = as_integer_get((as_integer *) val_p);
+        switch (spec_p->op) {
+            case AGG_SUM:
+                state_p->value += value;
+                state_p->has_value = true;
+                break;
+            case AGG_MIN:
+                if (!state_p->has_value || value < state_p->value) {
+                    state_p->value = value;
+                }
+                state_p->has_value = true;
+                break;
+            case AGG_MAX:
+                if (!state_p->has_value || value > state_p->value) {
+                    state_p->value = value;
+                }
+                state_p->has_value = true;
+                break;
+            case AGG_HISTOGRAM:
+                bucket = value / spec_p->bucket;
+                if ((value % spec_p->bucket) && (value < 0)) {
+                    bucket--;
+                }
+                if (!reduce_histogram_add(&state_p->histogram, bucket * spec_p->bucket, 1)) {
+                    return false;
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+/*
+ *******************************************************************************************************
+ * Allocates the partial results of the calling thread. Must be called with
+ * the reducer's lock held.
+ *******************************************************************************************************
+ */
+static aerospike_reduce_partial *
+reduce_partial_new(aerospike_reducer *reducer_p)
+{
+    aerospike_reduce_partial    *partial_p = NULL;
+    aerospike_reduce_partial    **partials_pp = NULL;
+    uint32_t                    capacity = 0;
+    uint32_t                    i = 0;
+
+    if (reducer_p->n_partials == reducer_p->partials_capacity) {
+        capacity = reducer_p->partials_capacity ? reducer_p->partials_capacity * 2 : 8;
+        if (NULL == (partials_pp = realloc(reducer_p->partials_pp,
+                        capacity * sizeof(*partials_pp)))) {
+            return NULL;
+        }
+        reducer_p->partials_pp = partials_pp;
+        reducer_p->partials_capacity = capacity;
+    }
+
+    if ((NULL == (partial_p = calloc(1, sizeof(aerospike_reduce_partial)))) ||
+            (NULL == (partial_p->states_p = calloc(reducer_p->n_specs,
+                                                   sizeof(aerospike_reduce_state))))) {
+        free(partial_p);
+        return NULL;
+    }
+    for (i = 0; i < reducer_p->n_specs; i++) {
+        if ((reducer_p->specs_p[i].op == AGG_DISTINCT) &&
+                (NULL == (partial_p->states_p[i].registers_p =
+                          calloc(AEROSPIKE_REDUCE_HLL_SIZE, sizeof(uint8_t))))) {
+            while (i--) {
+                free(partial_p->states_p[i].registers_p);
+            }
+            free(partial_p->states_p);
+            free(partial_p);
+            return NULL;
+        }
+    }
+
+    reducer_p->partials_pp[reducer_p->n_partials++] = partial_p;
+    return partial_p;
+}
+
+/*
+ *******************************************************************************************************
+ * Callback for aerospike_scan_foreach()/aerospike_query_foreach(), with the
+ * aerospike_reducer as udata.
+ *
+ * @return false to abort the scan/query when out of memory, else true.
+ *******************************************************************************************************
+ */
+extern bool
+aerospike_reducer_callback(const as_val *val_p, void *udata_p)
+{
+    aerospike_reducer           *reducer_p = (aerospike_reducer *) udata_p;
+    aerospike_reduce_partial    *partial_p = NULL;
+    as_record                   *record_p = NULL;
+
+    if ((!val_p) || (NULL == (record_p = as_record_fromval(val_p)))) {
+        return true;
+    }
+    if (reducer_p->failed) {
+        return false;
+    }
+
+    if (aerospike_reduce_tls_id == reducer_p->id) {
+        partial_p = aerospike_reduce_tls_partial_p;
+    } else {
+        pthread_mutex_lock(&reducer_p->lock);
+        partial_p = reduce_partial_new(reducer_p);
+        pthread_mutex_unlock(&reducer_p->lock);
+        aerospike_reduce_tls_id = reducer_p->id;
+        aerospike_reduce_tls_partial_p = partial_p;
+    }
+
+    if ((!partial_p) || (!reduce_record(reducer_p, partial_p, record_p))) {
+        reducer_p->failed = true;
+        return false;
+    }
+    return true;
+}
+
+/*
+ *******************************************************************************************************
+ * Parses the user's aggregations into a new reducer.
+ *
+ * @param aggregations_ht_p     name => array("op" => Aerospike::AGG_*
+ *                              [, "bin" => bin name [, "bucket" => width ]])
+ * @param error_p               The as_error to be set to the encountered error.
+ *
+ * @return the reducer, or NULL on error.
+ *******************************************************************************************************
+ */
+extern aerospike_reducer *
+aerospike_reducer_create(HashTable *aggregations_ht_p, as_error *error_p TSRMLS_DC)
+{
+    aerospike_reducer       *reducer_p = NULL;
+    aerospike_reduce_spec   *spec_p = NULL;
+    HashPosition            pos;
+    zval                    **spec_pp = NULL;
+    zval                    **op_pp = NULL;
+    zval                    **bin_pp = NULL;
+    zval                    **bucket_pp = NULL;
+    char                    *name_p = NULL;
+    uint                    name_len = 0;
+    ulong                   index = 0;
+
+    if ((!aggregations_ht_p) || (!zend_hash_num_elements(aggregations_ht_p))) {
+        DEBUG_PHP_EXT_DEBUG("No aggregation to compute");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM, "No aggregation to compute");
+        return NULL;
+    }
+
+    reducer_p = ecalloc(1, sizeof(aerospike_reducer));
+    reducer_p->specs_p = ecalloc(zend_hash_num_elements(aggregations_ht_p),
+            sizeof(aerospike_reduce_spec));
+    pthread_mutex_init(&reducer_p->lock, NULL);
+    reducer_p->id = __sync_add_and_fetch(&aerospike_reduce_serial, 1);
+
+    foreach_hashtable(aggregations_ht_p, pos, spec_pp) {
+        spec_p = &reducer_p->specs_p[reducer_p->n_specs++];
+        if (HASH_KEY_IS_STRING != zend_hash_get_current_key_ex(aggregations_ht_p,
+                    &name_p, &name_len, &index, 0, &pos)) {
+            DEBUG_PHP_EXT_DEBUG("Aggregations are expected to be named");
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                    "Aggregations are expected to be named");
+            goto error;
+        }
+        spec_p->name_p = name_p;
+        spec_p->name_len = name_len;
+
+        if ((Z_TYPE_PP(spec_pp) != IS_ARRAY) ||
+                (FAILURE == zend_hash_find(Z_ARRVAL_PP(spec_pp), OP, sizeof(OP),
+                                           (void **) &op_pp)) ||
+                (Z_TYPE_PP(op_pp) != IS_LONG) ||
+                (Z_LVAL_PP(op_pp) < AGG_COUNT) || (Z_LVAL_PP(op_pp) > AGG_HISTOGRAM)) {
+            DEBUG_PHP_EXT_DEBUG("Aggregation is expected to include an 'op' of Aerospike::AGG_*");
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                    "Aggregation is expected to include an 'op' of Aerospike::AGG_*");
+            goto error;
+        }
+        spec_p->op = Z_LVAL_PP(op_pp);
+
+        if (SUCCESS == zend_hash_find(Z_ARRVAL_PP(spec_pp), BIN, sizeof(BIN),
+                    (void **) &bin_pp)) {
+            if ((Z_TYPE_PP(bin_pp) != IS_STRING) || (!Z_STRLEN_PP(bin_pp)) ||
+                    (Z_STRLEN_PP(bin_pp) >= AS_BIN_NAME_MAX_SIZE)) {
+                DEBUG_PHP_EXT_DEBUG("Aggregation 'bin' is expected to be a bin name");
+                PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                        "Aggregation 'bin' is expected to be a bin name");
+                goto error;
+            }
+            strcpy(spec_p->bin, Z_STRVAL_PP(bin_pp));
+        } else if (spec_p->op != AGG_COUNT) {
+            DEBUG_PHP_EXT_DEBUG("Aggregation is expected to include a 'bin'");
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                    "Aggregation is expected to include a 'bin'");
+            goto error;
+        }
+
+        if (spec_p->op == AGG_HISTOGRAM) {
+            if ((FAILURE == zend_hash_find(Z_ARRVAL_PP(spec_pp), AEROSPIKE_REDUCE_BUCKET,
+                            sizeof(AEROSPIKE_REDUCE_BUCKET), (void **) &bucket_pp)) ||
+                    (Z_TYPE_PP(bucket_pp) != IS_LONG) || (Z_LVAL_PP(bucket_pp) <= 0)) {
+                DEBUG_PHP_EXT_DEBUG("Histogram is expected to include a positive 'bucket' width");
+                PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                        "Histogram is expected to include a positive 'bucket' width");
+                goto error;
+            }
+            spec_p->bucket = Z_LVAL_PP(bucket_pp);
+        }
+    }
+    return reducer_p;
+
+error:
+    aerospike_reducer_destroy(reducer_p);
+    return NULL;
+}
+
+/*
+ *******************************************************************************************************
+ * Returns the name of the i-th distinct bin the reducer reads, for the
+ * selection of the bins of the scan/query, or NULL past the last one.
+ *******************************************************************************************************
+ */
+extern const char *
+aerospike_reducer_bin(aerospike_reducer *reducer_p, uint32_t i)
+{
+    uint32_t    found = 0;
+    uint32_t    j = 0;
+    uint32_t    k = 0;
+
+    for (j = 0; j < reducer_p->n_specs; j++) {
+        if (!reducer_p->specs_p[j].bin[0]) {
+            continue;
+        }
+        for (k = 0; k < j; k++) {
+            if (!strcmp(reducer_p->specs_p[k].bin, reducer_p->specs_p[j].bin)) {
+                break;
+            }
+        }
+        if ((k == j) && (found++ == i)) {
+            return reducer_p->specs_p[j].bin;
+        }
+    }
+    return NULL;
+}
+
+/*
+ *******************************************************************************************************
+ * Merges the per-thread partial results into result_p, one entry per
+ * aggregation. Called on the PHP thread once the scan/query is over.
+ *
+ * @param result_p          The array to be filled.
+ * @param error_p           The as_error to be set to the encountered error.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+extern as_status
+aerospike_reducer_result(aerospike_reducer *reducer_p, zval *result_p, as_error *error_p TSRMLS_DC)
+{
+    aerospike_reduce_spec   *spec_p = NULL;
+    aerospike_reduce_state  merged;
+    aerospike_reduce_state  *state_p = NULL;
+    zval                    *histogram_p = NULL;
+    int64_t                 *pairs_p = NULL;
+    uint32_t                i = 0;
+    uint32_t                j = 0;
+    uint32_t                k = 0;
+    uint32_t                n = 0;
+
+    if (reducer_p->failed) {
+        DEBUG_PHP_EXT_DEBUG("Unable to allocate the aggregation results");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
+                "Unable to allocate the aggregation results");
+        return error_p->code;
+    }
+
+    for (i = 0; i < reducer_p->n_specs; i++) {
+        spec_p = &reducer_p->specs_p[i];
+        memset(&merged, 0, sizeof(merged));
+        if (spec_p->op == AGG_DISTINCT) {
+            merged.registers_p = ecalloc(AEROSPIKE_REDUCE_HLL_SIZE, sizeof(uint8_t));
+        }
+
+        for (j = 0; j < reducer_p->n_partials; j++) {
+            state_p = &reducer_p->partials_pp[j]->states_p[i];
+            merged.count += state_p->count;
+            if (state_p->has_value) {
+                if ((!merged.has_value) || (spec_p->op == AGG_SUM) ||
+                        ((spec_p->op == AGG_MIN) && (state_p->value < merged.value)) ||
+                        ((spec_p->op == AGG_MAX) && (state_p->value > merged.value))) {
+                    merged.value = (spec_p->op == AGG_SUM && merged.has_value) ?
+                        merged.value + state_p->value : state_p->value;
+                }
+                merged.has_value = true;
+            }
+            if (merged.registers_p) {
+                for (k = 0; k < AEROSPIKE_REDUCE_HLL_SIZE; k++) {
+                    if (state_p->registers_p[k] > merged.registers_p[k]) {
+                        merged.registers_p[k] = state_p->registers_p[k];
+                    }
+                }
+            }
+            for (k = 0; k < state_p->histogram.capacity; k++) {
+                if (state_p->histogram.used_p[k] && !reduce_histogram_add(&merged.histogram,
+                            state_p->histogram.buckets_p[k], state_p->histogram.counts_p[k])) {
+                    reducer_p->failed = true;
+                }
+            }
+        }
+
+        switch (spec_p->op) {
+            case AGG_COUNT:
+                add_assoc_long_ex(result_p, spec_p->name_p, spec_p->name_len, (long) merged.count);
+                break;
+            case AGG_SUM:
+                add_assoc_long_ex(result_p, spec_p->name_p, spec_p->name_len, (long) merged.value);
+                break;
+            case AGG_MIN:
+            case AGG_MAX:
+                if (merged.has_value) {
+                    add_assoc_long_ex(result_p, spec_p->name_p, spec_p->name_len, (long) merged.value);
+                } else {
+                    add_assoc_null_ex(result_p, spec_p->name_p, spec_p->name_len);
+                }
+                break;
+            case AGG_DISTINCT:
+                add_assoc_long_ex(result_p, spec_p->name_p, spec_p->name_len,
+                        (long) reduce_hll_estimate(merged.registers_p));
+                efree(merged.registers_p);
+                break;
+            case AGG_HISTOGRAM:
+                /* buckets are returned in ascending order */
+                pairs_p = safe_emalloc(merged.histogram.size + 1, 2 * sizeof(int64_t), 0);
+                for (k = 0, n = 0; k < merged.histogram.capacity; k++) {
+                    if (merged.histogram.used_p[k]) {
+                        pairs_p[2 * n] = merged.histogram.buckets_p[k];
+                        pairs_p[2 * n + 1] = (int64_t) merged.histogram.counts_p[k];
+                        n++;
+                    }
+                }
+                qsort(pairs_p, n, 2 * sizeof(int64_t), reduce_histogram_compare);
+                MAKE_STD_ZVAL(histogram_p);
+                array_init(histogram_p);
+                for (k = 0; k < n; k++) {
+                    add_index_long(histogram_p, (ulong) pairs_p[2 * k], (long) pairs_p[2 * k + 1]);
+                }
+                add_assoc_zval_ex(result_p, spec_p->name_p, spec_p->name_len, histogram_p);
+                efree(pairs_p);
+                break;
+        }
+        free(merged.histogram.buckets_p);
+        free(merged.histogram.counts_p);
+        free(merged.histogram.used_p);
+    }
+
+    if (reducer_p->failed) {
+        DEBUG_PHP_EXT_DEBUG("Unable to allocate the aggregation results");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
+                "Unable to allocate the aggregation results");
+    }
+    return error_p->code;
+}
+
+/*
+ *******************************************************************************************************
+ * Frees the reducer and the partial results of all the threads.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_reducer_destroy(aerospike_reducer *reducer_p)
+{
+    aerospike_reduce_partial    *partial_p = NULL;
+    uint32_t                    i = 0;
+    uint32_t                    j = 0;
+
+    if (!reducer_p) {
+        return;
+    }
+    for (i = 0; i < reducer_p->n_partials; i++) {
+        partial_p = reducer_p->partials_pp[i];
+        for (j = 0; j < reducer_p->n_specs; j++) {
+            free(partial_p->states_p[j].registers_p);
+            free(partial_p->states_p[j].histogram.buckets_p);
+            free(partial_p->states_p[j].histogram.counts_p);
+            free(partial_p->states_p[j].histogram.used_p);
+        }
+        free(partial_p->states_p);
+        free(partial_p);
+    }
+    free(reducer_p->partials_pp);
+    pthread_mutex_destroy(&reducer_p->lock);
+    efree(reducer_p->specs_p);
+    efree(reducer_p);
+}
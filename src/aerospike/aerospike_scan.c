@@ -17,73 +17,96 @@
 
 /*
  ******************************************************************************************************
- * Scans a set in the Aerospike DB.
+ * Starts a scan of a set in the Aerospike DB whose records are streamed
+ * to the PHP thread through a bounded buffer (see aerospike_stream.c).
  *
  * @param as_object_p               The C client's aerospike object.
  * @param error_p                   The C client's as_error to be set to the encountered error.
  * @param namespace_p               The namespace to scan.
  * @param set_p                     The set to scan.
- * @param user_func_p               The user's callback to be applied per record
- *                                  that is scanned.
  * @param bins_ht_p                 The HashTable for optional filter bins array.
- * @param percent                   The percentage of data to scan.
- * @param scan_priority             The priority levels for the scan operation.
- * @param concurrent                Whether to scan all nodes in parallel.
- * @param no_bins                   Whether to return only metadata (and no bins).
  * @param options_p                 The optional policy.
+ * @param stream_pp                 Set to the started stream on success. It
+ *                                  owns the scan and must be released with
+ *                                  aerospike_stream_destroy().
  *
  * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
  ******************************************************************************************************
  */
 extern as_status
-aerospike_scan_run(aerospike* as_object_p, as_error* error_p, char* namespace_p,
-        char* set_p, userland_callback* user_func_p, HashTable* bins_ht_p,
-        zval* options_p TSRMLS_DC)
+aerospike_scan_stream(aerospike* as_object_p, as_error* error_p,
+        char* namespace_p, char* set_p, HashTable* bins_ht_p,
+        zval* options_p, aerospike_stream** stream_pp TSRMLS_DC)
 {
-    as_scan             scan;
     as_scan*            scan_p = NULL;
     as_policy_scan      scan_policy;
     uint32_t            serializer_policy = -1;
+    uint32_t            buffer_size = AEROSPIKE_STREAM_DEFAULT_CAPACITY;
+    aerospike_stream*   stream_p = NULL;
 
-    if ((!as_object_p) || (!error_p) || (!namespace_p) || (!set_p)) {
+    if ((!as_object_p) || (!error_p) || (!namespace_p) || (!set_p) || (!stream_pp)) {
         DEBUG_PHP_EXT_DEBUG("Unable to initiate scan");
         PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR, "Unable to initiate scan");
         goto exit;
     }
 
     /*
-     * Please don't change location of as_scan_init().
+     * The scan outlives this call (it is run by the stream's worker
+     * thread), so it is allocated on the heap and owned by the stream.
+     * Please don't change location of as_scan_new().
      */
-    scan_p = &scan;
-    as_scan_init(scan_p, namespace_p, set_p);
+    if (NULL == (scan_p = as_scan_new(namespace_p, set_p))) {
+        DEBUG_PHP_EXT_DEBUG("Unable to initialize a scan");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR, "Unable to initiate scan");
+        goto exit;
+    }
 
     set_policy_scan(&scan_policy, &serializer_policy, scan_p, options_p, error_p TSRMLS_CC);
-    
+
     if (AEROSPIKE_OK != (error_p->code)) {
         DEBUG_PHP_EXT_DEBUG("Unable to set policy");
         goto exit;
     }
-    
+
+    get_stream_buffer_size(options_p, &buffer_size, error_p TSRMLS_CC);
+    if (AEROSPIKE_OK != (error_p->code)) {
+        DEBUG_PHP_EXT_DEBUG("Unable to set stream buffer size");
+        goto exit;
+    }
+
     if (bins_ht_p) {
-        as_scan_select_inita(&scan, zend_hash_num_elements(bins_ht_p));
+        as_scan_select_init(scan_p, zend_hash_num_elements(bins_ht_p));
         HashPosition pos;
         zval **bin_names_pp;
         foreach_hashtable(bins_ht_p, pos, bin_names_pp) {
             if (Z_TYPE_PP(bin_names_pp) != IS_STRING) {
                 convert_to_string_ex(bin_names_pp);
             }
-            as_scan_select(&scan, Z_STRVAL_PP(bin_names_pp));
-        }
-        if (AEROSPIKE_OK != (aerospike_scan_foreach(as_object_p, error_p, &scan_policy,
-                        &scan, aerospike_helper_record_stream_callback, user_func_p))) {
-            goto exit;
-        }
-    } else {
-        if (AEROSPIKE_OK != (aerospike_scan_foreach(as_object_p, error_p, NULL,
-                        &scan, aerospike_helper_record_stream_callback, user_func_p))) {
-            goto exit;
+            as_scan_select(scan_p, Z_STRVAL_PP(bin_names_pp));
         }
     }
+
+    /*
+     * Records are handed over from the C client's node threads through a
+     * bounded ring and are consumed on this thread only, so
+     * OPT_SCAN_CONCURRENTLY can scan all nodes in parallel.
+     */
+    if (NULL == (stream_p = aerospike_stream_create(as_object_p, buffer_size))) {
+        DEBUG_PHP_EXT_DEBUG("Unable to create the record stream");
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT, "Unable to create the record stream");
+        goto exit;
+    }
+
+    if (AEROSPIKE_OK != aerospike_stream_start_scan(stream_p, &scan_policy,
+                scan_p, true, error_p)) {
+        DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
+        aerospike_stream_destroy(stream_p, NULL, false);
+        scan_p = NULL;
+        goto exit;
+    }
+
+    scan_p = NULL;
+    *stream_pp = stream_p;
 exit:
     if (scan_p) {
         as_scan_destroy(scan_p);
@@ -91,6 +114,50 @@ exit:
     return error_p->code;
 }
 
+/*
+ ******************************************************************************************************
+ * Scans a set in the Aerospike DB.
+ *
+ * @param as_object_p               The C client's aerospike object.
+ * @param error_p                   The C client's as_error to be set to the encountered error.
+ * @param namespace_p               The namespace to scan.
+ * @param set_p                     The set to scan.
+ * @param user_func_p               The user's callback to be applied per record
+ *                                  that is scanned.
+ * @param bins_ht_p                 The HashTable for optional filter bins array.
+ * @param options_p                 The optional policy.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ ******************************************************************************************************
+ */
+extern as_status
+aerospike_scan_run(aerospike* as_object_p, as_error* error_p, char* namespace_p,
+        char* set_p, userland_callback* user_func_p, HashTable* bins_ht_p,
+        zval* options_p TSRMLS_DC)
+{
+    aerospike_stream*   stream_p = NULL;
+    uint32_t            batch_size = 0;
+
+    get_callback_batch_size(options_p, &batch_size, error_p TSRMLS_CC);
+    if (AEROSPIKE_OK != error_p->code) {
+        goto exit;
+    }
+
+    if (AEROSPIKE_OK != aerospike_scan_stream(as_object_p, error_p,
+                namespace_p, set_p, bins_ht_p, options_p, &stream_p TSRMLS_CC)) {
+        goto exit;
+    }
+
+    /* only the waits for the records are timed as network time */
+    if (AEROSPIKE_OK != aerospike_stream_run(stream_p, user_func_p, batch_size,
+                error_p TSRMLS_CC)) {
+        DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
+        goto exit;
+    }
+exit:
+    return error_p->code;
+}
+
 /*
  ******************************************************************************************************
  * Scans a set in the Aerospike DB and applies UDF on it.
@@ -175,8 +242,9 @@ aerospike_scan_run_background(aerospike* as_object_p, as_error* error_p,
         goto exit;
     }
 
-    if (AEROSPIKE_OK != (aerospike_scan_background(as_object_p,
-            error_p, &scan_policy, scan_p, &scan_id))) {
+    if (AEROSPIKE_OK != AEROSPIKE_STATS_NET(as_object_p, NULL, namespace_p, set_p, 0,
+                aerospike_scan_background(as_object_p,
+                    error_p, &scan_policy, scan_p, &scan_id))) {
         DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
         goto exit;
     }
@@ -190,8 +258,9 @@ aerospike_scan_run_background(aerospike* as_object_p, as_error* error_p,
             goto exit;
         }
 
-        if (AEROSPIKE_OK != aerospike_scan_wait(as_object_p,
-                error_p, &info_policy, scan_id, 0)) {
+        if (AEROSPIKE_OK != AEROSPIKE_STATS_NET(as_object_p, NULL, namespace_p, set_p, 0,
+                    aerospike_scan_wait(as_object_p,
+                        error_p, &info_policy, scan_id, 0))) {
             DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
             goto exit;
         }
@@ -252,3 +321,71 @@ aerospike_scan_get_info(aerospike* as_object_p, as_error* error_p,
 exit:
     return error_p->code;
 }
+
+/*
+ ******************************************************************************************************
+ * Scans a set in the Aerospike DB and reduces its records with the built-in
+ * reducers of aerospike_reduce.c. Only the bins the aggregations read are
+ * fetched from the cluster.
+ *
+ * @param as_object_p               The C client's aerospike object.
+ * @param error_p                   The C client's as_error to be set to the encountered error.
+ * @param namespace_p               The namespace to scan.
+ * @param set_p                     The set to scan.
+ * @param aggregations_ht_p         The HashTable of the named aggregations.
+ * @param result_p                  The array to be filled with one result
+ *                                  per aggregation.
+ * @param options_p                 The optional policy.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ ******************************************************************************************************
+ */
+extern as_status
+aerospike_scan_reduce(aerospike* as_object_p, as_error* error_p,
+        char* namespace_p, char* set_p, HashTable* aggregations_ht_p,
+        zval* result_p, zval* options_p TSRMLS_DC)
+{
+    as_scan             scan;
+    as_policy_scan      scan_policy;
+    uint32_t            serializer_policy = -1;
+    aerospike_reducer*  reducer_p = NULL;
+    uint32_t            n_bins = 0;
+    uint32_t            i = 0;
+
+    as_scan_init(&scan, namespace_p, set_p);
+
+    if (NULL == (reducer_p = aerospike_reducer_create(aggregations_ht_p, error_p TSRMLS_CC))) {
+        goto exit;
+    }
+
+    set_policy_scan(&scan_policy, &serializer_policy, &scan, options_p, error_p TSRMLS_CC);
+    if (AEROSPIKE_OK != (error_p->code)) {
+        DEBUG_PHP_EXT_DEBUG("Unable to set policy");
+        goto exit;
+    }
+
+    while (aerospike_reducer_bin(reducer_p, n_bins)) {
+        n_bins++;
+    }
+    if (n_bins) {
+        as_scan_select_init(&scan, n_bins);
+        for (i = 0; i < n_bins; i++) {
+            as_scan_select(&scan, aerospike_reducer_bin(reducer_p, i));
+        }
+    } else {
+        as_scan_set_nobins(&scan, true);
+    }
+
+    if (AEROSPIKE_OK != AEROSPIKE_STATS_NET(as_object_p, NULL, namespace_p, set_p, n_bins,
+                aerospike_scan_foreach(as_object_p, error_p,
+                    &scan_policy, &scan, aerospike_reducer_callback, reducer_p))) {
+        DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
+        goto exit;
+    }
+
+    aerospike_reducer_result(reducer_p, result_p, error_p TSRMLS_CC);
+exit:
+    aerospike_reducer_destroy(reducer_p);
+    as_scan_destroy(&scan);
+    return error_p->code;
+}
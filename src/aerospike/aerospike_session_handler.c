@@ -1,17 +1,33 @@
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
+#include <zlib.h>
 #include "php.h"
 #include "php_ini.h"
 #include "php_variables.h"
 #include "php_aerospike.h"
 #include "ext/session/php_session.h"
+#include "ext/standard/md5.h"
+#include "ext/standard/php_smart_str.h"
 #include "aerospike/aerospike.h"
 #include "aerospike/aerospike_key.h"
+#include "aerospike/as_operations.h"
 #include "aerospike/as_config.h"
 #include "aerospike_common.h"
 
 #define AEROSPIKE_SESSION_BIN "PHP_SESSION"
+#define AEROSPIKE_SESSION_MERGE_ATTEMPTS 3
+#define AEROSPIKE_SESSION_MERGE_MAX_DEPTH 64
+
+/*
+ * Formats of the session data in a bytes bin, given by its first byte: as
+ * is, or deflated and preceded by the 4-byte big-endian length inflated.
+ */
+#define AEROSPIKE_SESSION_BYTES_RAW 0x00
+#define AEROSPIKE_SESSION_BYTES_ZLIB 0x01
+#define AEROSPIKE_SESSION_ZLIB_HEADER_SIZE 5
+/* deflate cannot expand its input more than about 1032 times */
+#define AEROSPIKE_SESSION_ZLIB_MAX_RATIO 1032
 
 extern int persist;
 
@@ -66,8 +82,9 @@ exit:
 /*
  *******************************************************************************************************
  * Function to initialize session object.
- * Allocates memory for outer session object only and initializes all fields.
- * Does not allocate memory for internal fields.
+ * Allocates persistent memory for the session object and its aerospike
+ * object, as the session is cached for the lifetime of the process, and
+ * initializes all fields.
  *
  * @param session_p         The aerospike_session object to be initialized.
  * @param error_p           The C SDK's as_error object to be populated by this
@@ -81,17 +98,20 @@ init_session(aerospike_session **session_pp, as_error *error_p TSRMLS_DC)
 {
     as_error_init(error_p);
 
-    if (NULL == (*session_pp = emalloc(sizeof(aerospike_session)))) {
+    if (NULL == (*session_pp = pecalloc(1, sizeof(aerospike_session), 1))) {
         PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
                 "Could not allocate memory for session object");
         DEBUG_PHP_EXT_ERROR("Could not allocate memory for session object");
         goto exit;
     }
 
-    if (NULL != ((*session_pp)->aerospike_obj_p = ecalloc(1, sizeof(Aerospike_object)))) {
+    if (NULL != ((*session_pp)->aerospike_obj_p = pecalloc(1, sizeof(Aerospike_object), 1))) {
         (*session_pp)->aerospike_obj_p->as_ref_p = NULL;
         (*session_pp)->aerospike_obj_p->is_conn_16 = AEROSPIKE_CONN_STATE_FALSE;
         (*session_pp)->aerospike_obj_p->is_persistent = true;
+        (*session_pp)->read_touch = true;
+        (*session_pp)->merge_on_conflict = true;
+        (*session_pp)->replica = AS_POLICY_REPLICA_MASTER;
     } else {
         PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
                 "Could not allocate memory for aerospike object");
@@ -102,31 +122,313 @@ exit:
     return error_p->code;
 }
 
+/*
+ *******************************************************************************************************
+ * Function to forget what the read of the current request returned.
+ *
+ * @param session_p         The aerospike_session object.
+ * @param free_read         Whether to free the read state. Not when the
+ *                          request that allocated it is over, its memory
+ *                          being gone with it.
+ *******************************************************************************************************
+ */
+static void
+session_reset_read(aerospike_session *session_p, bool free_read TSRMLS_DC)
+{
+    if (free_read && session_p->read_id_p) {
+        efree(session_p->read_id_p);
+    }
+    if (free_read && session_p->read_data_p) {
+        efree(session_p->read_data_p);
+    }
+    session_p->read_id_p = NULL;
+    session_p->read_data_p = NULL;
+    session_p->read_found = false;
+    session_p->read_ttl = 0;
+    session_p->read_gen = 0;
+    session_p->read_len = 0;
+}
+
 /*
  *******************************************************************************************************
  * Function to destroy session object.
- * De-allocates memory for outer session object as well as internal fields
- * except ns_p and set_p.
+ * Releases the connection held by the session and de-allocates memory for
+ * outer session object as well as its aerospike object. The read state is
+ * expected to have been reset already.
  *
  * @param session_p         The aerospike_session object to be destroyed.
- *
- * @return AEROSPIKE::OK if success. Otherwise AEROSPIKE_x.
  *******************************************************************************************************
  */
 static void
 destroy_session(aerospike_session *session_p TSRMLS_DC)
 {
+    as_error            error;
+
     if (session_p && session_p->aerospike_obj_p) {
+        if (session_p->aerospike_obj_p->as_ref_p &&
+                AEROSPIKE_OK != aerospike_helper_close_php_connection(
+                    session_p->aerospike_obj_p, &error TSRMLS_CC)) {
+            DEBUG_PHP_EXT_ERROR("Aerospike close returned error");
+        }
         session_p->aerospike_obj_p->as_ref_p = NULL;
-        efree(session_p->aerospike_obj_p);
+        pefree(session_p->aerospike_obj_p, 1);
         session_p->aerospike_obj_p = NULL;
-        efree(session_p);
+        pefree(session_p, 1);
         DEBUG_PHP_EXT_INFO("aerospike session object destroyed");
     } else {
         DEBUG_PHP_EXT_ERROR("invalid aerospike object");
     }
 }
 
+/*
+ *******************************************************************************************************
+ * Destructor of the entries of the session cache.
+ *******************************************************************************************************
+ */
+static void
+session_cache_entry_dtor(void *entry_p)
+{
+    TSRMLS_FETCH();
+    destroy_session(*((aerospike_session **) entry_p) TSRMLS_CC);
+}
+
+/*
+ *******************************************************************************************************
+ * Function to look up the session cached for a save_path.
+ *
+ * @param save_path         The session save path.
+ *
+ * @return The cached aerospike_session object, or NULL if none.
+ *******************************************************************************************************
+ */
+static aerospike_session *
+session_cache_find(const char *save_path TSRMLS_DC)
+{
+    aerospike_session   **session_pp = NULL;
+
+    if (AEROSPIKE_G(session_cache_g) &&
+            SUCCESS == zend_hash_find(AEROSPIKE_G(session_cache_g), save_path,
+                strlen(save_path) + 1, (void **) &session_pp)) {
+        return *session_pp;
+    }
+    return NULL;
+}
+
+/*
+ *******************************************************************************************************
+ * Function to cache a session opened for a save_path, together with the
+ * connection it holds, for the lifetime of the process.
+ *
+ * @param save_path         The session save path.
+ * @param session_p         The aerospike_session object opened for it.
+ * @param error_p           The C SDK's as_error object to be populated by this
+ *                          method in case of any errors if encountered.
+ *
+ * @return AEROSPIKE::OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+static as_status
+session_cache_add(const char *save_path, aerospike_session *session_p,
+        as_error *error_p TSRMLS_DC)
+{
+    as_error_init(error_p);
+
+    if (!AEROSPIKE_G(session_cache_g)) {
+        AEROSPIKE_G(session_cache_g) = (HashTable *) pemalloc(sizeof(HashTable), 1);
+        zend_hash_init(AEROSPIKE_G(session_cache_g), 4, NULL,
+                session_cache_entry_dtor, 1);
+    }
+
+    if (SUCCESS != zend_hash_update(AEROSPIKE_G(session_cache_g), save_path,
+                strlen(save_path) + 1, (void *) &session_p,
+                sizeof(aerospike_session *), NULL)) {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
+                "Unable to cache the session object");
+        DEBUG_PHP_EXT_ERROR("Unable to cache the session object");
+    }
+    return error_p->code;
+}
+
+/*
+ *******************************************************************************************************
+ * Function to destroy the session cache, releasing the connections of the
+ * cached sessions. Called when the module globals are destroyed.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_session_cache_destroy(TSRMLS_D)
+{
+    if (AEROSPIKE_G(session_cache_g)) {
+        zend_hash_destroy(AEROSPIKE_G(session_cache_g));
+        pefree(AEROSPIKE_G(session_cache_g), 1);
+        AEROSPIKE_G(session_cache_g) = NULL;
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Function to remember what the read of this request returned: the session
+ * id, whether the record was found, its remaining TTL and a digest of the
+ * session data. The write compares the data it is given against it.
+ *
+ * @param session_p         The aerospike_session object.
+ * @param key               The session id that was read.
+ * @param val               The session data read, or NULL if not found.
+ * @param vallen            The length of val.
+ * @param ttl               The remaining TTL of the record read.
+ * @param gen               The generation of the record read.
+ *******************************************************************************************************
+ */
+static void
+session_remember_read(aerospike_session *session_p, const char *key,
+        const char *val, size_t vallen, uint32_t ttl, uint16_t gen TSRMLS_DC)
+{
+    PHP_MD5_CTX         context;
+
+    if (session_p->read_id_p) {
+        efree(session_p->read_id_p);
+    }
+    if (session_p->read_data_p) {
+        efree(session_p->read_data_p);
+        session_p->read_data_p = NULL;
+    }
+    session_p->read_id_p = estrdup(key);
+    session_p->read_found = (val != NULL);
+    session_p->read_ttl = ttl;
+    session_p->read_gen = gen;
+    session_p->read_len = vallen;
+    if (val && session_p->check_gen) {
+        /* the base of a merge, should another request write meanwhile */
+        session_p->read_data_p = estrndup(val, vallen);
+    }
+    if (val) {
+        PHP_MD5Init(&context);
+        PHP_MD5Update(&context, (const unsigned char *) val, vallen);
+        PHP_MD5Final(session_p->read_digest, &context);
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Function to check whether the session data to be written is the data this
+ * request read for the same session id.
+ *
+ * @param session_p         The aerospike_session object.
+ * @param key               The session id to be written.
+ * @param val               The session data to be written.
+ * @param vallen            The length of val.
+ *
+ * @return true if the data is unchanged. Otherwise false.
+ *******************************************************************************************************
+ */
+static bool
+session_is_unchanged(aerospike_session *session_p, const char *key,
+        const char *val, size_t vallen TSRMLS_DC)
+{
+    PHP_MD5_CTX         context;
+    unsigned char       digest[AEROSPIKE_SESSION_DIGEST_SIZE];
+
+    if (!session_p->read_found || !session_p->read_id_p ||
+            strcmp(session_p->read_id_p, key) || session_p->read_len != vallen) {
+        return false;
+    }
+
+    PHP_MD5Init(&context);
+    PHP_MD5Update(&context, (const unsigned char *) val, vallen);
+    PHP_MD5Final(digest, &context);
+    return !memcmp(digest, session_p->read_digest, AEROSPIKE_SESSION_DIGEST_SIZE);
+}
+
+/*
+ *******************************************************************************************************
+ * Function to build the operate policy of the session commands from the
+ * save_path options.
+ *
+ * @param session_p         The aerospike_session object.
+ * @param policy_p          The as_policy_operate to be initialized.
+ * @param timeout_ms        The timeout option of the command, 0 if not set.
+ *******************************************************************************************************
+ */
+static void
+session_operate_policy(aerospike_session *session_p, as_policy_operate *policy_p,
+        uint32_t timeout_ms)
+{
+    as_policy_operate_init(policy_p);
+    policy_p->replica = session_p->replica;
+    if (timeout_ms > 0) {
+        policy_p->timeout = timeout_ms;
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Function to tell whether the session read also touches the record. With
+ * concurrency=generation it does not: a touch bumps the generation, so a
+ * request that only reads the session would make the write of every
+ * concurrent request for it conflict. Nor does it with lazy_touch, so that
+ * the write can skip the touch of a recently touched session.
+ *
+ * @param session_p         The aerospike_session object.
+ *
+ * @return true if the read touches the record. Otherwise false.
+ *******************************************************************************************************
+ */
+static bool
+session_read_touches(aerospike_session *session_p)
+{
+    return session_p->read_touch && !session_p->check_gen &&
+        session_p->lazy_touch_sec == 0;
+}
+
+/*
+ *******************************************************************************************************
+ * Function to refresh the TTL of an unchanged session without rewriting it.
+ * Nothing is sent if the read of this request has touched the record
+ * already, or within lazy_touch seconds of the record's last write or
+ * touch; otherwise the record is touched.
+ *
+ * @param session_p         The aerospike_session object.
+ * @param key_p             The key of the session record.
+ * @param ttl               The TTL the session record is written with.
+ * @param error_p           The C SDK's as_error object to be populated by this
+ *                          method in case of any errors if encountered.
+ *
+ * @return AEROSPIKE::OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+static as_status
+session_touch(aerospike_session *session_p, as_key *key_p, uint32_t ttl,
+        as_error *error_p TSRMLS_DC)
+{
+    as_operations       ops;
+    as_policy_operate   policy;
+
+    as_error_init(error_p);
+
+    if (session_read_touches(session_p)) {
+        DEBUG_PHP_EXT_DEBUG("Session unchanged and touched by the read, skipping the write");
+        goto exit;
+    }
+
+    if (session_p->lazy_touch_sec > 0 && ttl > 0 && session_p->read_ttl <= ttl &&
+            ttl - session_p->read_ttl < session_p->lazy_touch_sec) {
+        DEBUG_PHP_EXT_DEBUG("Session unchanged and touched %u seconds ago, skipping the write",
+                ttl - session_p->read_ttl);
+        goto exit;
+    }
+
+    as_operations_inita(&ops, 1);
+    as_operations_add_touch(&ops);
+    ops.ttl = ttl;
+    session_operate_policy(session_p, &policy, session_p->write_timeout_ms);
+    aerospike_key_operate(session_p->aerospike_obj_p->as_ref_p->as_p,
+            error_p, &policy, key_p, &ops, NULL);
+    as_operations_destroy(&ops);
+
+exit:
+    return error_p->code;
+}
+
 /*
  *******************************************************************************************************
  * PHP Exposed-Function to open an Aerospike PHP Session.
@@ -134,6 +436,9 @@ destroy_session(aerospike_session *session_p TSRMLS_DC)
  * specified in session.save_path only if session.save_handler is set to
  * "aerospike". The internal C SDK aerospike object is fetched/hashed into the
  * Aerospike extension's Persistent List.
+ * The session object is then cached by save_path with its connection, so
+ * that the following opens with the same save_path neither parse it nor
+ * look the connection up again.
  *
  * Invoked on calling session_start() from PHP userland.
  * @return SUCCESS or FAILURE.
@@ -145,12 +450,21 @@ PS_OPEN_FUNC(aerospike)
     as_config               config;
     aerospike_session*      session_p = NULL;
     HashTable*              persistent_list = AEROSPIKE_G(persistent_list_g);
+    const char*             cache_key_p = save_path ? save_path : "";
     int                     iter_host = 0;
 
     DEBUG_PHP_EXT_INFO("In PS_OPEN_FUNC");
 
     as_error_init(&error);
 
+    if (NULL != (session_p = session_cache_find(cache_key_p TSRMLS_CC))) {
+        /* a request cut short may not have closed the session */
+        session_reset_read(session_p, false TSRMLS_CC);
+        PS_SET_MOD_DATA(session_p);
+        DEBUG_PHP_EXT_DEBUG("Reusing the cached session of save_path %s", cache_key_p);
+        return SUCCESS;
+    }
+
     if (AEROSPIKE_OK != init_session(&session_p, &error TSRMLS_CC)) {
         goto exit;
     }
@@ -199,6 +513,10 @@ PS_OPEN_FUNC(aerospike)
     /* connection is established, set the connection flag now */
     session_p->aerospike_obj_p->is_conn_16 = AEROSPIKE_CONN_STATE_TRUE;
 
+    if (AEROSPIKE_OK != session_cache_add(cache_key_p, session_p, &error TSRMLS_CC)) {
+        goto exit;
+    }
+
     DEBUG_PHP_EXT_INFO("Success in creating php-aerospike object");
 exit:
     if (error.code == AEROSPIKE_OK) {
@@ -215,8 +533,8 @@ exit:
  *******************************************************************************************************
  * PHP Exposed-Function to close an Aerospike PHP Session.
  * Closes an aerospike session.
- * The internal C SDK aerospike object is not destroyed at this point for
- * further reuse. Only ref count is decremented.
+ * The session object stays cached with its connection for further reuse,
+ * only what the read of this request returned is forgotten.
  *
  * Invoked on calling session_write_close() from PHP userland or by default upon
  * script termination.
@@ -229,25 +547,702 @@ PS_CLOSE_FUNC(aerospike)
     aerospike_session*  session_p = PS_GET_MOD_DATA();
 
     DEBUG_PHP_EXT_INFO("In PS_CLOSE_FUNC");
-    as_error_init(&error);
 
-    if (AEROSPIKE_OK != aerospike_helper_close_php_connection(session_p->aerospike_obj_p,
-                    &error TSRMLS_CC)) {
-        DEBUG_PHP_EXT_ERROR("Aerospike close returned error");
+    if (AEROSPIKE_OK != validate_session(session_p, &error TSRMLS_CC)) {
+        goto exit;
     }
 
-    destroy_session(session_p TSRMLS_CC);
+    session_reset_read(session_p, true TSRMLS_CC);
     PS_SET_MOD_DATA(NULL);
 
 exit:
     return (error.code == AEROSPIKE_OK) ? SUCCESS : FAILURE;
 }
 
+/*
+ *******************************************************************************************************
+ * Function to fetch the session record with a single operate(), touching
+ * it in the same round trip if asked to.
+ *
+ * @param session_p         The aerospike_session object.
+ * @param key_p             The key of the session record.
+ * @param touch             Whether to refresh the TTL of the record.
+ * @param record_pp         The record to be populated, to be destroyed by
+ *                          the caller.
+ * @param error_p           The C SDK's as_error object to be populated by this
+ *                          method in case of any errors if encountered.
+ *
+ * @return AEROSPIKE::OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+static as_status
+session_fetch(aerospike_session *session_p, as_key *key_p, bool touch,
+        as_record **record_pp, as_error *error_p TSRMLS_DC)
+{
+    as_operations       ops;
+    as_policy_operate   policy;
+
+    as_operations_inita(&ops, 2);
+    if (touch) {
+        as_operations_add_touch(&ops);
+        ops.ttl = CACHE_EXPIRE_PHP_INI;
+    }
+    as_operations_add_read(&ops, AEROSPIKE_SESSION_BIN);
+    session_operate_policy(session_p, &policy, session_p->read_timeout_ms);
+
+    aerospike_key_operate(session_p->aerospike_obj_p->as_ref_p->as_p,
+            error_p, &policy, key_p, &ops, record_pp);
+    as_operations_destroy(&ops);
+    return error_p->code;
+}
+
+/*
+ *******************************************************************************************************
+ * Function to get the session data of a record, stored either as a string
+ * or, with the encoding=bytes option, as bytes that may be compressed. The
+ * length is taken from the bin rather than recomputed.
+ *
+ * @param record_p          The session record.
+ * @param data_pp           Populated with the session data, NULL terminated,
+ *                          to be efree'd by the caller.
+ * @param len_p             Populated with the length of the session data.
+ * @param error_p           The C SDK's as_error object to be populated by this
+ *                          method in case of any errors if encountered.
+ *
+ * @return AEROSPIKE::OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+static as_status
+session_data_get(as_record *record_p, char **data_pp, size_t *len_p,
+        as_error *error_p TSRMLS_DC)
+{
+    as_bin_value    *value_p = as_record_get(record_p, AEROSPIKE_SESSION_BIN);
+    as_string       *string_p = NULL;
+    as_bytes        *bytes_p = NULL;
+    uint8_t         *raw_p = NULL;
+    uint32_t        raw_size = 0;
+    uLongf          inflated_len = 0;
+
+    as_error_init(error_p);
+
+    if (NULL != (string_p = as_string_fromval((as_val *) value_p))) {
+        *len_p = as_string_len(string_p);
+        *data_pp = estrndup(as_string_get(string_p), *len_p);
+        goto exit;
+    }
+
+    if (NULL == (bytes_p = as_bytes_fromval((as_val *) value_p)) ||
+            0 == (raw_size = as_bytes_size(bytes_p))) {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR,
+                "Unable to get session bin of the record");
+        DEBUG_PHP_EXT_DEBUG("Unable to get session bin of the record");
+        goto exit;
+    }
+    raw_p = as_bytes_get(bytes_p);
+
+    if (raw_p[0] == AEROSPIKE_SESSION_BYTES_RAW) {
+        *len_p = raw_size - 1;
+        *data_pp = estrndup((char *) raw_p + 1, *len_p);
+    } else if (raw_p[0] == AEROSPIKE_SESSION_BYTES_ZLIB &&
+            raw_size > AEROSPIKE_SESSION_ZLIB_HEADER_SIZE) {
+        inflated_len = ((uLongf) raw_p[1] << 24) | ((uLongf) raw_p[2] << 16) |
+            ((uLongf) raw_p[3] << 8) | (uLongf) raw_p[4];
+        /* a length the compressed data cannot inflate to is not allocated */
+        if ((uint64_t) inflated_len > (uint64_t) (raw_size - AEROSPIKE_SESSION_ZLIB_HEADER_SIZE) *
+                AEROSPIKE_SESSION_ZLIB_MAX_RATIO) {
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR,
+                    "Unable to uncompress the session data");
+            DEBUG_PHP_EXT_DEBUG("Unable to uncompress the session data: bad length %lu",
+                    (unsigned long) inflated_len);
+            goto exit;
+        }
+        *data_pp = emalloc(inflated_len + 1);
+        *len_p = inflated_len;
+        if (Z_OK != uncompress((Bytef *) *data_pp, &inflated_len,
+                    raw_p + AEROSPIKE_SESSION_ZLIB_HEADER_SIZE,
+                    raw_size - AEROSPIKE_SESSION_ZLIB_HEADER_SIZE) ||
+                inflated_len != *len_p) {
+            efree(*data_pp);
+            *data_pp = NULL;
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR,
+                    "Unable to uncompress the session data");
+            DEBUG_PHP_EXT_DEBUG("Unable to uncompress the session data");
+            goto exit;
+        }
+        (*data_pp)[*len_p] = '\0';
+    } else {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR,
+                "Unknown format of the session data");
+        DEBUG_PHP_EXT_DEBUG("Unknown format %d of the session data", raw_p[0]);
+    }
+
+exit:
+    return error_p->code;
+}
+
+/*
+ *******************************************************************************************************
+ * Function to encode the session data into a bytes bin value: deflated if
+ * at least compress_threshold bytes long and smaller once compressed,
+ * otherwise as is.
+ *
+ * @param session_p         The aerospike_session object.
+ * @param val               The session data.
+ * @param vallen            The length of val.
+ * @param size_p            Populated with the size of the encoded data.
+ *
+ * @return The encoded data, to be efree'd by the caller.
+ *******************************************************************************************************
+ */
+static uint8_t *
+session_data_encode(aerospike_session *session_p, const char *val, size_t vallen,
+        uint32_t *size_p TSRMLS_DC)
+{
+    uint8_t         *encoded_p = NULL;
+    uLongf          deflated_len = 0;
+
+    if (session_p->compress_threshold > 0 && vallen >= session_p->compress_threshold &&
+            vallen <= UINT32_MAX) {
+        deflated_len = compressBound(vallen);
+        encoded_p = emalloc(AEROSPIKE_SESSION_ZLIB_HEADER_SIZE + deflated_len);
+        if (Z_OK == compress2(encoded_p + AEROSPIKE_SESSION_ZLIB_HEADER_SIZE,
+                    &deflated_len, (const Bytef *) val, vallen, Z_BEST_SPEED) &&
+                deflated_len + AEROSPIKE_SESSION_ZLIB_HEADER_SIZE < vallen + 1) {
+            encoded_p[0] = AEROSPIKE_SESSION_BYTES_ZLIB;
+            encoded_p[1] = (uint8_t) (vallen >> 24);
+            encoded_p[2] = (uint8_t) (vallen >> 16);
+            encoded_p[3] = (uint8_t) (vallen >> 8);
+            encoded_p[4] = (uint8_t) vallen;
+            *size_p = (uint32_t) (AEROSPIKE_SESSION_ZLIB_HEADER_SIZE + deflated_len);
+            return encoded_p;
+        }
+        efree(encoded_p);
+    }
+
+    encoded_p = emalloc(vallen + 1);
+    encoded_p[0] = AEROSPIKE_SESSION_BYTES_RAW;
+    memcpy(encoded_p + 1, val, vallen);
+    *size_p = (uint32_t) (vallen + 1);
+    return encoded_p;
+}
+
+/*
+ *******************************************************************************************************
+ * Function to write the session data.
+ *
+ * @param session_p         The aerospike_session object.
+ * @param key_p             The key of the session record.
+ * @param val               The session data, NULL terminated.
+ * @param vallen            The length of val.
+ * @param ttl               The TTL of the session record.
+ * @param check_gen         Whether to write only if the record is in the
+ *                          state read: if found, at generation gen,
+ *                          otherwise still not existing.
+ * @param found             Whether the record existed when read.
+ * @param gen               The generation of the record when read.
+ * @param error_p           The C SDK's as_error object to be populated by this
+ *                          method in case of any errors if encountered.
+ *
+ * @return AEROSPIKE::OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+static as_status
+session_put(aerospike_session *session_p, as_key *key_p, const char *val,
+        size_t vallen, uint32_t ttl, bool check_gen, bool found, uint16_t gen,
+        as_error *error_p TSRMLS_DC)
+{
+    as_record           record;
+    as_policy_write     policy;
+    uint8_t             *encoded_p = NULL;
+    uint32_t            encoded_size = 0;
+    bool                set = false;
+
+    as_error_init(error_p);
+    as_record_inita(&record, 1);
+    if (session_p->bytes_encoding) {
+        encoded_p = session_data_encode(session_p, val, vallen, &encoded_size TSRMLS_CC);
+        set = as_record_set_raw(&record, AEROSPIKE_SESSION_BIN, encoded_p, encoded_size);
+    } else {
+        set = as_record_set_str(&record, AEROSPIKE_SESSION_BIN, val);
+    }
+    if (!set) {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT, "Unable to set record");
+        DEBUG_PHP_EXT_ERROR("Unable to set record");
+        goto exit;
+    }
+
+    record.ttl = ttl;
+    as_policy_write_init(&policy);
+    if (session_p->write_timeout_ms > 0) {
+        policy.timeout = session_p->write_timeout_ms;
+    }
+    if (check_gen && found) {
+        policy.gen = AS_POLICY_GEN_EQ;
+        record.gen = gen;
+    } else if (check_gen) {
+        policy.exists = AS_POLICY_EXISTS_CREATE;
+    }
+
+    if (AEROSPIKE_OK != aerospike_key_put(session_p->aerospike_obj_p->as_ref_p->as_p,
+                                        error_p, &policy, key_p, &record)) {
+        DEBUG_PHP_EXT_ERROR("Unable to save session data");
+    }
+
+exit:
+    as_record_destroy(&record);
+    if (encoded_p) {
+        efree(encoded_p);
+    }
+    return error_p->code;
+}
+
+/*
+ *******************************************************************************************************
+ * Functions to merge concurrent modifications of a session, for the
+ * serialize_handlers whose format is known: php and php_serialize. The
+ * session data is split into its top-level session variables, each kept
+ * as the serialized bytes of its value. Nothing is unserialized, as the
+ * write may run at request shutdown, when no object may be created nor
+ * class autoloaded any more.
+ *******************************************************************************************************
+ */
+typedef struct session_var_s {
+    const char  *value_p;
+    size_t      value_len;
+} session_var;
+
+static bool
+session_format_is_php(TSRMLS_D)
+{
+    return !strcmp(PS(serializer)->name, "php");
+}
+
+static bool
+session_can_merge(TSRMLS_D)
+{
+    return PS(serializer) && (session_format_is_php(TSRMLS_C) ||
+            !strcmp(PS(serializer)->name, "php_serialize"));
+}
+
+/* parses ":<count>:", bounded by the bytes left */
+static const char *
+session_read_count(const char *p, const char *end_p, unsigned long *count_p)
+{
+    *count_p = 0;
+    if (p >= end_p || *p++ != ':' || p >= end_p || !isdigit((unsigned char) *p)) {
+        return NULL;
+    }
+    while (p < end_p && isdigit((unsigned char) *p)) {
+        *count_p = *count_p * 10 + (*p++ - '0');
+        if (*count_p > (unsigned long) (end_p - p)) {
+            return NULL;
+        }
+    }
+    if (p >= end_p || *p++ != ':') {
+        return NULL;
+    }
+    return p;
+}
+
+/* skips "\"<len bytes>\"" */
+static const char *
+session_skip_quoted(const char *p, const char *end_p, unsigned long len)
+{
+    if ((unsigned long) (end_p - p) < len + 2 || p[0] != '"' || p[len + 1] != '"') {
+        return NULL;
+    }
+    return p + len + 2;
+}
+
+static const char *
+session_skip_value(const char *p, const char *end_p, int depth);
+
+/* skips "{<count keys and values>}" */
+static const char *
+session_skip_elements(const char *p, const char *end_p, unsigned long count,
+        int depth)
+{
+    unsigned long   i = 0;
+
+    if (p >= end_p || *p++ != '{') {
+        return NULL;
+    }
+    for (i = 0; p && i < count * 2; i++) {
+        p = session_skip_value(p, end_p, depth + 1);
+    }
+    if (!p || p >= end_p || *p != '}') {
+        return NULL;
+    }
+    return p + 1;
+}
+
+/*
+ * Skips one serialized value, returning where the next one starts or NULL
+ * if it cannot be moved as is. References (r: and R:) are numbered across
+ * the whole session data, so the variables holding them cannot be merged.
+ */
+static const char *
+session_skip_value(const char *p, const char *end_p, int depth)
+{
+    const char      *q = NULL;
+    unsigned long   len = 0;
+    unsigned long   count = 0;
+    char            type = 0;
+
+    if (depth > AEROSPIKE_SESSION_MERGE_MAX_DEPTH || end_p - p < 2) {
+        return NULL;
+    }
+
+    switch (type = *p) {
+        case 'N':
+            return (p[1] == ';') ? p + 2 : NULL;
+        case 'b':
+        case 'i':
+        case 'd':
+            if (p[1] != ':' || NULL == (q = memchr(p + 2, ';', end_p - p - 2))) {
+                return NULL;
+            }
+            return q + 1;
+        case 's':
+            if (NULL == (p = session_read_count(p + 1, end_p, &len)) ||
+                    NULL == (p = session_skip_quoted(p, end_p, len)) ||
+                    p >= end_p || *p != ';') {
+                return NULL;
+            }
+            return p + 1;
+        case 'a':
+            if (NULL == (p = session_read_count(p + 1, end_p, &count))) {
+                return NULL;
+            }
+            return session_skip_elements(p, end_p, count, depth);
+        case 'O':
+        case 'C':
+            if (NULL == (p = session_read_count(p + 1, end_p, &len)) ||
+                    NULL == (p = session_skip_quoted(p, end_p, len)) ||
+                    NULL == (p = session_read_count(p, end_p, &count))) {
+                return NULL;
+            }
+            if (type == 'O') {
+                return session_skip_elements(p, end_p, count, depth);
+            }
+            /* Serializable: count bytes of its own format */
+            if ((unsigned long) (end_p - p) < count + 2 || p[0] != '{' ||
+                    p[count + 1] != '}') {
+                return NULL;
+            }
+            return p + count + 2;
+        default:
+            return NULL;
+    }
+}
+
+static void
+session_vars_add(HashTable *vars_p, const char *key_p, size_t key_len,
+        const char *value_p, size_t value_len)
+{
+    session_var     var;
+    char            *name_p = estrndup(key_p, key_len);
+
+    var.value_p = value_p;
+    var.value_len = value_len;
+    zend_hash_update(vars_p, name_p, key_len + 1, (void *) &var,
+            sizeof(session_var), NULL);
+    efree(name_p);
+}
+
+/*
+ * Splits the session data into vars_p, keyed by the variable name (php) or
+ * the serialized array key (php_serialize). The values point into data_p.
+ */
+static bool
+session_decode(const char *data_p, size_t len, HashTable *vars_p TSRMLS_DC)
+{
+    const char      *p = data_p;
+    const char      *end_p = data_p + len;
+    const char      *q = NULL;
+    const char      *key_p = NULL;
+    const char      *value_p = NULL;
+    unsigned long   count = 0;
+    unsigned long   i = 0;
+
+    if (!session_format_is_php(TSRMLS_C)) {
+        if (len == 0) {
+            return true;
+        }
+        if (*p != 'a' || NULL == (p = session_read_count(p + 1, end_p, &count)) ||
+                p >= end_p || *p++ != '{') {
+            return false;
+        }
+        for (i = 0; i < count; i++) {
+            key_p = p;
+            if (NULL == (value_p = session_skip_value(key_p, end_p, 1)) ||
+                    NULL == (p = session_skip_value(value_p, end_p, 1))) {
+                return false;
+            }
+            session_vars_add(vars_p, key_p, value_p - key_p, value_p, p - value_p);
+        }
+        return (p < end_p && *p == '}');
+    }
+
+    while (p < end_p) {
+        if (NULL == (q = memchr(p, '|', end_p - p))) {
+            break;
+        }
+        if (*p == '!') {
+            /* an undefined variable, stored without a value */
+            p = q + 1;
+            continue;
+        }
+        key_p = p;
+        value_p = q + 1;
+        if (NULL == (p = session_skip_value(value_p, end_p, 1))) {
+            return false;
+        }
+        session_vars_add(vars_p, key_p, q - key_p, value_p, p - value_p);
+    }
+    return true;
+}
+
+static void
+session_encode(HashTable *vars_p, smart_str *buf_p TSRMLS_DC)
+{
+    HashPosition    pos;
+    session_var     *var_p = NULL;
+    char            *key_p = NULL;
+    uint            key_len = 0;
+    ulong           index = 0;
+    bool            is_php = session_format_is_php(TSRMLS_C);
+
+    if (!is_php) {
+        smart_str_appendl(buf_p, "a:", 2);
+        smart_str_append_unsigned(buf_p, zend_hash_num_elements(vars_p));
+        smart_str_appendl(buf_p, ":{", 2);
+    }
+    for (zend_hash_internal_pointer_reset_ex(vars_p, &pos);
+            zend_hash_get_current_data_ex(vars_p, (void **) &var_p, &pos) == SUCCESS;
+            zend_hash_move_forward_ex(vars_p, &pos)) {
+        zend_hash_get_current_key_ex(vars_p, &key_p, &key_len, &index, 0, &pos);
+        smart_str_appendl(buf_p, key_p, key_len - 1);
+        if (is_php) {
+            smart_str_appendc(buf_p, '|');
+        }
+        smart_str_appendl(buf_p, var_p->value_p, var_p->value_len);
+    }
+    if (!is_php) {
+        smart_str_appendc(buf_p, '}');
+    }
+    smart_str_0(buf_p);
+}
+
+/*
+ *******************************************************************************************************
+ * Function to merge the session variables this request modified into the
+ * session data another request has written since this one read it: the
+ * variables set or changed by this request take its value, the ones it
+ * unset are removed, and all the others keep the other request's value.
+ * Values are compared and copied as serialized.
+ *
+ * @param session_p         The aerospike_session object, holding the data
+ *                          this request read.
+ * @param ours_p            The session data of this request.
+ * @param ours_len          The length of ours_p.
+ * @param theirs_p          The session data now stored, NULL if none.
+ * @param theirs_len        The length of theirs_p.
+ * @param merged_p          The smart_str to be populated with the merged data.
+ *
+ * @return true if success. Otherwise false.
+ *******************************************************************************************************
+ */
+static bool
+session_merge(aerospike_session *session_p, const char *ours_p, size_t ours_len,
+        const char *theirs_p, size_t theirs_len, smart_str *merged_p TSRMLS_DC)
+{
+    HashTable           base;
+    HashTable           ours;
+    HashTable           theirs;
+    HashPosition        pos;
+    session_var         *var_p = NULL;
+    session_var         *found_p = NULL;
+    char                *key_p = NULL;
+    uint                key_len = 0;
+    ulong               index = 0;
+    bool                merged = false;
+
+    if (!session_can_merge(TSRMLS_C)) {
+        DEBUG_PHP_EXT_DEBUG("Cannot merge sessions of serialize_handler %s",
+                PS(serializer) ? PS(serializer)->name : "none");
+        return false;
+    }
+
+    zend_hash_init(&base, 8, NULL, NULL, 0);
+    zend_hash_init(&ours, 8, NULL, NULL, 0);
+    zend_hash_init(&theirs, 8, NULL, NULL, 0);
+
+    if (!session_decode(session_p->read_found ? session_p->read_data_p : "",
+                session_p->read_found ? session_p->read_len : 0, &base TSRMLS_CC) ||
+            !session_decode(ours_p, ours_len, &ours TSRMLS_CC) ||
+            !session_decode(theirs_p ? theirs_p : "", theirs_p ? theirs_len : 0,
+                &theirs TSRMLS_CC)) {
+        DEBUG_PHP_EXT_DEBUG("Unable to decode the session data to merge");
+        goto exit;
+    }
+
+    for (zend_hash_internal_pointer_reset_ex(&ours, &pos);
+            zend_hash_get_current_data_ex(&ours, (void **) &var_p, &pos) == SUCCESS;
+            zend_hash_move_forward_ex(&ours, &pos)) {
+        zend_hash_get_current_key_ex(&ours, &key_p, &key_len, &index, 0, &pos);
+        if (zend_hash_find(&base, key_p, key_len, (void **) &found_p) == SUCCESS &&
+                found_p->value_len == var_p->value_len &&
+                !memcmp(found_p->value_p, var_p->value_p, var_p->value_len)) {
+            continue;
+        }
+        zend_hash_update(&theirs, key_p, key_len, (void *) var_p,
+                sizeof(session_var), NULL);
+    }
+
+    for (zend_hash_internal_pointer_reset_ex(&base, &pos);
+            zend_hash_get_current_data_ex(&base, (void **) &var_p, &pos) == SUCCESS;
+            zend_hash_move_forward_ex(&base, &pos)) {
+        zend_hash_get_current_key_ex(&base, &key_p, &key_len, &index, 0, &pos);
+        if (!zend_hash_exists(&ours, key_p, key_len)) {
+            zend_hash_del(&theirs, key_p, key_len);
+        }
+    }
+
+    session_encode(&theirs, merged_p TSRMLS_CC);
+    merged = true;
+
+exit:
+    zend_hash_destroy(&base);
+    zend_hash_destroy(&ours);
+    zend_hash_destroy(&theirs);
+    return merged;
+}
+
+/*
+ *******************************************************************************************************
+ * Function to write the session data only if no other request has written
+ * the session since this one read it. On a conflict the session is read
+ * again. If its data is still the data read, the other request only touched
+ * it and the write is retried as is; otherwise, unless the conflict option
+ * is fail, the modifications of this request are merged into it and the
+ * write is retried.
+ *
+ * @param session_p         The aerospike_session object.
+ * @param key_p             The key of the session record.
+ * @param key               The session id.
+ * @param val               The session data, NULL terminated.
+ * @param vallen            The length of val.
+ * @param ttl               The TTL of the session record.
+ * @param error_p           The C SDK's as_error object to be populated by this
+ *                          method in case of any errors if encountered.
+ *
+ * @return AEROSPIKE::OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+static as_status
+session_write_checked(aerospike_session *session_p, as_key *key_p, const char *key,
+        const char *val, size_t vallen, uint32_t ttl, as_error *error_p TSRMLS_DC)
+{
+    smart_str           merged = {0};
+    const char          *data_p = val;
+    as_record           *record_p = NULL;
+    char                *theirs_p = NULL;
+    size_t              theirs_len = 0;
+    size_t              data_len = vallen;
+    bool                read_found = session_p->read_found;
+    bool                found = session_p->read_found;
+    uint16_t            gen = session_p->read_gen;
+    int16_t             attempt = 0;
+
+    if (session_p->read_id_p && strcmp(session_p->read_id_p, key)) {
+        /* a regenerated session id, a new record */
+        read_found = false;
+        found = false;
+    }
+
+    for (attempt = 0; ; attempt++) {
+        if (AEROSPIKE_OK == session_put(session_p, key_p, data_p, data_len, ttl,
+                    true, found, gen, error_p TSRMLS_CC)) {
+            break;
+        }
+        if (error_p->code != AEROSPIKE_ERR_RECORD_GENERATION &&
+                error_p->code != AEROSPIKE_ERR_RECORD_EXISTS) {
+            break;
+        }
+        if (attempt == AEROSPIKE_SESSION_MERGE_ATTEMPTS) {
+            DEBUG_PHP_EXT_WARNING("Session %s was modified by another request", key);
+            break;
+        }
+
+        if (record_p) {
+            as_record_destroy(record_p);
+            record_p = NULL;
+        }
+        if (theirs_p) {
+            efree(theirs_p);
+            theirs_p = NULL;
+            theirs_len = 0;
+        }
+        if (AEROSPIKE_OK == session_fetch(session_p, key_p, false, &record_p,
+                    error_p TSRMLS_CC)) {
+            found = true;
+            gen = record_p->gen;
+            if (AEROSPIKE_OK != session_data_get(record_p, &theirs_p, &theirs_len,
+                        error_p TSRMLS_CC)) {
+                break;
+            }
+        } else if (error_p->code != AEROSPIKE_ERR_RECORD_NOT_FOUND) {
+            break;
+        } else {
+            found = false;
+        }
+
+        if (found && read_found && theirs_len == session_p->read_len &&
+                !memcmp(theirs_p, session_p->read_data_p, theirs_len)) {
+            /* only touched meanwhile, e.g. by a request with read_touch */
+            DEBUG_PHP_EXT_DEBUG("Session %s was only touched by another request", key);
+            continue;
+        }
+        if (!session_p->merge_on_conflict) {
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_RECORD_GENERATION,
+                    "Session was modified by another request");
+            DEBUG_PHP_EXT_WARNING("Session %s was modified by another request", key);
+            break;
+        }
+
+        smart_str_free(&merged);
+        if (!session_merge(session_p, val, vallen, theirs_p,
+                    theirs_len, &merged TSRMLS_CC)) {
+            PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_RECORD_GENERATION,
+                    "Unable to merge concurrent session modifications");
+            DEBUG_PHP_EXT_WARNING("Unable to merge concurrent modifications of session %s", key);
+            break;
+        }
+        data_p = merged.c ? merged.c : "";
+        data_len = merged.len;
+        DEBUG_PHP_EXT_DEBUG("Merged concurrent modifications of session %s", key);
+    }
+
+    if (record_p) {
+        as_record_destroy(record_p);
+    }
+    if (theirs_p) {
+        efree(theirs_p);
+    }
+    smart_str_free(&merged);
+    return error_p->code;
+}
+
 /*
  *******************************************************************************************************
  * PHP Exposed-Function to read and populate contents of an Aerospike PHP Session.
  * Fetches record in the aerospike server with PK==session_id.
  * Populates the session object with contents of a bin named "PHP_SESSION".
+ * Unless the read_touch option is off, the read also touches the record in
+ * the same round trip, so that reading a session keeps it alive. With
+ * concurrency=generation or lazy_touch the TTL is refreshed by the write
+ * instead.
  *
  * Invoked on calling session_start() from PHP userland.
  * @return SUCCESS or FAILURE.
@@ -261,6 +1256,7 @@ PS_READ_FUNC(aerospike)
     as_key              key_get;
     int16_t             init_key = 0;
     char*               session_data_p = NULL;
+    size_t              session_data_len = 0;
 
     DEBUG_PHP_EXT_INFO("In PS_READ_FUNC");
 
@@ -268,24 +1264,26 @@ PS_READ_FUNC(aerospike)
        goto exit; 
     }
 
+    session_remember_read(session_p, key, NULL, 0, 0, 0 TSRMLS_CC);
+
     as_key_init_str(&key_get, session_p->ns_p, session_p->set_p, key);
     init_key = 1;
 
-    if (AEROSPIKE_OK != aerospike_key_get(session_p->aerospike_obj_p->as_ref_p->as_p,
-                &error, NULL, &key_get, &record_p)) {
+    if (AEROSPIKE_OK != session_fetch(session_p, &key_get, session_read_touches(session_p),
+                &record_p, &error TSRMLS_CC)) {
         DEBUG_PHP_EXT_ERROR("Unable to retrieve session data");
         goto exit;
     }
 
-    if (NULL == (session_data_p = as_record_get_str(record_p, AEROSPIKE_SESSION_BIN))) {
-         PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR,
-                    "Unable to get session bin of the record");
-         DEBUG_PHP_EXT_DEBUG("Unable to get session bin of the record");
+    if (AEROSPIKE_OK != session_data_get(record_p, &session_data_p,
+                &session_data_len, &error TSRMLS_CC)) {
          goto exit;
     }
 
-    *val = estrndup(session_data_p, strlen(session_data_p));
-    *vallen = strlen(session_data_p);
+    *val = session_data_p;
+    *vallen = session_data_len;
+    session_remember_read(session_p, key, *val, *vallen, record_p->ttl,
+            record_p->gen TSRMLS_CC);
 
 exit:
     if (init_key) {
@@ -304,6 +1302,8 @@ exit:
  * server.
  * Writes a record in the aerospike server with PK==session_id with a bin named "PHP_SESSION"
  * containing all the session object contents.
+ * With the concurrency=generation option, the write only succeeds if the
+ * session was not written by another request since it was read.
  *
  * Invoked on calling session_write_close() from PHP userland.
  * @return SUCCESS or FAILURE.
@@ -314,9 +1314,8 @@ PS_WRITE_FUNC(aerospike)
     as_error            error;
     aerospike_session*  session_p = PS_GET_MOD_DATA();
     as_key              key_put;
-    as_record           record;
     int16_t             init_key = 0;
-    int16_t             init_record = 0;
+    uint32_t            ttl = CACHE_EXPIRE_PHP_INI;
 
     DEBUG_PHP_EXT_INFO("In PS_WRITE_FUNC");
 
@@ -338,24 +1337,26 @@ PS_WRITE_FUNC(aerospike)
     as_key_init_str(&key_put, session_p->ns_p, session_p->set_p, key);
     init_key = 1;
 
-    as_record_inita(&record, 1);
-    init_record = 1;
-    if (!as_record_set_str(&record, AEROSPIKE_SESSION_BIN, val)) {
-        PHP_EXT_SET_AS_ERR(&error, AEROSPIKE_ERR_CLIENT, "Unable to set record");
-        DEBUG_PHP_EXT_ERROR("Unable to set record");
-        goto exit;
+    /*
+     * Most requests only read the session; rewriting the unchanged data
+     * would just load the cluster, so it is touched instead. If the record
+     * is gone by now, it is written after all.
+     */
+    if (session_is_unchanged(session_p, key, val, vallen TSRMLS_CC)) {
+        if (AEROSPIKE_ERR_RECORD_NOT_FOUND != session_touch(session_p, &key_put,
+                    ttl, &error TSRMLS_CC)) {
+            goto exit;
+        }
+        DEBUG_PHP_EXT_DEBUG("Session record gone, writing it again");
     }
 
-    record.ttl = CACHE_EXPIRE_PHP_INI;
-    if (AEROSPIKE_OK != aerospike_key_put(session_p->aerospike_obj_p->as_ref_p->as_p,
-                                        &error, NULL, &key_put, &record)) {
-        DEBUG_PHP_EXT_ERROR("Unable to save session data");
+    if (session_p->check_gen) {
+        session_write_checked(session_p, &key_put, key, val, vallen, ttl, &error TSRMLS_CC);
+    } else {
+        session_put(session_p, &key_put, val, vallen, ttl, false, false, 0, &error TSRMLS_CC);
     }
 
 exit:
-    if (init_record) {
-        as_record_destroy(&record);
-    }
     if (init_key) {
         as_key_destroy(&key_put);
     }
@@ -0,0 +1,965 @@
+#include <time.h>
+#include <string.h>
+#include <sys/time.h>
+#include "php.h"
+#include "php_aerospike.h"
+#include "aerospike/as_log.h"
+#include "aerospike/as_error.h"
+#include "aerospike/as_status.h"
+#include "aerospike/as_cluster.h"
+#include "aerospike/as_node.h"
+#include "aerospike/as_operations.h"
+#include "aerospike_common.h"
+#include "aerospike_policy.h"
+
+/*
+ *******************************************************************************************************
+ * Client-side latency statistics of the API calls, returned by
+ * Aerospike::stats(). Each operation type has a log-bucketed histogram of
+ * the call latencies in microseconds: values below 16us have a bucket each,
+ * larger ones 8 buckets per power of two (within 12.5% of the value), up to
+ * 2^41us. Recording a call is a clock read and a few increments; nothing is
+ * allocated or formatted until the statistics are asked for.
+ *
+ * The statistics live in the module globals, so they cover the calls of
+ * the process (or of the thread, under ZTS) since its start or last reset.
+ *
+ * Single-record commands are also counted per partition of their key,
+ * apart for those sent with replica=any: commands, errors and timeouts.
+ * Aerospike::nodeStats() attributes them to nodes from the partition map
+ * when it is called, so that a command never looks its node up.
+ *
+ * With a handler set by Aerospike::setTraceHandler(), one call in every
+ * 1/sample_rate is traced: the time it spends before, in and after the C
+ * client is handed to the handler as a span once the call is done. Calls
+ * that are not sampled only pay for a decrement and a branch.
+ *
+ * Calls slower than aerospike.slow_op_threshold_ms are also copied, as is,
+ * to a ring buffer that is formatted and written to aerospike.log_path at
+ * the end of the request, never while a call is being made. Once the buffer
+ * is full the oldest slow call is overwritten and counted as dropped.
+ *******************************************************************************************************
+ */
+#define AEROSPIKE_STATS_LINEAR      16
+#define AEROSPIKE_STATS_LINEAR_BITS 4
+#define AEROSPIKE_STATS_SUB_BITS    3
+#define AEROSPIKE_STATS_SUB         (1 << AEROSPIKE_STATS_SUB_BITS)
+#define AEROSPIKE_STATS_MAX_BITS    41
+#define AEROSPIKE_STATS_BUCKETS     (AEROSPIKE_STATS_LINEAR + \
+        (AEROSPIKE_STATS_MAX_BITS - AEROSPIKE_STATS_LINEAR_BITS) * AEROSPIKE_STATS_SUB)
+
+typedef struct aerospike_stats_histogram_s {
+    uint64_t    count;
+    uint64_t    errors;
+    uint64_t    timeouts;
+    uint64_t    sum_us;
+    uint64_t    min_us;
+    uint64_t    max_us;
+    uint64_t    buckets[AEROSPIKE_STATS_BUCKETS];
+} aerospike_stats_histogram;
+
+/*
+ * The counts since the process started, which a reset of the histograms
+ * leaves alone.
+ */
+typedef struct aerospike_stats_totals_s {
+    uint64_t    count;
+    uint64_t    errors;
+    uint64_t    timeouts;
+} aerospike_stats_totals;
+
+#define AEROSPIKE_SLOW_OPS_CAPACITY 64
+#define AEROSPIKE_PARTITIONS        4096
+
+typedef struct aerospike_slow_op_s {
+    time_t                      when;
+    int                         op;
+    as_status                   status;
+    uint64_t                    elapsed_us;
+    uint64_t                    net_us;
+    bool                        has_target;
+    bool                        has_digest;
+    uint32_t                    bins;
+    char                        ns[AS_NAMESPACE_MAX_SIZE];
+    char                        set[AS_SET_MAX_SIZE];
+    uint8_t                     digest[AS_DIGEST_VALUE_SIZE];
+} aerospike_slow_op;
+
+#define AEROSPIKE_STATS_NAMESPACES  8
+
+typedef struct aerospike_stats_partition_s {
+    uint32_t                    commands;
+    uint32_t                    errors;
+    uint32_t                    timeouts;
+} aerospike_stats_partition;
+
+/*
+ * The counters of the partitions of a namespace, allocated on its first
+ * command: AEROSPIKE_PARTITIONS for the commands sent to the master, then
+ * as many for the reads sent with replica=any.
+ */
+typedef struct aerospike_stats_namespace_s {
+    char                        name[AS_NAMESPACE_MAX_SIZE];
+    aerospike_stats_partition   *partitions_p;
+} aerospike_stats_namespace;
+
+struct aerospike_stats_s {
+    time_t                      since;
+    aerospike_stats_histogram   ops[AEROSPIKE_STATS_OP_COUNT];
+    aerospike_stats_totals      totals[AEROSPIKE_STATS_OP_COUNT];
+    aerospike_slow_op           slow_ops[AEROSPIKE_SLOW_OPS_CAPACITY];
+    uint32_t                    slow_ops_start;
+    uint32_t                    slow_ops_size;
+    uint64_t                    slow_ops_dropped;
+    aerospike_stats_namespace   namespaces[AEROSPIKE_STATS_NAMESPACES];
+    uint32_t                    namespaces_size;
+    uint32_t                    namespace_last;
+    zend_fcall_info             trace_call_info;
+    zend_fcall_info_cache       trace_call_info_cache;
+    uint32_t                    trace_every;
+    uint32_t                    trace_countdown;
+    bool                        tracing;
+};
+
+static const char *aerospike_stats_op_names[AEROSPIKE_STATS_OP_COUNT] = {
+    "get", "put", "remove", "operate", "apply", "batch", "scan", "query"
+};
+
+static const struct {
+    const char  *name_p;
+    double      quantile;
+} aerospike_stats_percentiles[] = {
+    { "p50_us", 0.5 },
+    { "p90_us", 0.9 },
+    { "p99_us", 0.99 },
+    { "p999_us", 0.999 }
+};
+
+/*
+ *******************************************************************************************************
+ * Histogram helpers.
+ *******************************************************************************************************
+ */
+static uint32_t
+stats_bucket(uint64_t value_us)
+{
+    uint32_t    bits = 0;
+
+    if (value_us < AEROSPIKE_STATS_LINEAR) {
+        return (uint32_t) value_us;
+    }
+    bits = 63 - __builtin_clzll(value_us);
+    if (bits >= AEROSPIKE_STATS_MAX_BITS) {
+        return AEROSPIKE_STATS_BUCKETS - 1;
+    }
+    return AEROSPIKE_STATS_LINEAR + (bits - AEROSPIKE_STATS_LINEAR_BITS) * AEROSPIKE_STATS_SUB +
+        (uint32_t) ((value_us >> (bits - AEROSPIKE_STATS_SUB_BITS)) & (AEROSPIKE_STATS_SUB - 1));
+}
+
+/*
+ * The middle of the range of values counted in a bucket.
+ */
+static uint64_t
+stats_bucket_value(uint32_t bucket)
+{
+    uint32_t    bits = 0;
+    uint64_t    width = 0;
+
+    if (bucket < AEROSPIKE_STATS_LINEAR) {
+        return bucket;
+    }
+    bucket -= AEROSPIKE_STATS_LINEAR;
+    bits = AEROSPIKE_STATS_LINEAR_BITS + bucket / AEROSPIKE_STATS_SUB;
+    width = 1ULL << (bits - AEROSPIKE_STATS_SUB_BITS);
+    return (1ULL << bits) + (bucket % AEROSPIKE_STATS_SUB) * width + width / 2;
+}
+
+static uint64_t
+stats_percentile(const aerospike_stats_histogram *histogram_p, double quantile)
+{
+    uint64_t    target = (uint64_t) (quantile * histogram_p->count + 0.5);
+    uint64_t    seen = 0;
+    uint64_t    value = 0;
+    uint32_t    i = 0;
+
+    if (target < 1) {
+        target = 1;
+    }
+    for (i = 0; i < AEROSPIKE_STATS_BUCKETS; i++) {
+        seen += histogram_p->buckets[i];
+        if (seen >= target) {
+            break;
+        }
+    }
+    value = stats_bucket_value(i);
+    if (value < histogram_p->min_us) {
+        return histogram_p->min_us;
+    }
+    if (value > histogram_p->max_us) {
+        return histogram_p->max_us;
+    }
+    return value;
+}
+
+/*
+ *******************************************************************************************************
+ * Counts a single-record command against the partition of its key. The
+ * namespace of the previous command is tried first; namespaces past
+ * AEROSPIKE_STATS_NAMESPACES are not counted.
+ *******************************************************************************************************
+ */
+static void
+stats_partition_count(aerospike_stats *stats_p, as_key *key_p,
+        as_policy_replica replica, as_status status)
+{
+    aerospike_stats_namespace   *ns_p = NULL;
+    aerospike_stats_partition   *partition_p = NULL;
+    as_digest                   *digest_p = NULL;
+    uint32_t                    i = stats_p->namespace_last;
+
+    if (i >= stats_p->namespaces_size || strcmp(stats_p->namespaces[i].name, key_p->ns)) {
+        for (i = 0; i < stats_p->namespaces_size; i++) {
+            if (!strcmp(stats_p->namespaces[i].name, key_p->ns)) {
+                break;
+            }
+        }
+        if (i == stats_p->namespaces_size) {
+            if (i == AEROSPIKE_STATS_NAMESPACES) {
+                return;
+            }
+            ns_p = &stats_p->namespaces[i];
+            strncpy(ns_p->name, key_p->ns, AS_NAMESPACE_MAX_SIZE - 1);
+            ns_p->name[AS_NAMESPACE_MAX_SIZE - 1] = '\0';
+            ns_p->partitions_p = pecalloc(2 * AEROSPIKE_PARTITIONS,
+                    sizeof(aerospike_stats_partition), 1);
+            stats_p->namespaces_size++;
+        }
+        stats_p->namespace_last = i;
+    }
+    ns_p = &stats_p->namespaces[i];
+
+    if (!(digest_p = as_key_digest(key_p))) {
+        return;
+    }
+    partition_p = &ns_p->partitions_p[((digest_p->value[0] | (digest_p->value[1] << 8)) &
+            (AEROSPIKE_PARTITIONS - 1)) +
+        (replica == AS_POLICY_REPLICA_MASTER ? 0 : AEROSPIKE_PARTITIONS)];
+    partition_p->commands++;
+    if (AEROSPIKE_OK != status && AEROSPIKE_ERR_RECORD_NOT_FOUND != status) {
+        partition_p->errors++;
+        if (AEROSPIKE_ERR_TIMEOUT == status) {
+            partition_p->timeouts++;
+        }
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Hands the span of a traced call to the trace handler. Calls made by the
+ * handler itself are not sampled.
+ *******************************************************************************************************
+ */
+static void
+stats_trace(aerospike_stats *stats_p, const aerospike_stats_call *call_p,
+        as_status status, uint64_t end_ns TSRMLS_DC)
+{
+    zval        *span_p = NULL;
+    zval        *retval_p = NULL;
+    zval        **params[1];
+    as_node     *node_p = NULL;
+    uint64_t    net_first_ns = call_p->net_first_ns ? call_p->net_first_ns : end_ns;
+
+    MAKE_STD_ZVAL(span_p);
+    array_init(span_p);
+    add_assoc_string(span_p, "op", (char *) aerospike_stats_op_names[call_p->op], 1);
+    add_assoc_long(span_p, "status", (long) status);
+    add_assoc_long(span_p, "start_us", (long) call_p->start_us);
+    add_assoc_long(span_p, "duration_us", (long) ((end_ns - call_p->begin_ns) / 1000));
+    add_assoc_long(span_p, "prepare_us", (long) ((net_first_ns - call_p->begin_ns) / 1000));
+    add_assoc_long(span_p, "network_us", (long) (call_p->net_ns / 1000));
+    add_assoc_long(span_p, "result_us", (long) (call_p->net_last_ns ?
+                (end_ns - call_p->net_last_ns) / 1000 : 0));
+    if (call_p->has_target) {
+        add_assoc_string(span_p, "ns", (char *) call_p->ns, 1);
+        add_assoc_string(span_p, "set", (char *) call_p->set, 1);
+        add_assoc_long(span_p, "bins", (long) call_p->bins);
+    }
+    /* a read sent with replica=any may have gone to any replica */
+    if (call_p->has_digest && call_p->replica == AS_POLICY_REPLICA_MASTER &&
+            call_p->as_p && call_p->as_p->cluster &&
+            (node_p = as_node_get(call_p->as_p->cluster, call_p->ns, call_p->digest,
+                                  false, AS_POLICY_REPLICA_MASTER))) {
+        add_assoc_string(span_p, "node", node_p->name, 1);
+        as_node_release(node_p);
+    }
+
+    params[0] = &span_p;
+    stats_p->trace_call_info.param_count = 1;
+    stats_p->trace_call_info.params = params;
+    stats_p->trace_call_info.retval_ptr_ptr = &retval_p;
+
+    stats_p->tracing = true;
+    if (zend_call_function(&stats_p->trace_call_info,
+                &stats_p->trace_call_info_cache TSRMLS_CC) != SUCCESS) {
+        DEBUG_PHP_EXT_WARNING("Unable to call the trace handler");
+    }
+    stats_p->tracing = false;
+
+    if (retval_p) {
+        zval_ptr_dtor(&retval_p);
+    }
+    zval_ptr_dtor(&span_p);
+}
+
+/*
+ *******************************************************************************************************
+ * Copies a slow call to the ring buffer of slow operations, over the
+ * oldest one if the buffer is full.
+ *******************************************************************************************************
+ */
+static void
+stats_add_slow_op(aerospike_stats *stats_p, const aerospike_stats_call *call_p,
+        as_status status, uint64_t elapsed_us TSRMLS_DC)
+{
+    aerospike_slow_op   *slow_op_p = NULL;
+
+    if (stats_p->slow_ops_size == AEROSPIKE_SLOW_OPS_CAPACITY) {
+        slow_op_p = &stats_p->slow_ops[stats_p->slow_ops_start];
+        stats_p->slow_ops_start = (stats_p->slow_ops_start + 1) % AEROSPIKE_SLOW_OPS_CAPACITY;
+        stats_p->slow_ops_dropped++;
+    } else {
+        slow_op_p = &stats_p->slow_ops[(stats_p->slow_ops_start + stats_p->slow_ops_size++) %
+            AEROSPIKE_SLOW_OPS_CAPACITY];
+    }
+    slow_op_p->when = time(NULL);
+    slow_op_p->op = call_p->op;
+    slow_op_p->status = status;
+    slow_op_p->elapsed_us = elapsed_us;
+    slow_op_p->net_us = call_p->net_ns / 1000;
+    if (slow_op_p->net_us > elapsed_us) {
+        slow_op_p->net_us = elapsed_us;
+    }
+    slow_op_p->has_target = call_p->has_target;
+    slow_op_p->has_digest = call_p->has_target && call_p->has_digest;
+    slow_op_p->bins = call_p->has_target ? call_p->bins : 0;
+    if (call_p->has_target) {
+        memcpy(slow_op_p->ns, call_p->ns, AS_NAMESPACE_MAX_SIZE);
+        memcpy(slow_op_p->set, call_p->set, AS_SET_MAX_SIZE);
+        memcpy(slow_op_p->digest, call_p->digest, AS_DIGEST_VALUE_SIZE);
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Allocates zeroed statistics. Called from the module globals constructor.
+ *******************************************************************************************************
+ */
+extern aerospike_stats*
+aerospike_stats_create(void)
+{
+    aerospike_stats *stats_p = pecalloc(1, sizeof(aerospike_stats), 1);
+
+    if (stats_p) {
+        stats_p->since = time(NULL);
+    }
+    return stats_p;
+}
+
+extern void
+aerospike_stats_destroy(aerospike_stats *stats_p)
+{
+    uint32_t    i = 0;
+
+    if (stats_p) {
+        for (i = 0; i < stats_p->namespaces_size; i++) {
+            pefree(stats_p->namespaces[i].partitions_p, 1);
+        }
+        pefree(stats_p, 1);
+    }
+}
+
+extern uint64_t
+aerospike_stats_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/*
+ *******************************************************************************************************
+ * Starts timing an API call. To be paired with aerospike_stats_end() on
+ * every path out of the call.
+ *
+ * @param call_p            The call, on the stack of the PHP method.
+ * @param op                The AEROSPIKE_STATS_OP_* type of the call.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_stats_begin(aerospike_stats_call *call_p, int op TSRMLS_DC)
+{
+    aerospike_stats     *stats_p = AEROSPIKE_G(stats_g);
+    struct timeval      now;
+
+    call_p->op = op;
+    call_p->begin_ns = aerospike_stats_now_ns();
+    call_p->net_ns = 0;
+    call_p->has_target = false;
+    call_p->traced = false;
+    call_p->prev_p = AEROSPIKE_G(stats_call_g);
+    AEROSPIKE_G(stats_call_g) = call_p;
+
+    if (stats_p && stats_p->trace_every && !--stats_p->trace_countdown) {
+        stats_p->trace_countdown = stats_p->trace_every;
+        if (!stats_p->tracing) {
+            gettimeofday(&now, NULL);
+            call_p->traced = true;
+            call_p->start_us = (uint64_t) now.tv_sec * 1000000 + now.tv_usec;
+            call_p->net_first_ns = 0;
+            call_p->net_last_ns = 0;
+            call_p->as_p = NULL;
+            call_p->replica = AS_POLICY_REPLICA_MASTER;
+        }
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Records the latency and outcome of an API call. A record not found is an
+ * outcome rather than an error.
+ *
+ * @param call_p            The call passed to aerospike_stats_begin().
+ * @param status            The status the call returns.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_stats_end(aerospike_stats_call *call_p, as_status status TSRMLS_DC)
+{
+    aerospike_stats             *stats_p = AEROSPIKE_G(stats_g);
+    aerospike_stats_histogram   *histogram_p = NULL;
+    aerospike_stats_totals      *totals_p = NULL;
+    uint64_t                    end_ns = aerospike_stats_now_ns();
+    uint64_t                    elapsed_us = (end_ns - call_p->begin_ns) / 1000;
+
+    AEROSPIKE_G(stats_call_g) = call_p->prev_p;
+    if ((!stats_p) || call_p->op < 0 || call_p->op >= AEROSPIKE_STATS_OP_COUNT) {
+        return;
+    }
+
+    histogram_p = &stats_p->ops[call_p->op];
+    totals_p = &stats_p->totals[call_p->op];
+    if ((!histogram_p->count) || elapsed_us < histogram_p->min_us) {
+        histogram_p->min_us = elapsed_us;
+    }
+    if (elapsed_us > histogram_p->max_us) {
+        histogram_p->max_us = elapsed_us;
+    }
+    histogram_p->count++;
+    histogram_p->sum_us += elapsed_us;
+    histogram_p->buckets[stats_bucket(elapsed_us)]++;
+    totals_p->count++;
+    if (AEROSPIKE_OK != status && AEROSPIKE_ERR_RECORD_NOT_FOUND != status) {
+        histogram_p->errors++;
+        totals_p->errors++;
+        if (AEROSPIKE_ERR_TIMEOUT == status) {
+            histogram_p->timeouts++;
+            totals_p->timeouts++;
+        }
+    }
+
+    if (AEROSPIKE_G(slow_op_threshold_ms) > 0 &&
+            elapsed_us >= (uint64_t) AEROSPIKE_G(slow_op_threshold_ms) * 1000) {
+        stats_add_slow_op(stats_p, call_p, status, elapsed_us TSRMLS_CC);
+    }
+
+    if (call_p->traced && stats_p->trace_every) {
+        stats_trace(stats_p, call_p, status, end_ns TSRMLS_CC);
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Keeps what a call into the C client was about in the current API call, once
+ * the API call is already slow, or traced. Only the first such call is kept.
+ *******************************************************************************************************
+ */
+static void
+stats_call_target(aerospike_stats_call *call_p, as_key *key_p, const char *ns_p,
+        const char *set_p, as_policy_replica replica, uint32_t bins, uint64_t now TSRMLS_DC)
+{
+    if (call_p->has_target || ((!call_p->traced) &&
+                (AEROSPIKE_G(slow_op_threshold_ms) <= 0 ||
+                 now - call_p->begin_ns < (uint64_t) AEROSPIKE_G(slow_op_threshold_ms) * 1000000))) {
+        return;
+    }
+    if (key_p) {
+        ns_p = key_p->ns;
+        set_p = key_p->set;
+    }
+    call_p->has_target = true;
+    call_p->has_digest = false;
+    call_p->replica = replica;
+    call_p->bins = bins;
+    strncpy(call_p->ns, ns_p ? ns_p : "", AS_NAMESPACE_MAX_SIZE - 1);
+    call_p->ns[AS_NAMESPACE_MAX_SIZE - 1] = '\0';
+    strncpy(call_p->set, set_p ? set_p : "", AS_SET_MAX_SIZE - 1);
+    call_p->set[AS_SET_MAX_SIZE - 1] = '\0';
+    if (key_p && as_key_digest(key_p)) {
+        memcpy(call_p->digest, key_p->digest.value, AS_DIGEST_VALUE_SIZE);
+        call_p->has_digest = true;
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Start and end of a call into the C client, within the current API call.
+ * Used through AEROSPIKE_STATS_NET() and AEROSPIKE_STATS_NET_READ(). A call
+ * with a key is counted against the partition of the key, under the replica
+ * policy it was sent with. aerospike_stats_net_end() returns the status of
+ * the call, for the macros to yield.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_stats_net_begin(aerospike *as_p TSRMLS_DC)
+{
+    aerospike_stats_call    *call_p = AEROSPIKE_G(stats_call_g);
+
+    if (!call_p) {
+        return;
+    }
+
+    call_p->net_begin_ns = aerospike_stats_now_ns();
+    if (call_p->traced) {
+        call_p->as_p = as_p;
+        if (!call_p->net_first_ns) {
+            call_p->net_first_ns = call_p->net_begin_ns;
+        }
+    }
+}
+
+extern as_status
+aerospike_stats_net_end(as_key *key_p, const char *ns_p, const char *set_p,
+        as_policy_replica replica, uint32_t bins, as_status status TSRMLS_DC)
+{
+    aerospike_stats_call    *call_p = AEROSPIKE_G(stats_call_g);
+    aerospike_stats         *stats_p = AEROSPIKE_G(stats_g);
+    uint64_t                now = 0;
+
+    if (!call_p) {
+        return status;
+    }
+    now = aerospike_stats_now_ns();
+    call_p->net_ns += now - call_p->net_begin_ns;
+    if (call_p->traced) {
+        call_p->net_last_ns = now;
+    }
+
+    if (stats_p && key_p) {
+        stats_partition_count(stats_p, key_p, replica, status);
+    }
+    stats_call_target(call_p, key_p, ns_p, set_p, replica, bins, now TSRMLS_CC);
+    return status;
+}
+
+/*
+ *******************************************************************************************************
+ * Adds net_ns of network time to the current API call at once, for a scan or
+ * query whose waits for records were summed up by the caller rather than
+ * timed one by one. ns_p and set_p name what the scan/query reads.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_stats_net_add(aerospike *as_p, const char *ns_p, const char *set_p,
+        uint64_t net_ns TSRMLS_DC)
+{
+    aerospike_stats_call    *call_p = AEROSPIKE_G(stats_call_g);
+    uint64_t                now = 0;
+
+    if (!call_p) {
+        return;
+    }
+    now = aerospike_stats_now_ns();
+    call_p->net_ns += net_ns;
+    if (call_p->traced) {
+        call_p->as_p = as_p;
+        if (!call_p->net_first_ns) {
+            call_p->net_first_ns = now - net_ns;
+        }
+        call_p->net_last_ns = now;
+    }
+    stats_call_target(call_p, NULL, ns_p, set_p, AS_POLICY_REPLICA_MASTER, 0,
+            now TSRMLS_CC);
+}
+
+/*
+ *******************************************************************************************************
+ * Formats the slow operations kept so far and appends them to
+ * aerospike.log_path, or to the PHP error log if it is not set, followed by
+ * the number of slow operations dropped from the full buffer. Called at
+ * RSHUTDOWN.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_stats_flush_slow_ops(TSRMLS_D)
+{
+    aerospike_stats     *stats_p = AEROSPIKE_G(stats_g);
+    aerospike_slow_op   *slow_op_p = NULL;
+    char                *log_path_p = LOG_PATH_PHP_INI;
+    FILE                *log_p = NULL;
+    char                line[512];
+    char                when[32];
+    char                digest[2 * AS_DIGEST_VALUE_SIZE + 1];
+    struct tm           tm;
+    uint32_t            i = 0;
+    uint32_t            j = 0;
+
+    if ((!stats_p) || (!stats_p->slow_ops_size && !stats_p->slow_ops_dropped)) {
+        return;
+    }
+    if (log_path_p && *log_path_p && (!(log_p = fopen(log_path_p, "a")))) {
+        DEBUG_PHP_EXT_WARNING("Unable to open aerospike.log_path for the slow operations");
+    }
+
+    for (i = 0; i < stats_p->slow_ops_size; i++) {
+        slow_op_p = &stats_p->slow_ops[(stats_p->slow_ops_start + i) %
+            AEROSPIKE_SLOW_OPS_CAPACITY];
+        localtime_r(&slow_op_p->when, &tm);
+        strftime(when, sizeof(when), "%Y-%m-%dT%H:%M:%S", &tm);
+        digest[0] = '\0';
+        if (slow_op_p->has_digest) {
+            for (j = 0; j < AS_DIGEST_VALUE_SIZE; j++) {
+                sprintf(digest + 2 * j, "%02x", slow_op_p->digest[j]);
+            }
+        }
+        snprintf(line, sizeof(line),
+                "%s aerospike slow-op op=%s ns=%s set=%s digest=%s bins=%u partition=%d "
+                "status=%d elapsed_us=%llu transform_us=%llu network_us=%llu",
+                when, aerospike_stats_op_names[slow_op_p->op],
+                slow_op_p->has_target ? slow_op_p->ns : "-",
+                (slow_op_p->has_target && slow_op_p->set[0]) ? slow_op_p->set : "-",
+                slow_op_p->has_digest ? digest : "-",
+                slow_op_p->bins,
+                slow_op_p->has_digest ?
+                    (int) ((slow_op_p->digest[0] | (slow_op_p->digest[1] << 8)) &
+                        (AEROSPIKE_PARTITIONS - 1)) : -1,
+                (int) slow_op_p->status,
+                (unsigned long long) slow_op_p->elapsed_us,
+                (unsigned long long) (slow_op_p->elapsed_us - slow_op_p->net_us),
+                (unsigned long long) slow_op_p->net_us);
+        if (log_p) {
+            fprintf(log_p, "%s\n", line);
+        } else {
+            php_log_err(line TSRMLS_CC);
+        }
+    }
+    if (stats_p->slow_ops_dropped) {
+        snprintf(line, sizeof(line),
+                "aerospike slow-op dropped=%llu (more than %d slow operations in the request)",
+                (unsigned long long) stats_p->slow_ops_dropped, AEROSPIKE_SLOW_OPS_CAPACITY);
+        if (log_p) {
+            fprintf(log_p, "%s\n", line);
+        } else {
+            php_log_err(line TSRMLS_CC);
+        }
+    }
+    if (log_p) {
+        fclose(log_p);
+    }
+    stats_p->slow_ops_start = 0;
+    stats_p->slow_ops_size = 0;
+    stats_p->slow_ops_dropped = 0;
+}
+
+/*
+ *******************************************************************************************************
+ * Populates the array returned by Aerospike::stats(): the time of the last
+ * reset and, for each operation type, its counts and latency percentiles.
+ *
+ * @param return_p          An initialized array zval to be populated.
+ * @param reset             Whether to zero the statistics once read.
+ * @param error_p           The as_error to be populated by the function
+ *                          with the encountered error if any.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+extern as_status
+aerospike_stats_get(zval *return_p, bool reset, as_error *error_p TSRMLS_DC)
+{
+    aerospike_stats             *stats_p = AEROSPIKE_G(stats_g);
+    aerospike_stats_histogram   *histogram_p = NULL;
+    zval                        *op_p = NULL;
+    uint32_t                    i = 0;
+    uint32_t                    j = 0;
+
+    if (!stats_p) {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
+                "Statistics are not enabled in this build");
+        DEBUG_PHP_EXT_DEBUG("Statistics are not enabled in this build");
+        goto exit;
+    }
+
+    add_assoc_long(return_p, "since", (long) stats_p->since);
+    for (i = 0; i < AEROSPIKE_STATS_OP_COUNT; i++) {
+        histogram_p = &stats_p->ops[i];
+        MAKE_STD_ZVAL(op_p);
+        array_init(op_p);
+        add_assoc_long(op_p, "count", (long) histogram_p->count);
+        add_assoc_long(op_p, "errors", (long) histogram_p->errors);
+        add_assoc_long(op_p, "timeouts", (long) histogram_p->timeouts);
+        add_assoc_long(op_p, "min_us", (long) histogram_p->min_us);
+        add_assoc_long(op_p, "mean_us", (long) (histogram_p->count ?
+                    histogram_p->sum_us / histogram_p->count : 0));
+        for (j = 0; j < sizeof(aerospike_stats_percentiles) / sizeof(aerospike_stats_percentiles[0]); j++) {
+            add_assoc_long(op_p, (char *) aerospike_stats_percentiles[j].name_p,
+                    (long) (histogram_p->count ?
+                        stats_percentile(histogram_p, aerospike_stats_percentiles[j].quantile) : 0));
+        }
+        add_assoc_long(op_p, "max_us", (long) histogram_p->max_us);
+        add_assoc_zval(return_p, (char *) aerospike_stats_op_names[i], op_p);
+    }
+
+    if (reset) {
+        memset(stats_p->ops, 0, sizeof(stats_p->ops));
+        for (i = 0; i < stats_p->namespaces_size; i++) {
+            memset(stats_p->namespaces[i].partitions_p, 0,
+                    2 * AEROSPIKE_PARTITIONS * sizeof(aerospike_stats_partition));
+        }
+        stats_p->since = time(NULL);
+    }
+
+exit:
+    return error_p->code;
+}
+
+/*
+ *******************************************************************************************************
+ * Adds a share of the counters of a partition to those of the node it is
+ * attributed to, if the node is one of nodes_p.
+ *******************************************************************************************************
+ */
+static void
+stats_node_add(as_nodes *nodes_p, uint64_t *counters_p, as_node *node_p,
+        const aerospike_stats_partition *partition_p, uint32_t share, uint32_t shares)
+{
+    uint32_t    i = 0;
+
+    for (i = 0; i < nodes_p->size; i++) {
+        if (nodes_p->array[i] == node_p) {
+            /* the first share takes the remainder */
+            counters_p[3 * i] += partition_p->commands / shares +
+                (share ? 0 : partition_p->commands % shares);
+            counters_p[3 * i + 1] += partition_p->errors / shares +
+                (share ? 0 : partition_p->errors % shares);
+            counters_p[3 * i + 2] += partition_p->timeouts / shares +
+                (share ? 0 : partition_p->timeouts % shares);
+            return;
+        }
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Adds the counters kept for each node to the arrays describing them in
+ * Aerospike::nodeStats(). The partition counters are attributed to the
+ * nodes from the current partition map: the commands sent to the master to
+ * the master, and the reads sent with replica=any split evenly between the
+ * replicas, which the C client alternates between. A node no command was
+ * sent to has zero counts.
+ *
+ * @param cluster_p         The cluster of the nodes.
+ * @param nodes_p           The reserved nodes of the cluster.
+ * @param node_stats_pp     The initialized array zvals of the nodes, in the
+ *                          order of nodes_p.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_stats_nodes_get(as_cluster *cluster_p, as_nodes *nodes_p,
+        zval **node_stats_pp TSRMLS_DC)
+{
+    aerospike_stats             *stats_p = AEROSPIKE_G(stats_g);
+    aerospike_stats_partition   *partition_p = NULL;
+    as_node                     *node_p = NULL;
+    as_node                     *other_p = NULL;
+    uint64_t                    *counters_p = NULL;
+    uint8_t                     digest[AS_DIGEST_VALUE_SIZE];
+    uint32_t                    i = 0;
+    uint32_t                    pid = 0;
+
+    counters_p = ecalloc(3 * (nodes_p->size ? nodes_p->size : 1), sizeof(uint64_t));
+    memset(digest, 0, sizeof(digest));
+
+    for (i = 0; stats_p && i < stats_p->namespaces_size; i++) {
+        for (pid = 0; pid < AEROSPIKE_PARTITIONS; pid++) {
+            /* any digest of the partition will do */
+            digest[0] = pid & 0xff;
+            digest[1] = pid >> 8;
+
+            partition_p = &stats_p->namespaces[i].partitions_p[pid];
+            if (partition_p->commands &&
+                    (node_p = as_node_get(cluster_p, stats_p->namespaces[i].name,
+                                          digest, false, AS_POLICY_REPLICA_MASTER))) {
+                stats_node_add(nodes_p, counters_p, node_p, partition_p, 0, 1);
+                as_node_release(node_p);
+            }
+
+            partition_p = &stats_p->namespaces[i].partitions_p[AEROSPIKE_PARTITIONS + pid];
+            if (!partition_p->commands) {
+                continue;
+            }
+            /* two consecutive lookups with replica=any return both replicas */
+            node_p = as_node_get(cluster_p, stats_p->namespaces[i].name,
+                    digest, false, AS_POLICY_REPLICA_ANY);
+            other_p = as_node_get(cluster_p, stats_p->namespaces[i].name,
+                    digest, false, AS_POLICY_REPLICA_ANY);
+            if (node_p && other_p && node_p != other_p) {
+                stats_node_add(nodes_p, counters_p, node_p, partition_p, 0, 2);
+                stats_node_add(nodes_p, counters_p, other_p, partition_p, 1, 2);
+            } else if (node_p || other_p) {
+                stats_node_add(nodes_p, counters_p, node_p ? node_p : other_p,
+                        partition_p, 0, 1);
+            }
+            if (node_p) {
+                as_node_release(node_p);
+            }
+            if (other_p) {
+                as_node_release(other_p);
+            }
+        }
+    }
+
+    for (i = 0; i < nodes_p->size; i++) {
+        add_assoc_long(node_stats_pp[i], "commands", (long) counters_p[3 * i]);
+        add_assoc_long(node_stats_pp[i], "errors", (long) counters_p[3 * i + 1]);
+        add_assoc_long(node_stats_pp[i], "timeouts", (long) counters_p[3 * i + 2]);
+    }
+    efree(counters_p);
+}
+
+/*
+ *******************************************************************************************************
+ * The replica an operate() is sent to: the one of its policy if it only
+ * reads, otherwise the master.
+ *
+ * @param ops_p             The operations of the command.
+ * @param replica           The replica of its policy.
+ *
+ * @return the replica the C client sends the command to.
+ *******************************************************************************************************
+ */
+extern as_policy_replica
+aerospike_stats_operate_replica(as_operations *ops_p, as_policy_replica replica)
+{
+    uint16_t    i = 0;
+
+    for (i = 0; replica != AS_POLICY_REPLICA_MASTER && i < ops_p->binops.size; i++) {
+        if (ops_p->binops.entries[i].op != AS_OPERATOR_READ) {
+            return AS_POLICY_REPLICA_MASTER;
+        }
+    }
+    return replica;
+}
+
+/*
+ *******************************************************************************************************
+ * Sets, or with an empty fcall info removes, the trace handler of the
+ * request. The handler is released at RSHUTDOWN.
+ *
+ * @param fci_p             The handler, as parsed with "f!".
+ * @param fcc_p             Its fcall info cache.
+ * @param sample_rate       The fraction of the calls to trace, in ]0, 1].
+ * @param error_p           The as_error to be populated by the function
+ *                          with the encountered error if any.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+extern as_status
+aerospike_stats_trace_set(zend_fcall_info *fci_p, zend_fcall_info_cache *fcc_p,
+        double sample_rate, as_error *error_p TSRMLS_DC)
+{
+    aerospike_stats     *stats_p = AEROSPIKE_G(stats_g);
+
+    if (!stats_p) {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
+                "Statistics are not enabled in this build");
+        DEBUG_PHP_EXT_DEBUG("Statistics are not enabled in this build");
+        goto exit;
+    }
+
+    if (stats_p->tracing) {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
+                "The trace handler cannot be changed from within itself");
+        DEBUG_PHP_EXT_DEBUG("The trace handler cannot be changed from within itself");
+        goto exit;
+    }
+
+    if (fci_p->size && (sample_rate <= 0 || sample_rate > 1)) {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_PARAM,
+                "The sample rate must be greater than 0 and at most 1");
+        DEBUG_PHP_EXT_DEBUG("The sample rate must be greater than 0 and at most 1");
+        goto exit;
+    }
+
+    aerospike_stats_trace_release(TSRMLS_C);
+    if (!fci_p->size) {
+        goto exit;
+    }
+
+    stats_p->trace_call_info = *fci_p;
+    stats_p->trace_call_info_cache = *fcc_p;
+    Z_ADDREF_P(stats_p->trace_call_info.function_name);
+    stats_p->trace_every = (uint32_t) (1.0 / sample_rate + 0.5);
+    if (!stats_p->trace_every) {
+        stats_p->trace_every = 1;
+    }
+    stats_p->trace_countdown = 1;
+
+exit:
+    return error_p->code;
+}
+
+extern void
+aerospike_stats_trace_release(TSRMLS_D)
+{
+    aerospike_stats     *stats_p = AEROSPIKE_G(stats_g);
+
+    if ((!stats_p) || (!stats_p->trace_every)) {
+        return;
+    }
+    stats_p->trace_every = 0;
+    zval_ptr_dtor(&stats_p->trace_call_info.function_name);
+    stats_p->trace_call_info.function_name = NULL;
+}
+
+/*
+ *******************************************************************************************************
+ * Adds the cumulative call, error and timeout counts per operation type to
+ * Aerospike::runtimeInfo() and phpinfo(). They count since the process
+ * started, Aerospike::stats(true) does not reset them. Empty when
+ * statistics are compiled out.
+ *
+ * @param return_p          An initialized array zval to be populated.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_stats_counters(zval *return_p TSRMLS_DC)
+{
+    aerospike_stats     *stats_p = AEROSPIKE_G(stats_g);
+    zval                *op_p = NULL;
+    uint32_t            i = 0;
+
+    if (!stats_p) {
+        return;
+    }
+
+    for (i = 0; i < AEROSPIKE_STATS_OP_COUNT; i++) {
+        MAKE_STD_ZVAL(op_p);
+        array_init(op_p);
+        add_assoc_long(op_p, "count", (long) stats_p->totals[i].count);
+        add_assoc_long(op_p, "errors", (long) stats_p->totals[i].errors);
+        add_assoc_long(op_p, "timeouts", (long) stats_p->totals[i].timeouts);
+        add_assoc_zval(return_p, (char *) aerospike_stats_op_names[i], op_p);
+    }
+}
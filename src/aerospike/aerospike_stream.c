@@ -0,0 +1,691 @@
+#include "php.h"
+#include "pthread.h"
+#include "sched.h"
+#include "time.h"
+#include "aerospike/as_log.h"
+#include "aerospike/as_key.h"
+#include "aerospike/as_config.h"
+#include "aerospike/as_error.h"
+#include "aerospike/as_status.h"
+#include "aerospike/aerospike.h"
+#include "aerospike/as_scan.h"
+#include "aerospike/as_query.h"
+#include "aerospike/aerospike_scan.h"
+#include "aerospike/aerospike_query.h"
+#include "aerospike_common.h"
+
+/*
+ *******************************************************************************************************
+ * The record stream moves records produced by the C client's scan and query
+ * callbacks (which may run on the C client's node threads) over to the PHP
+ * thread. Producers never touch the Zend engine: they deep-copy the record
+ * into a bounded ring and block while it is full. The PHP thread is the only
+ * consumer and is the only place where userland code is invoked.
+ *
+ * The ring is a bounded array queue where each cell carries a sequence
+ * number, so multiple producers can claim cells with a single CAS and the
+ * consumer needs no atomic read-modify-write at all.
+ *******************************************************************************************************
+ */
+#define AEROSPIKE_STREAM_SPIN_LIMIT         64
+#define AEROSPIKE_STREAM_SLEEP_NSEC         50000
+
+typedef enum aerospike_stream_type_e {
+    AEROSPIKE_STREAM_TYPE_SCAN,
+    AEROSPIKE_STREAM_TYPE_QUERY
+} aerospike_stream_type;
+
+typedef struct aerospike_stream_cell_s {
+    volatile uint64_t   sequence;
+    as_record           *record_p;
+} aerospike_stream_cell;
+
+struct aerospike_stream_s {
+    aerospike                   *as_object_p;
+    aerospike_stream_type       type;
+    as_scan                     *scan_p;
+    as_query                    *query_p;
+    as_policy_scan              scan_policy;
+    as_policy_query             query_policy;
+    bool                        owns_request;
+
+    aerospike_stream_cell       *cells_p;
+    uint64_t                    mask;
+    volatile uint64_t           enqueue_pos;
+    volatile uint64_t           dequeue_pos;
+
+    volatile uint32_t           cancelled;
+    volatile uint32_t           done;
+    bool                        started;
+    pthread_t                   worker;
+    as_error                    error;
+};
+
+/*
+ *******************************************************************************************************
+ * Waits a little before retrying a ring operation: spins first, then yields
+ * and finally sleeps so that a stalled peer does not burn a CPU.
+ *
+ * @param spins_p           Number of retries done so far; incremented here.
+ *******************************************************************************************************
+ */
+static void
+aerospike_stream_backoff(uint32_t *spins_p)
+{
+    struct timespec     nap = {0, AEROSPIKE_STREAM_SLEEP_NSEC};
+
+    if ((*spins_p)++ < AEROSPIKE_STREAM_SPIN_LIMIT) {
+        sched_yield();
+    } else {
+        nanosleep(&nap, NULL);
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Claims a cell in the ring and publishes the record into it.
+ * Safe to call concurrently from any number of producer threads.
+ *
+ * @param stream_p          The record stream.
+ * @param record_p          The heap allocated record to be published.
+ *
+ * @return true if the record was queued, false if the ring is full.
+ *******************************************************************************************************
+ */
+static bool
+aerospike_stream_push(aerospike_stream *stream_p, as_record *record_p)
+{
+    aerospike_stream_cell   *cell_p = NULL;
+    uint64_t                pos = stream_p->enqueue_pos;
+    int64_t                 diff = 0;
+
+    for (;;) {
+        cell_p = &stream_p->cells_p[pos & stream_p->mask];
+        diff = (int64_t) cell_p->sequence - (int64_t) pos;
+        if (diff == 0) {
+            if (__sync_bool_compare_and_swap(&stream_p->enqueue_pos, pos, pos + 1)) {
+                break;
+            }
+            pos = stream_p->enqueue_pos;
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = stream_p->enqueue_pos;
+        }
+    }
+
+    cell_p->record_p = record_p;
+    __sync_synchronize();
+    cell_p->sequence = pos + 1;
+    return true;
+}
+
+/*
+ *******************************************************************************************************
+ * Takes the oldest record out of the ring. Must only be called from the
+ * consuming (PHP) thread.
+ *
+ * @param stream_p          The record stream.
+ *
+ * @return the record, or NULL if the ring is currently empty.
+ *******************************************************************************************************
+ */
+static as_record*
+aerospike_stream_pop(aerospike_stream *stream_p)
+{
+    aerospike_stream_cell   *cell_p = NULL;
+    uint64_t                pos = stream_p->dequeue_pos;
+    as_record               *record_p = NULL;
+
+    cell_p = &stream_p->cells_p[pos & stream_p->mask];
+    if (cell_p->sequence != pos + 1) {
+        return NULL;
+    }
+
+    __sync_synchronize();
+    record_p = cell_p->record_p;
+    cell_p->record_p = NULL;
+    stream_p->dequeue_pos = pos + 1;
+    __sync_synchronize();
+    cell_p->sequence = pos + stream_p->mask + 1;
+    return record_p;
+}
+
+/*
+ *******************************************************************************************************
+ * Copies the digest, namespace, set and user key (if sent by the server)
+ * from the C client's record key into a key owned by the copied record.
+ *
+ * @param dst_p             The key to be populated.
+ * @param src_p             The key of the record handed to the callback.
+ *******************************************************************************************************
+ */
+static void
+aerospike_stream_key_copy(as_key *dst_p, const as_key *src_p)
+{
+    uint8_t     *bytes_p = NULL;
+
+    strncpy(dst_p->ns, src_p->ns, AS_NAMESPACE_MAX_SIZE);
+    strncpy(dst_p->set, src_p->set, AS_SET_MAX_SIZE);
+    dst_p->digest = src_p->digest;
+    dst_p->valuep = NULL;
+
+    if (!src_p->valuep) {
+        return;
+    }
+
+    switch (as_val_type((as_val *) src_p->valuep)) {
+        case AS_INTEGER:
+            as_integer_init((as_integer *) &dst_p->value,
+                    as_integer_get((as_integer *) src_p->valuep));
+            dst_p->valuep = &dst_p->value;
+            break;
+        case AS_STRING:
+            as_string_init((as_string *) &dst_p->value,
+                    strdup(as_string_get((as_string *) src_p->valuep)), true);
+            dst_p->valuep = &dst_p->value;
+            break;
+        case AS_BYTES:
+            if (NULL != (bytes_p = (uint8_t *) malloc(as_bytes_size((as_bytes *) src_p->valuep)))) {
+                memcpy(bytes_p, as_bytes_get((as_bytes *) src_p->valuep),
+                        as_bytes_size((as_bytes *) src_p->valuep));
+                as_bytes_init_wrap((as_bytes *) &dst_p->value, bytes_p,
+                        as_bytes_size((as_bytes *) src_p->valuep), true);
+                dst_p->valuep = &dst_p->value;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ *******************************************************************************************************
+ * Deep-copies a record handed to a scan/query callback. The C client owns
+ * that record and destroys it as soon as the callback returns, and scalar
+ * bin values live inline in it, so they are duplicated here. Lists and maps
+ * are standalone reference counted values and are just reserved.
+ *
+ * Runs on the C client's threads: must not call into PHP.
+ *
+ * @param src_p             The record handed to the callback.
+ *
+ * @return a heap allocated record, or NULL on allocation failure.
+ *******************************************************************************************************
+ */
+static as_record*
+aerospike_stream_record_copy(const as_record *src_p)
+{
+    as_record       *record_p = NULL;
+    as_bin          *bin_p = NULL;
+    as_val          *val_p = NULL;
+    as_bytes        *bytes_p = NULL;
+    as_bytes        *bytes_copy_p = NULL;
+    uint8_t         *buffer_p = NULL;
+    uint16_t        i = 0;
+
+    if (NULL == (record_p = as_record_new(src_p->bins.size))) {
+        return NULL;
+    }
+
+    record_p->gen = src_p->gen;
+    record_p->ttl = src_p->ttl;
+    aerospike_stream_key_copy(&record_p->key, &src_p->key);
+
+    for (i = 0; i < src_p->bins.size; i++) {
+        bin_p = &src_p->bins.entries[i];
+        val_p = (as_val *) bin_p->valuep;
+
+        switch (val_p ? as_val_type(val_p) : AS_NIL) {
+            case AS_NIL:
+                as_record_set_nil(record_p, bin_p->name);
+                break;
+            case AS_INTEGER:
+                as_record_set_int64(record_p, bin_p->name,
+                        as_integer_get((as_integer *) val_p));
+                break;
+            case AS_STRING:
+                as_record_set_strp(record_p, bin_p->name,
+                        strdup(as_string_get((as_string *) val_p)), true);
+                break;
+            case AS_BYTES:
+                bytes_p = (as_bytes *) val_p;
+                if (NULL == (buffer_p = (uint8_t *) malloc(as_bytes_size(bytes_p)))) {
+                    as_record_set_nil(record_p, bin_p->name);
+                    break;
+                }
+                memcpy(buffer_p, as_bytes_get(bytes_p), as_bytes_size(bytes_p));
+                bytes_copy_p = as_bytes_new_wrap(buffer_p, as_bytes_size(bytes_p), true);
+                bytes_copy_p->type = bytes_p->type;
+                as_record_set_bytes(record_p, bin_p->name, bytes_copy_p);
+                break;
+            default:
+                as_record_set(record_p, bin_p->name,
+                        (as_bin_value *) as_val_reserve(val_p));
+                break;
+        }
+    }
+    return record_p;
+}
+
+/*
+ *******************************************************************************************************
+ * Callback for aerospike_scan_foreach and aerospike_query_foreach.
+ * Copies the record and queues it for the PHP thread, waiting while the
+ * ring is full. Runs on the C client's threads: must not call into PHP
+ * (no logging, no emalloc, no zvals).
+ *
+ * @param p_val             The current as_val (as_record) of the stream.
+ * @param udata             The aerospike_stream.
+ *
+ * @return true to continue the stream, false once it has been cancelled.
+ *******************************************************************************************************
+ */
+static bool
+aerospike_stream_produce(const as_val *p_val, void *udata)
+{
+    aerospike_stream    *stream_p = (aerospike_stream *) udata;
+    as_record           *src_p = NULL;
+    as_record           *record_p = NULL;
+    uint32_t            spins = 0;
+
+    if (!p_val) {
+        return true;
+    }
+
+    if (stream_p->cancelled) {
+        return false;
+    }
+
+    if ((NULL == (src_p = as_record_fromval(p_val))) ||
+            (NULL == (record_p = aerospike_stream_record_copy(src_p)))) {
+        return true;
+    }
+
+    while (!aerospike_stream_push(stream_p, record_p)) {
+        if (stream_p->cancelled) {
+            as_record_destroy(record_p);
+            return false;
+        }
+        aerospike_stream_backoff(&spins);
+    }
+    return true;
+}
+
+/*
+ *******************************************************************************************************
+ * Worker thread running the blocking scan/query foreach call, so that the
+ * PHP thread is free to drain the ring while the C client produces.
+ *
+ * @param udata             The aerospike_stream.
+ *******************************************************************************************************
+ */
+static void*
+aerospike_stream_worker(void *udata)
+{
+    aerospike_stream    *stream_p = (aerospike_stream *) udata;
+
+    if (stream_p->type == AEROSPIKE_STREAM_TYPE_SCAN) {
+        aerospike_scan_foreach(stream_p->as_object_p, &stream_p->error,
+                &stream_p->scan_policy, stream_p->scan_p,
+                aerospike_stream_produce, stream_p);
+    } else {
+        aerospike_query_foreach(stream_p->as_object_p, &stream_p->error,
+                &stream_p->query_policy, stream_p->query_p,
+                aerospike_stream_produce, stream_p);
+    }
+
+    __sync_synchronize();
+    stream_p->done = 1;
+    return NULL;
+}
+
+/*
+ *******************************************************************************************************
+ * Creates a record stream over a bounded ring.
+ *
+ * @param as_object_p       The C client's aerospike object.
+ * @param capacity          Maximum number of records buffered between the
+ *                          C client and the PHP thread. Rounded up to a
+ *                          power of two.
+ *
+ * @return the stream, or NULL on allocation failure.
+ *******************************************************************************************************
+ */
+extern aerospike_stream*
+aerospike_stream_create(aerospike *as_object_p, uint32_t capacity)
+{
+    aerospike_stream    *stream_p = NULL;
+    uint64_t            size = 2;
+    uint64_t            i = 0;
+
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    if (NULL == (stream_p = (aerospike_stream *) calloc(1, sizeof(aerospike_stream)))) {
+        return NULL;
+    }
+
+    if (NULL == (stream_p->cells_p = (aerospike_stream_cell *)
+                calloc(size, sizeof(aerospike_stream_cell)))) {
+        free(stream_p);
+        return NULL;
+    }
+
+    for (i = 0; i < size; i++) {
+        stream_p->cells_p[i].sequence = i;
+    }
+    stream_p->mask = size - 1;
+    stream_p->as_object_p = as_object_p;
+    as_error_init(&stream_p->error);
+    return stream_p;
+}
+
+/*
+ *******************************************************************************************************
+ * Starts the worker thread for the stream.
+ *
+ * @param stream_p          The record stream.
+ * @param error_p           The C client's as_error to be set to the encountered error.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+static as_status
+aerospike_stream_start(aerospike_stream *stream_p, as_error *error_p)
+{
+    if (0 != pthread_create(&stream_p->worker, NULL, aerospike_stream_worker, stream_p)) {
+        PHP_EXT_SET_AS_ERR(error_p, AEROSPIKE_ERR_CLIENT,
+                "Unable to start the record stream thread");
+        return error_p->code;
+    }
+    stream_p->started = true;
+    return AEROSPIKE_OK;
+}
+
+/*
+ *******************************************************************************************************
+ * Starts streaming the records of a scan. The scan and policy are used by
+ * the worker thread until the stream is destroyed.
+ *
+ * @param stream_p          The record stream.
+ * @param scan_policy_p     The scan policy (may be NULL for defaults).
+ * @param scan_p            The scan to be run.
+ * @param owns_request      Whether the stream should destroy scan_p.
+ * @param error_p           The C client's as_error to be set to the encountered error.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+extern as_status
+aerospike_stream_start_scan(aerospike_stream *stream_p,
+        as_policy_scan *scan_policy_p, as_scan *scan_p, bool owns_request,
+        as_error *error_p)
+{
+    stream_p->type = AEROSPIKE_STREAM_TYPE_SCAN;
+    stream_p->scan_p = scan_p;
+    stream_p->owns_request = owns_request;
+    if (scan_policy_p) {
+        stream_p->scan_policy = *scan_policy_p;
+    } else {
+        as_policy_scan_init(&stream_p->scan_policy);
+    }
+    return aerospike_stream_start(stream_p, error_p);
+}
+
+/*
+ *******************************************************************************************************
+ * Starts streaming the records of a query. The query and policy are used by
+ * the worker thread until the stream is destroyed.
+ *
+ * @param stream_p          The record stream.
+ * @param query_policy_p    The query policy (may be NULL for defaults).
+ * @param query_p           The query to be run.
+ * @param owns_request      Whether the stream should destroy query_p.
+ * @param error_p           The C client's as_error to be set to the encountered error.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+extern as_status
+aerospike_stream_start_query(aerospike_stream *stream_p,
+        as_policy_query *query_policy_p, as_query *query_p, bool owns_request,
+        as_error *error_p)
+{
+    stream_p->type = AEROSPIKE_STREAM_TYPE_QUERY;
+    stream_p->query_p = query_p;
+    stream_p->owns_request = owns_request;
+    if (query_policy_p) {
+        stream_p->query_policy = *query_policy_p;
+    } else {
+        as_policy_query_init(&stream_p->query_policy);
+    }
+    return aerospike_stream_start(stream_p, error_p);
+}
+
+/*
+ *******************************************************************************************************
+ * Returns the next record of the stream, waiting for the C client to
+ * produce one if the ring is empty. Must be called from the PHP thread.
+ * The caller owns the returned record and must as_record_destroy() it.
+ *
+ * @param stream_p          The record stream.
+ *
+ * @return the next record, or NULL once the stream is exhausted.
+ *******************************************************************************************************
+ */
+extern as_record*
+aerospike_stream_next(aerospike_stream *stream_p)
+{
+    as_record       *record_p = NULL;
+    uint32_t        spins = 0;
+
+    if (!stream_p->started) {
+        return NULL;
+    }
+
+    while (NULL == (record_p = aerospike_stream_pop(stream_p))) {
+        if (stream_p->done) {
+            /*
+             * The worker may have published its last record just before
+             * setting done, so look once more before giving up.
+             */
+            __sync_synchronize();
+            return aerospike_stream_pop(stream_p);
+        }
+        aerospike_stream_backoff(&spins);
+    }
+    return record_p;
+}
+
+/*
+ *******************************************************************************************************
+ * Waits for the next record as aerospike_stream_next() does, adding the time
+ * spent waiting to *wait_ns_p. A record already queued is taken without
+ * reading the clock, so a stream the callback cannot keep up with costs
+ * nothing to time.
+ *
+ * @param stream_p          The record stream.
+ * @param wait_ns_p         The wait time summed up so far.
+ *
+ * @return the next record, or NULL once the stream is exhausted.
+ *******************************************************************************************************
+ */
+static as_record*
+aerospike_stream_next_timed(aerospike_stream *stream_p, uint64_t *wait_ns_p)
+{
+#ifndef AEROSPIKE_NO_STATS
+    as_record       *record_p = NULL;
+    uint64_t        begin_ns = 0;
+
+    if (stream_p->started && (NULL != (record_p = aerospike_stream_pop(stream_p)))) {
+        return record_p;
+    }
+    begin_ns = aerospike_stats_now_ns();
+    record_p = aerospike_stream_next(stream_p);
+    *wait_ns_p += aerospike_stats_now_ns() - begin_ns;
+    return record_p;
+#else
+    return aerospike_stream_next(stream_p);
+#endif
+}
+
+/*
+ *******************************************************************************************************
+ * Asks the producers to stop. The C client aborts the scan/query at the
+ * next record; records already queued are discarded on destroy.
+ *
+ * @param stream_p          The record stream.
+ *******************************************************************************************************
+ */
+extern void
+aerospike_stream_cancel(aerospike_stream *stream_p)
+{
+    stream_p->cancelled = 1;
+    __sync_synchronize();
+}
+
+/*
+ *******************************************************************************************************
+ * Cancels the stream if it is still running, waits for the worker thread,
+ * releases any queued records and frees the stream.
+ *
+ * @param stream_p          The record stream.
+ * @param error_p           If not NULL, set to the error the scan/query
+ *                          ended with (unless the stream was cancelled).
+ * @param report_cancelled  Also set error_p when the stream was cancelled.
+ *                          Only the iterator reports ERR_SCAN_ABORTED, a
+ *                          callback stopping scan()/query() is not an error.
+ *
+ * @return the status of the scan/query.
+ *******************************************************************************************************
+ */
+extern as_status
+aerospike_stream_destroy(aerospike_stream *stream_p, as_error *error_p,
+        bool report_cancelled)
+{
+    as_record       *record_p = NULL;
+    as_status       status = AEROSPIKE_OK;
+
+    if (!stream_p) {
+        return status;
+    }
+
+    if (stream_p->started) {
+        if (!stream_p->done) {
+            aerospike_stream_cancel(stream_p);
+        }
+        /*
+         * Producers may be waiting on a full ring: keep draining until the
+         * worker is done so they can observe the cancellation.
+         */
+        while (NULL != (record_p = aerospike_stream_next(stream_p))) {
+            as_record_destroy(record_p);
+        }
+        pthread_join(stream_p->worker, NULL);
+        while (NULL != (record_p = aerospike_stream_pop(stream_p))) {
+            as_record_destroy(record_p);
+        }
+    }
+
+    status = stream_p->error.code;
+    if (error_p && (report_cancelled || !stream_p->cancelled)) {
+        as_error_copy(error_p, &stream_p->error);
+    }
+
+    if (stream_p->owns_request) {
+        if (stream_p->scan_p) {
+            as_scan_destroy(stream_p->scan_p);
+        }
+        if (stream_p->query_p) {
+            as_query_destroy(stream_p->query_p);
+        }
+    }
+
+    free(stream_p->cells_p);
+    free(stream_p);
+    return status;
+}
+
+/*
+ *******************************************************************************************************
+ * Drains the stream on the PHP thread, invoking the userland callback for
+ * every record, or for every batch_size records when batching is enabled
+ * (OPT_CALLBACK_BATCH_SIZE). The callback returning false cancels the
+ * scan/query. Only the waits for the records are timed: they are summed up
+ * and added once to the network time of the scan()/query() call.
+ *
+ * @param stream_p          The record stream (destroyed by this function).
+ * @param user_func_p       The user's callback to be applied per record.
+ * @param batch_size        0 to pass each record to the callback, else the
+ *                          maximum number of records per callback array.
+ * @param error_p           The C client's as_error to be set to the encountered error.
+ *
+ * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
+ *******************************************************************************************************
+ */
+extern as_status
+aerospike_stream_run(aerospike_stream *stream_p, userland_callback *user_func_p,
+        uint32_t batch_size, as_error *error_p TSRMLS_DC)
+{
+    as_record       *record_p = NULL;
+    zval            *batch_p = NULL;
+    zval            *record_zval_p = NULL;
+    bool            do_continue = true;
+    uint64_t        wait_ns = 0;
+
+    while (do_continue &&
+            (NULL != (record_p = aerospike_stream_next_timed(stream_p, &wait_ns)))) {
+        if (!batch_size) {
+            do_continue = aerospike_helper_record_stream_dispatch(record_p,
+                    user_func_p TSRMLS_CC);
+            as_record_destroy(record_p);
+            continue;
+        }
+
+        if (!batch_p) {
+            MAKE_STD_ZVAL(batch_p);
+            array_init_size(batch_p, batch_size);
+        }
+
+        MAKE_STD_ZVAL(record_zval_p);
+        array_init(record_zval_p);
+        if (AEROSPIKE_OK == aerospike_helper_record_stream_to_zval(record_p,
+                    record_zval_p TSRMLS_CC)) {
+            add_next_index_zval(batch_p, record_zval_p);
+        } else {
+            zval_ptr_dtor(&record_zval_p);
+        }
+        as_record_destroy(record_p);
+
+        if (zend_hash_num_elements(Z_ARRVAL_P(batch_p)) >= batch_size) {
+            do_continue = aerospike_helper_record_stream_call(batch_p,
+                    user_func_p TSRMLS_CC);
+            zval_ptr_dtor(&batch_p);
+            batch_p = NULL;
+        }
+    }
+
+    if (!do_continue) {
+        aerospike_stream_cancel(stream_p);
+    } else if (batch_p && zend_hash_num_elements(Z_ARRVAL_P(batch_p))) {
+        /* flush the last, partial batch */
+        aerospike_helper_record_stream_call(batch_p, user_func_p TSRMLS_CC);
+    }
+
+    if (batch_p) {
+        zval_ptr_dtor(&batch_p);
+    }
+
+#ifndef AEROSPIKE_NO_STATS
+    aerospike_stats_net_add(stream_p->as_object_p,
+            stream_p->scan_p ? stream_p->scan_p->ns :
+            (stream_p->query_p ? stream_p->query_p->ns : NULL),
+            stream_p->scan_p ? stream_p->scan_p->set :
+            (stream_p->query_p ? stream_p->query_p->set : NULL),
+            wait_ns TSRMLS_CC);
+#endif
+    aerospike_stream_destroy(stream_p, error_p, false);
+    return error_p->code;
+}
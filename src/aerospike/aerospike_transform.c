@@ -2736,7 +2736,7 @@ exit:
  * @return AEROSPIKE_OK if success. Otherwise AEROSPIKE_x.
  *******************************************************************************************************
  */
-static void
+extern void
 aerospike_transform_iterate_records(zval **record_pp,
                                     as_record* as_record_p,
                                     as_static_pool* static_pool,
@@ -2818,7 +2818,8 @@ aerospike_transform_key_data_put(aerospike* as_object_p,
 
     record.gen = gen_value;
     record.ttl = ttl_u32;
-    aerospike_key_put(as_object_p, error_p, &write_policy, as_key_p, &record);
+    AEROSPIKE_STATS_NET(as_object_p, as_key_p, NULL, NULL, record.bins.size,
+            aerospike_key_put(as_object_p, error_p, &write_policy, as_key_p, &record));
 
 exit:
     /* clean up the as_* objects that were initialised */
@@ -3296,14 +3297,19 @@ aerospike_transform_get_record(Aerospike_object* aerospike_obj_p,
     }
 
     if (bins_p != NULL) {
-        if (AEROSPIKE_OK != (status =
-                    aerospike_transform_filter_bins_exists(as_object_p,
+        if (AEROSPIKE_OK != (status = AEROSPIKE_STATS_NET_READ(as_object_p,
+                        get_rec_key_p, read_policy.replica,
+                        get_record ? get_record->bins.size : 0,
+                        aerospike_transform_filter_bins_exists(as_object_p,
                             Z_ARRVAL_P(bins_p), &get_record, error_p,
-                                    get_rec_key_p, &read_policy))) {
+                                    get_rec_key_p, &read_policy)))) {
             goto exit;
         }
-    } else if (AEROSPIKE_OK != (status = aerospike_key_get(as_object_p, error_p,
-                    &read_policy, get_rec_key_p, &get_record))) {
+    } else if (AEROSPIKE_OK != (status = AEROSPIKE_STATS_NET_READ(as_object_p,
+                    get_rec_key_p, read_policy.replica,
+                    get_record ? get_record->bins.size : 0,
+                    aerospike_key_get(as_object_p, error_p,
+                        &read_policy, get_rec_key_p, &get_record)))) {
         goto exit;
     }
     if (!as_record_foreach(get_record, (as_rec_foreach_callback) AS_DEFAULT_GET,
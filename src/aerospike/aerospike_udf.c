@@ -196,7 +196,9 @@ aerospike_udf_apply(Aerospike_object* aerospike_obj_p,
         AS_LIST_PUT(NULL, args_pp, args_list_p, &udf_pool, serializer_policy, error_p TSRMLS_CC);
     }
 
-    if (AEROSPIKE_OK != (aerospike_key_apply(aerospike_obj_p->as_ref_p->as_p,
+    if (AEROSPIKE_OK != AEROSPIKE_STATS_NET(aerospike_obj_p->as_ref_p->as_p,
+                as_key_p, NULL, NULL, 0,
+                aerospike_key_apply(aerospike_obj_p->as_ref_p->as_p,
                     error_p, &apply_policy, as_key_p, module_p, function_p,
                     (as_list *) args_list_p, &udf_result_p))) {
         DEBUG_PHP_EXT_DEBUG("%s", error_p->message);
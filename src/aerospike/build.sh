@@ -102,7 +102,7 @@ OS=`uname`
 CFLAGS="-g -D__AEROSPIKE_PHP_CLIENT_LOG_LEVEL__=${LOGLEVEL}"
 
 if [ $OS = "Darwin" ] ; then
-    LDFLAGS="-L$CLIENTREPO_3X/lib -laerospike -lcrypto"
+    LDFLAGS="-L$CLIENTREPO_3X/lib -laerospike -lcrypto -lz"
 else
     LDFLAGS="-Wl,-Bstatic -L$CLIENTREPO_3X/lib -laerospike -Wl,-Bdynamic"
     # Find and link to libcrypto (provided by OpenSSL)
@@ -130,7 +130,7 @@ else
             fi
         fi
     fi
-    LDFLAGS="$LDFLAGS $LIBCRYPTO -lrt"
+    LDFLAGS="$LDFLAGS $LIBCRYPTO -lrt -lz"
 fi
 
 make clean all "CFLAGS=$CFLAGS" "EXTRA_INCLUDES+=-I$CLIENTREPO_3X/include -I$CLIENTREPO_3X/include/ck" "EXTRA_LDFLAGS=$LDFLAGS"
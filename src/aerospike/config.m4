@@ -1,6 +1,14 @@
 PHP_ARG_ENABLE(aerospike, whether to enable Aerospike support, [ --enable-aerospike Enable Aerospike support])
+PHP_ARG_ENABLE(aerospike-stats, whether to record Aerospike client-side latency statistics, [ --disable-aerospike-stats Disable Aerospike client-side latency statistics], yes, no)
+PHP_ARG_ENABLE(aerospike-bench, whether to build the Aerospike offline transform benchmark, [ --enable-aerospike-bench Build Aerospike::benchTransform() for the offline transform benchmark], no, no)
 
 if test "$PHP_AEROSPIKE" = "yes"; then
   AC_DEFINE(HAVE_AEROSPIKE, 1, [Whether you have Aerospike])
-  PHP_NEW_EXTENSION(aerospike, aerospike.c aerospike_policy.c aerospike_transform.c aerospike_helper.c aerospike_record_operations.c aerospike_udf.c aerospike_scan.c aerospike_query.c aerospike_index_operations.c aerospike_info_operations.c aerospike_batch_operations.c aerospike_session_handler.c, $ext_shared)
+  if test "$PHP_AEROSPIKE_STATS" = "no"; then
+    AC_DEFINE(AEROSPIKE_NO_STATS, 1, [Whether to compile out the client-side latency statistics])
+  fi
+  if test "$PHP_AEROSPIKE_BENCH" = "yes"; then
+    AC_DEFINE(AEROSPIKE_BENCH, 1, [Whether to build the offline transform benchmark])
+  fi
+  PHP_NEW_EXTENSION(aerospike, aerospike.c aerospike_policy.c aerospike_transform.c aerospike_helper.c aerospike_record_operations.c aerospike_udf.c aerospike_scan.c aerospike_query.c aerospike_index_operations.c aerospike_info_operations.c aerospike_batch_operations.c aerospike_session_handler.c aerospike_stream.c aerospike_iterator.c aerospike_export.c aerospike_import.c aerospike_reduce.c aerospike_stats.c aerospike_log.c aerospike_bench.c, $ext_shared)
 fi
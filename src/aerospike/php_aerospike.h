@@ -50,14 +50,25 @@ ZEND_BEGIN_MODULE_GLOBALS(aerospike)
     int serializer;
     char *lua_system_path;
     char *lua_user_path;
+    zend_bool lua_cache_enabled;
     int key_policy;
     int key_gen;
     zend_bool shm_use;
-    int shm_max_nodes;
-    int shm_max_namespaces;
-    int shm_takeover_threshold_sec;
+    long shm_max_nodes;
+    long shm_max_namespaces;
+    long shm_takeover_threshold_sec;
+    char *preconnect;
+    long preconnect_sockets;
+    zend_bool preconnected;
+    long persistent_idle_timeout_sec;
+    long persistent_max_age_sec;
+    long slow_op_threshold_ms;
     aerospike_global_error error_g;
     HashTable *persistent_list_g;
+    struct aerospike_registry_s *registry_g;
+    struct aerospike_stats_s *stats_g;
+    struct aerospike_stats_call_s *stats_call_g;
+    HashTable *session_cache_g;
     int persistent_ref_count;
     pthread_rwlock_t aerospike_mutex;
 ZEND_END_MODULE_GLOBALS(aerospike)
@@ -93,6 +104,10 @@ PHP_METHOD(Aerospike, isConnected);
 PHP_METHOD(Aerospike, close);
 PHP_METHOD(Aerospike, reconnect);
 PHP_METHOD(Aerospike, getNodes);
+PHP_METHOD(Aerospike, shmStats);
+PHP_METHOD(Aerospike, nodeStats);
+PHP_METHOD(Aerospike, runtimeInfo);
+PHP_METHOD(Aerospike, stats);
 PHP_METHOD(Aerospike, info);
 PHP_METHOD(Aerospike, infoMany);
 
@@ -124,6 +139,9 @@ PHP_METHOD(Aerospike, remove);
 PHP_METHOD(Aerospike, removeBin);
 PHP_METHOD(Aerospike, setDeserializer);
 PHP_METHOD(Aerospike, setSerializer);
+#ifdef AEROSPIKE_BENCH
+PHP_METHOD(Aerospike, benchTransform);
+#endif
 PHP_METHOD(Aerospike, touch);
 
 /*
@@ -132,6 +150,7 @@ PHP_METHOD(Aerospike, touch);
 
 PHP_METHOD(Aerospike, setLogLevel);
 PHP_METHOD(Aerospike, setLogHandler);
+PHP_METHOD(Aerospike, setTraceHandler);
 
 /*
  * Secondary Index APIs:
@@ -151,6 +170,12 @@ PHP_METHOD(Aerospike, aggregate);
 PHP_METHOD(Aerospike, scan);
 PHP_METHOD(Aerospike, scanApply);
 PHP_METHOD(Aerospike, scanInfo);
+PHP_METHOD(Aerospike, scanIterator);
+PHP_METHOD(Aerospike, queryIterator);
+PHP_METHOD(Aerospike, scanToFile);
+PHP_METHOD(Aerospike, importFile);
+PHP_METHOD(Aerospike, scanAggregate);
+PHP_METHOD(Aerospike, queryAggregate);
 
 /*
  * User Defined Function (UDF) APIs:
@@ -0,0 +1,823 @@
+<?php
+################################################################################
+# Copyright 2013-2015 Aerospike, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+################################################################################
+#
+# A stand-in for an Aerospike cluster, speaking enough of the wire protocol
+# for the C client underneath the extension: info requests (including the
+# ones the client's tend thread issues), single record reads, writes,
+# deletes, touches and operate(), batch reads and scans. Every fake node
+# listens on its own port of one process and they share a single in-memory
+# store; each node owns the partitions p where p % nodes == its index, which
+# keeps scans from returning a record twice.
+#
+# Latency, errors and dropped connections can be injected on the command
+# line, or at runtime with the mock-set info command, e.g.
+#   $db->info("mock-set:latency_ms=20;error_rate=0.1", $response);
+#
+# Queries, UDFs and LDTs are answered with AEROSPIKE_ERR_UNSUPPORTED_FEATURE.
+################################################################################
+
+define('PROTO_VERSION', 2);
+define('PROTO_TYPE_INFO', 1);
+define('PROTO_TYPE_MSG', 3);
+define('MSG_HEADER_SIZE', 22);
+define('N_PARTITIONS', 4096);
+define('CITRUSLEAF_EPOCH', 1262304000);
+
+define('INFO1_READ', 0x01);
+define('INFO1_GET_ALL', 0x02);
+define('INFO1_NOBINDATA', 0x20);
+define('INFO2_WRITE', 0x01);
+define('INFO2_DELETE', 0x02);
+define('INFO2_GENERATION', 0x04);
+define('INFO2_GENERATION_GT', 0x08);
+define('INFO2_CREATE_ONLY', 0x20);
+define('INFO3_LAST', 0x01);
+define('INFO3_UPDATE_ONLY', 0x08);
+define('INFO3_CREATE_OR_REPLACE', 0x10);
+define('INFO3_REPLACE_ONLY', 0x20);
+
+define('FIELD_NAMESPACE', 0);
+define('FIELD_SET', 1);
+define('FIELD_KEY', 2);
+define('FIELD_DIGEST', 4);
+define('FIELD_DIGEST_ARRAY', 6);
+define('FIELD_INDEX_NAME', 21);
+define('FIELD_INDEX_RANGE', 22);
+define('FIELD_UDF_PACKAGE_NAME', 30);
+
+define('OP_READ', 1);
+define('OP_WRITE', 2);
+define('OP_INCR', 5);
+define('OP_APPEND', 9);
+define('OP_PREPEND', 10);
+define('OP_TOUCH', 11);
+
+define('PARTICLE_NULL', 0);
+define('PARTICLE_INTEGER', 1);
+define('PARTICLE_STRING', 3);
+define('PARTICLE_BLOB', 4);
+
+define('RESULT_OK', 0);
+define('RESULT_NOT_FOUND', 2);
+define('RESULT_GENERATION', 3);
+define('RESULT_PARAMETER', 4);
+define('RESULT_RECORD_EXISTS', 5);
+define('RESULT_TIMEOUT', 9);
+define('RESULT_BIN_INCOMPATIBLE', 12);
+define('RESULT_UNSUPPORTED', 16);
+define('RESULT_NAMESPACE_NOT_FOUND', 20);
+
+define('SCAN_RECORDS_PER_FRAME', 128);
+
+function parse_args() {
+    $shortopts  = "";
+    $shortopts .= "h::";  /* Optional host to listen on */
+    $shortopts .= "p::";  /* Optional port of the first node */
+
+    $longopts  = array(
+        "host::",         /* Optional host to listen on */
+        "port::",         /* Optional port of the first node */
+        "nodes::",        /* Optionally number of fake nodes */
+        "port-step::",    /* Optionally port distance between nodes */
+        "namespaces::",   /* Optionally comma separated namespaces */
+        "default-ttl::",  /* Optionally namespace default TTL in seconds */
+        "latency-ms::",   /* Optionally latency added to each command */
+        "jitter-ms::",    /* Optionally random latency added on top */
+        "slow-node::",    /* Optionally INDEX:MS extra latency of one node */
+        "error-rate::",   /* Optionally fraction of commands failed */
+        "error-code::",   /* Optionally result code of failed commands */
+        "drop-rate::",    /* Optionally fraction of connections dropped */
+        "quiet",          /* No connection log */
+        "help",           /* Usage */
+    );
+    $options = getopt($shortopts, $longopts);
+    return $options;
+}
+
+class MockNode {
+    public $index;
+    public $name;
+    public $port;
+    public $socket;
+    public $latency_ms = 0;
+    public $stats = array(
+        "reads" => 0, "writes" => 0, "deletes" => 0, "batches" => 0,
+        "scans" => 0, "info" => 0, "errors_injected" => 0,
+        "connections_dropped" => 0, "unsupported" => 0);
+}
+
+class MockConnection {
+    public $stream;
+    public $node;
+    public $in = "";
+    public $out = "";
+    public $delayed = array();
+    public $ready_at = 0.0;
+}
+
+class AerospikeMockServer {
+    private $host;
+    private $nodes = array();
+    private $conns = array();
+    private $store = array();
+    private $namespaces;
+    private $cluster_key;
+    private $quiet;
+
+    public $default_ttl = 0;
+    public $latency_ms = 0;
+    public $jitter_ms = 0;
+    public $error_rate = 0.0;
+    public $error_code = RESULT_TIMEOUT;
+    public $drop_rate = 0.0;
+
+    public function __construct($host, $port, $n_nodes, $port_step, $namespaces, $quiet) {
+        $this->host = $host;
+        $this->namespaces = $namespaces;
+        $this->quiet = $quiet;
+        $this->cluster_key = strtoupper(substr(md5($host.":".$port), 0, 16));
+        foreach ($namespaces as $ns) {
+            $this->store[$ns] = array();
+        }
+        for ($i = 0; $i < $n_nodes; $i++) {
+            $node = new MockNode();
+            $node->index = $i;
+            $node->port = $port + $i * $port_step;
+            $node->name = sprintf("BB9%05X%08X", $node->port, $i + 1);
+            $node->socket = stream_socket_server("tcp://$host:{$node->port}", $errno, $errstr);
+            if (!$node->socket) {
+                fwrite(STDERR, "Unable to listen on $host:{$node->port}: $errstr\n");
+                exit(1);
+            }
+            stream_set_blocking($node->socket, 0);
+            $this->nodes[$i] = $node;
+        }
+    }
+
+    public function setSlowNode($index, $ms) {
+        if (isset($this->nodes[$index])) {
+            $this->nodes[$index]->latency_ms = $ms;
+        }
+    }
+
+    public function describe() {
+        $ports = array();
+        foreach ($this->nodes as $node) {
+            $ports[] = $node->port;
+        }
+        return count($this->nodes)." node(s) on {$this->host}:".implode(",", $ports).
+            " namespaces: ".implode(",", $this->namespaces);
+    }
+
+    public function run() {
+        while (true) {
+            $read = array();
+            $write = array();
+            $except = null;
+            foreach ($this->nodes as $node) {
+                $read[] = $node->socket;
+            }
+            foreach ($this->conns as $conn) {
+                $read[] = $conn->stream;
+                if ($conn->out !== "") {
+                    $write[] = $conn->stream;
+                }
+            }
+            $timeout = $this->nextDue();
+            $sec = ($timeout === null) ? 1 : (int) $timeout;
+            $usec = ($timeout === null) ? 0 : (int) (($timeout - (int) $timeout) * 1000000);
+            if (empty($write)) {
+                $write = null;
+            }
+            if (@stream_select($read, $write, $except, $sec, $usec) === false) {
+                continue;
+            }
+            foreach ($read as $stream) {
+                $node = $this->listenerNode($stream);
+                if ($node !== null) {
+                    $this->accept($node);
+                } else {
+                    $this->receive((int) $stream);
+                }
+            }
+            $this->releaseDelayed();
+            foreach ($this->conns as $id => $conn) {
+                if ($conn->out !== "") {
+                    $this->flush($id);
+                }
+            }
+        }
+    }
+
+    private function listenerNode($stream) {
+        foreach ($this->nodes as $node) {
+            if ($node->socket === $stream) {
+                return $node;
+            }
+        }
+        return null;
+    }
+
+    private function accept($node) {
+        $stream = @stream_socket_accept($node->socket, 0);
+        if (!$stream) {
+            return;
+        }
+        stream_set_blocking($stream, 0);
+        $conn = new MockConnection();
+        $conn->stream = $stream;
+        $conn->node = $node;
+        $this->conns[(int) $stream] = $conn;
+        $this->log("node {$node->index}: connection ".(int) $stream." opened");
+    }
+
+    private function close($id) {
+        if (!isset($this->conns[$id])) {
+            return;
+        }
+        $conn = $this->conns[$id];
+        fclose($conn->stream);
+        unset($this->conns[$id]);
+        $this->log("node {$conn->node->index}: connection $id closed");
+    }
+
+    private function receive($id) {
+        if (!isset($this->conns[$id])) {
+            return;
+        }
+        $conn = $this->conns[$id];
+        $data = fread($conn->stream, 65536);
+        if ($data === false || ($data === "" && feof($conn->stream))) {
+            $this->close($id);
+            return;
+        }
+        $conn->in .= $data;
+        while (strlen($conn->in) >= 8) {
+            $proto = unpack("Cversion/Ctype/nsize_hi/Nsize_lo", substr($conn->in, 0, 8));
+            $size = ($proto['size_hi'] << 32) | $proto['size_lo'];
+            if (strlen($conn->in) < 8 + $size) {
+                break;
+            }
+            $body = (string) substr($conn->in, 8, $size);
+            $conn->in = (string) substr($conn->in, 8 + $size);
+            if ($proto['type'] == PROTO_TYPE_INFO) {
+                $conn->node->stats['info']++;
+                $this->reply($conn, $this->frame(PROTO_TYPE_INFO, $this->info($conn->node, $body)), 0);
+                continue;
+            }
+            if ($proto['type'] != PROTO_TYPE_MSG) {
+                $this->close($id);
+                return;
+            }
+            if ($this->drop_rate > 0 && $this->chance($this->drop_rate)) {
+                $conn->node->stats['connections_dropped']++;
+                $this->close($id);
+                return;
+            }
+            $this->reply($conn, $this->command($conn->node, $body), $this->delayFor($conn->node));
+        }
+    }
+
+    private function reply($conn, $bytes, $delay_ms) {
+        $now = microtime(true);
+        if ($delay_ms <= 0 && empty($conn->delayed)) {
+            $conn->out .= $bytes;
+            return;
+        }
+        /* replies on a connection go out in order, whatever their delay */
+        $conn->ready_at = max($conn->ready_at, $now + $delay_ms / 1000.0);
+        $conn->delayed[] = array($conn->ready_at, $bytes);
+    }
+
+    private function nextDue() {
+        $due = null;
+        foreach ($this->conns as $conn) {
+            if (!empty($conn->delayed) && ($due === null || $conn->delayed[0][0] < $due)) {
+                $due = $conn->delayed[0][0];
+            }
+        }
+        return ($due === null) ? null : max(0.0, $due - microtime(true));
+    }
+
+    private function releaseDelayed() {
+        $now = microtime(true);
+        foreach ($this->conns as $conn) {
+            while (!empty($conn->delayed) && $conn->delayed[0][0] <= $now) {
+                $entry = array_shift($conn->delayed);
+                $conn->out .= $entry[1];
+            }
+        }
+    }
+
+    private function flush($id) {
+        $conn = $this->conns[$id];
+        $written = @fwrite($conn->stream, $conn->out);
+        if ($written === false) {
+            $this->close($id);
+            return;
+        }
+        $conn->out = (string) substr($conn->out, $written);
+    }
+
+    private function delayFor($node) {
+        $ms = $this->latency_ms + $node->latency_ms;
+        if ($this->jitter_ms > 0) {
+            $ms += mt_rand(0, $this->jitter_ms);
+        }
+        return $ms;
+    }
+
+    private function chance($rate) {
+        return (mt_rand() / mt_getrandmax()) < $rate;
+    }
+
+    private function log($message) {
+        if (!$this->quiet) {
+            echo date("H:i:s")." $message\n";
+        }
+    }
+
+    /*
+     * Wire format helpers.
+     */
+    private function frame($type, $body) {
+        $size = strlen($body);
+        return pack("CCnN", PROTO_VERSION, $type, ($size >> 32) & 0xFFFF, $size & 0xFFFFFFFF).$body;
+    }
+
+    private function message($result, $info3, $generation, $void_time, $fields, $bins) {
+        $msg = pack("CCCCCCNNNnn", MSG_HEADER_SIZE, 0, 0, $info3, 0, $result,
+            $generation, $void_time, 0, count($fields), count($bins));
+        foreach ($fields as $field) {
+            $msg .= pack("NC", strlen($field[1]) + 1, $field[0]).$field[1];
+        }
+        foreach ($bins as $name => $bin) {
+            $msg .= pack("NCCCC", 4 + strlen($name) + strlen($bin[1]), OP_READ,
+                $bin[0], 0, strlen($name)).$name.$bin[1];
+        }
+        return $msg;
+    }
+
+    private function status($result) {
+        return $this->frame(PROTO_TYPE_MSG, $this->message($result, INFO3_LAST, 0, 0, array(), array()));
+    }
+
+    private function encodeInt($value) {
+        return pack("NN", ($value >> 32) & 0xFFFFFFFF, $value & 0xFFFFFFFF);
+    }
+
+    private function decodeInt($bytes) {
+        $parts = unpack("Nhi/Nlo", str_pad($bytes, 8, "\0", STR_PAD_LEFT));
+        return ($parts['hi'] << 32) | $parts['lo'];
+    }
+
+    private function partitionOwner($digest) {
+        $pid = unpack("vid", substr($digest, 0, 2));
+        return ($pid['id'] & (N_PARTITIONS - 1)) % count($this->nodes);
+    }
+
+    private function voidTime($record) {
+        return ($record['expires'] == 0) ? 0 : $record['expires'] - CITRUSLEAF_EPOCH;
+    }
+
+    private function expiresFor($ttl, $record) {
+        if ($ttl == 0xFFFFFFFE) {
+            return $record ? $record['expires'] : 0;
+        }
+        if ($ttl == 0xFFFFFFFF) {
+            return 0;
+        }
+        if ($ttl == 0) {
+            return ($this->default_ttl > 0) ? time() + $this->default_ttl : 0;
+        }
+        return time() + $ttl;
+    }
+
+    private function lookup($ns, $digest) {
+        if (!isset($this->store[$ns][$digest])) {
+            return null;
+        }
+        $record = $this->store[$ns][$digest];
+        if ($record['expires'] != 0 && $record['expires'] <= time()) {
+            unset($this->store[$ns][$digest]);
+            return null;
+        }
+        return $record;
+    }
+
+    private function selectBins($record, $info1, $names) {
+        if ($info1 & INFO1_NOBINDATA) {
+            return array();
+        }
+        if (($info1 & INFO1_GET_ALL) || empty($names)) {
+            return $record['bins'];
+        }
+        $bins = array();
+        foreach ($names as $name) {
+            if (isset($record['bins'][$name])) {
+                $bins[$name] = $record['bins'][$name];
+            }
+        }
+        return $bins;
+    }
+
+    /*
+     * Info protocol.
+     */
+    private function info($node, $body) {
+        $names = array_filter(array_map("trim", explode("\n", $body)), "strlen");
+        if (empty($names)) {
+            $names = array("node", "build", "edition", "version", "statistics");
+        }
+        $response = "";
+        foreach ($names as $name) {
+            $value = $this->infoValue($node, $name);
+            if ($value !== null) {
+                $response .= "$name\t$value\n";
+            }
+        }
+        return $response;
+    }
+
+    private function replicas($node, $offset) {
+        $count = count($this->nodes);
+        $bitmap = str_repeat("\0", N_PARTITIONS / 8);
+        for ($pid = 0; $pid < N_PARTITIONS; $pid++) {
+            if ($count > $offset && ($pid + $offset) % $count == $node->index) {
+                $bitmap[$pid >> 3] = chr(ord($bitmap[$pid >> 3]) | (0x80 >> ($pid & 7)));
+            }
+        }
+        $entries = array();
+        foreach ($this->namespaces as $ns) {
+            $entries[] = "$ns:".base64_encode($bitmap);
+        }
+        return implode(";", $entries);
+    }
+
+    private function objects() {
+        $objects = 0;
+        foreach ($this->store as $records) {
+            $objects += count($records);
+        }
+        return $objects;
+    }
+
+    private function infoValue($node, $name) {
+        switch ($name) {
+            case "node":
+                return $node->name;
+            case "build":
+                return "3.6.0";
+            case "edition":
+                return "Aerospike Community Edition";
+            case "version":
+                return "Aerospike Community Edition build 3.6.0 (mock)";
+            case "features":
+                return "float";
+            case "partitions":
+                return (string) N_PARTITIONS;
+            case "partition-generation":
+            case "cluster-generation":
+                return "1";
+            case "services":
+            case "services-alternate":
+                $peers = array();
+                foreach ($this->nodes as $peer) {
+                    if ($peer !== $node) {
+                        $peers[] = "{$this->host}:{$peer->port}";
+                    }
+                }
+                return implode(";", $peers);
+            case "replicas-master":
+                return $this->replicas($node, 0);
+            case "replicas-prole":
+                return $this->replicas($node, 1);
+            case "namespaces":
+                return implode(";", $this->namespaces);
+            case "statistics":
+                return "cluster_size=".count($this->nodes).";cluster_key={$this->cluster_key};".
+                    "objects=".$this->objects().";client_connections=".count($this->conns);
+            case "mock-stats":
+                $stats = array();
+                foreach ($node->stats as $stat => $value) {
+                    $stats[] = "$stat=$value";
+                }
+                return implode(";", $stats);
+            case "mock-truncate":
+                foreach ($this->namespaces as $ns) {
+                    $this->store[$ns] = array();
+                }
+                return "ok";
+            case "sets":
+            case "bins":
+            case "sindex":
+            case "udf-list":
+                return "";
+        }
+        if (strpos($name, "namespace/") === 0) {
+            $ns = substr($name, strlen("namespace/"));
+            if (!isset($this->store[$ns])) {
+                return "type=unknown";
+            }
+            return "objects=".count($this->store[$ns]).";default-ttl={$this->default_ttl}".
+                ";replication-factor=".min(2, count($this->nodes));
+        }
+        if (strpos($name, "mock-set:") === 0) {
+            return $this->configure(substr($name, strlen("mock-set:")));
+        }
+        return null;
+    }
+
+    private function configure($settings) {
+        foreach (explode(";", $settings) as $setting) {
+            $pair = explode("=", $setting, 2);
+            if (count($pair) != 2) {
+                continue;
+            }
+            switch ($pair[0]) {
+                case "latency_ms":
+                    $this->latency_ms = (int) $pair[1];
+                    break;
+                case "jitter_ms":
+                    $this->jitter_ms = (int) $pair[1];
+                    break;
+                case "error_rate":
+                    $this->error_rate = (float) $pair[1];
+                    break;
+                case "error_code":
+                    $this->error_code = (int) $pair[1];
+                    break;
+                case "drop_rate":
+                    $this->drop_rate = (float) $pair[1];
+                    break;
+                case "default_ttl":
+                    $this->default_ttl = (int) $pair[1];
+                    break;
+                default:
+                    return "error: unknown setting {$pair[0]}";
+            }
+        }
+        return "ok";
+    }
+
+    /*
+     * Message protocol.
+     */
+    private function command($node, $body) {
+        $header = unpack("Cheader_sz/Cinfo1/Cinfo2/Cinfo3/Cunused/Cresult/Ngeneration/Nttl/Ntimeout/nn_fields/nn_ops",
+            substr($body, 0, MSG_HEADER_SIZE));
+        $pos = $header['header_sz'];
+        $fields = array();
+        for ($i = 0; $i < $header['n_fields']; $i++) {
+            $size = unpack("Nsize", substr($body, $pos, 4));
+            $fields[ord($body[$pos + 4])] = (string) substr($body, $pos + 5, $size['size'] - 1);
+            $pos += 4 + $size['size'];
+        }
+        $ops = array();
+        for ($i = 0; $i < $header['n_ops']; $i++) {
+            $size = unpack("Nsize", substr($body, $pos, 4));
+            $name_len = ord($body[$pos + 7]);
+            $ops[] = array(
+                'op' => ord($body[$pos + 4]),
+                'type' => ord($body[$pos + 5]),
+                'name' => (string) substr($body, $pos + 8, $name_len),
+                'value' => (string) substr($body, $pos + 8 + $name_len, $size['size'] - 4 - $name_len));
+            $pos += 4 + $size['size'];
+        }
+
+        if ($this->error_rate > 0 && $this->chance($this->error_rate)) {
+            $node->stats['errors_injected']++;
+            return $this->status($this->error_code);
+        }
+        if (isset($fields[FIELD_INDEX_NAME]) || isset($fields[FIELD_INDEX_RANGE]) ||
+                isset($fields[FIELD_UDF_PACKAGE_NAME])) {
+            $node->stats['unsupported']++;
+            return $this->status(RESULT_UNSUPPORTED);
+        }
+        $ns = isset($fields[FIELD_NAMESPACE]) ? $fields[FIELD_NAMESPACE] : "";
+        if (!isset($this->store[$ns])) {
+            return $this->status(RESULT_NAMESPACE_NOT_FOUND);
+        }
+        if (isset($fields[FIELD_DIGEST_ARRAY])) {
+            $node->stats['batches']++;
+            return $this->batch($ns, $header, $fields[FIELD_DIGEST_ARRAY], $ops);
+        }
+        if (isset($fields[FIELD_DIGEST])) {
+            return $this->frame(PROTO_TYPE_MSG, $this->single($node, $ns, $header, $fields, $ops));
+        }
+        $node->stats['scans']++;
+        return $this->scan($node, $ns, $header, $fields, $ops);
+    }
+
+    private function single($node, $ns, $header, $fields, $ops) {
+        $digest = $fields[FIELD_DIGEST];
+        $record = $this->lookup($ns, $digest);
+        $info1 = $header['info1'];
+        $info2 = $header['info2'];
+        $info3 = $header['info3'];
+
+        if ($info2 & INFO2_DELETE) {
+            $node->stats['deletes']++;
+            if (!$record) {
+                return $this->message(RESULT_NOT_FOUND, 0, 0, 0, array(), array());
+            }
+            unset($this->store[$ns][$digest]);
+            return $this->message(RESULT_OK, 0, 0, 0, array(), array());
+        }
+
+        if (!($info2 & INFO2_WRITE)) {
+            $node->stats['reads']++;
+            if (!$record) {
+                return $this->message(RESULT_NOT_FOUND, 0, 0, 0, array(), array());
+            }
+            $names = array();
+            foreach ($ops as $op) {
+                $names[] = $op['name'];
+            }
+            return $this->message(RESULT_OK, 0, $record['generation'], $this->voidTime($record),
+                array(), $this->selectBins($record, $info1, $names));
+        }
+
+        $node->stats['writes']++;
+        if (($info2 & INFO2_GENERATION) && (!$record || $record['generation'] != $header['generation'])) {
+            return $this->message(RESULT_GENERATION, 0, 0, 0, array(), array());
+        }
+        if (($info2 & INFO2_GENERATION_GT) && $record && $header['generation'] <= $record['generation']) {
+            return $this->message(RESULT_GENERATION, 0, 0, 0, array(), array());
+        }
+        if (($info2 & INFO2_CREATE_ONLY) && $record) {
+            return $this->message(RESULT_RECORD_EXISTS, 0, 0, 0, array(), array());
+        }
+        if (($info3 & (INFO3_UPDATE_ONLY | INFO3_REPLACE_ONLY)) && !$record) {
+            return $this->message(RESULT_NOT_FOUND, 0, 0, 0, array(), array());
+        }
+
+        $bins = ($record && !($info3 & (INFO3_CREATE_OR_REPLACE | INFO3_REPLACE_ONLY))) ?
+            $record['bins'] : array();
+        $read_names = array();
+        foreach ($ops as $op) {
+            $name = $op['name'];
+            $current = isset($bins[$name]) ? $bins[$name] : null;
+            switch ($op['op']) {
+                case OP_READ:
+                    $read_names[] = $name;
+                    break;
+                case OP_WRITE:
+                    if ($op['type'] == PARTICLE_NULL) {
+                        unset($bins[$name]);
+                    } else {
+                        $bins[$name] = array($op['type'], $op['value']);
+                    }
+                    break;
+                case OP_INCR:
+                    if ($op['type'] != PARTICLE_INTEGER ||
+                            ($current && $current[0] != PARTICLE_INTEGER)) {
+                        return $this->message(RESULT_BIN_INCOMPATIBLE, 0, 0, 0, array(), array());
+                    }
+                    $sum = ($current ? $this->decodeInt($current[1]) : 0) + $this->decodeInt($op['value']);
+                    $bins[$name] = array(PARTICLE_INTEGER, $this->encodeInt($sum));
+                    break;
+                case OP_APPEND:
+                case OP_PREPEND:
+                    if (($op['type'] != PARTICLE_STRING && $op['type'] != PARTICLE_BLOB) ||
+                            ($current && $current[0] != $op['type'])) {
+                        return $this->message(RESULT_BIN_INCOMPATIBLE, 0, 0, 0, array(), array());
+                    }
+                    $value = $current ? $current[1] : "";
+                    $value = ($op['op'] == OP_APPEND) ? $value.$op['value'] : $op['value'].$value;
+                    $bins[$name] = array($op['type'], $value);
+                    break;
+                case OP_TOUCH:
+                    if (!$record) {
+                        return $this->message(RESULT_NOT_FOUND, 0, 0, 0, array(), array());
+                    }
+                    break;
+                default:
+                    $node->stats['unsupported']++;
+                    return $this->message(RESULT_UNSUPPORTED, 0, 0, 0, array(), array());
+            }
+        }
+
+        if (empty($bins)) {
+            unset($this->store[$ns][$digest]);
+            return $this->message(RESULT_OK, 0, 0, 0, array(), array());
+        }
+        $updated = array(
+            'set' => isset($fields[FIELD_SET]) ? $fields[FIELD_SET] :
+                ($record ? $record['set'] : ""),
+            'key' => isset($fields[FIELD_KEY]) ? $fields[FIELD_KEY] :
+                ($record ? $record['key'] : null),
+            'generation' => $record ? $record['generation'] + 1 : 1,
+            'expires' => $this->expiresFor($header['ttl'], $record),
+            'bins' => $bins);
+        $this->store[$ns][$digest] = $updated;
+
+        $reply_bins = empty($read_names) ? array() : $this->selectBins($updated, $info1, $read_names);
+        return $this->message(RESULT_OK, 0, $updated['generation'], $this->voidTime($updated),
+            array(), $reply_bins);
+    }
+
+    private function batch($ns, $header, $digests, $ops) {
+        $names = array();
+        foreach ($ops as $op) {
+            $names[] = $op['name'];
+        }
+        $body = "";
+        for ($pos = 0; $pos + 20 <= strlen($digests); $pos += 20) {
+            $digest = substr($digests, $pos, 20);
+            $fields = array(array(FIELD_NAMESPACE, $ns), array(FIELD_DIGEST, $digest));
+            $record = $this->lookup($ns, $digest);
+            if (!$record) {
+                $body .= $this->message(RESULT_NOT_FOUND, 0, 0, 0, $fields, array());
+                continue;
+            }
+            $body .= $this->message(RESULT_OK, 0, $record['generation'], $this->voidTime($record),
+                $fields, $this->selectBins($record, $header['info1'], $names));
+        }
+        $body .= $this->message(RESULT_OK, INFO3_LAST, 0, 0, array(), array());
+        return $this->frame(PROTO_TYPE_MSG, $body);
+    }
+
+    private function scan($node, $ns, $header, $fields, $ops) {
+        $set = isset($fields[FIELD_SET]) ? $fields[FIELD_SET] : "";
+        $names = array();
+        foreach ($ops as $op) {
+            $names[] = $op['name'];
+        }
+        $frames = "";
+        $body = "";
+        $in_frame = 0;
+        foreach (array_keys($this->store[$ns]) as $digest) {
+            if ($this->partitionOwner($digest) != $node->index) {
+                continue;
+            }
+            $record = $this->lookup($ns, $digest);
+            if (!$record || ($set !== "" && $record['set'] !== $set)) {
+                continue;
+            }
+            $record_fields = array(array(FIELD_NAMESPACE, $ns));
+            if ($record['set'] !== "") {
+                $record_fields[] = array(FIELD_SET, $record['set']);
+            }
+            if ($record['key'] !== null) {
+                $record_fields[] = array(FIELD_KEY, $record['key']);
+            }
+            $record_fields[] = array(FIELD_DIGEST, $digest);
+            $body .= $this->message(RESULT_OK, 0, $record['generation'], $this->voidTime($record),
+                $record_fields, $this->selectBins($record, $header['info1'], $names));
+            if (++$in_frame == SCAN_RECORDS_PER_FRAME) {
+                $frames .= $this->frame(PROTO_TYPE_MSG, $body);
+                $body = "";
+                $in_frame = 0;
+            }
+        }
+        $body .= $this->message(RESULT_OK, INFO3_LAST, 0, 0, array(), array());
+        return $frames.$this->frame(PROTO_TYPE_MSG, $body);
+    }
+}
+
+$args = parse_args();
+if (isset($args["help"])) {
+    echo "php mock-server.php [-hHOST] [-pPORT] [--nodes=N] [--port-step=STEP]\n";
+    echo "    [--namespaces=NS,...] [--default-ttl=SECONDS]\n";
+    echo "    [--latency-ms=MS] [--jitter-ms=MS] [--slow-node=INDEX:MS]\n";
+    echo "    [--error-rate=FRACTION] [--error-code=CODE] [--drop-rate=FRACTION] [--quiet]\n";
+    exit(1);
+}
+$addr = (isset($args["h"])) ? (string) $args["h"] : ((isset($args["host"])) ? (string) $args["host"] : "127.0.0.1");
+$port = (isset($args["p"])) ? (integer) $args["p"] : ((isset($args["port"])) ? (integer) $args["port"] : 3000);
+$nodes = (isset($args["nodes"])) ? (integer) $args["nodes"] : 2;
+$port_step = (isset($args["port-step"])) ? (integer) $args["port-step"] : 10;
+$namespaces = (isset($args["namespaces"])) ? explode(",", $args["namespaces"]) : array("test", "bar");
+
+$server = new AerospikeMockServer($addr, $port, max(1, $nodes), $port_step, $namespaces, isset($args["quiet"]));
+if (isset($args["default-ttl"])) $server->default_ttl = (integer) $args["default-ttl"];
+if (isset($args["latency-ms"])) $server->latency_ms = (integer) $args["latency-ms"];
+if (isset($args["jitter-ms"])) $server->jitter_ms = (integer) $args["jitter-ms"];
+if (isset($args["error-rate"])) $server->error_rate = (float) $args["error-rate"];
+if (isset($args["error-code"])) $server->error_code = (integer) $args["error-code"];
+if (isset($args["drop-rate"])) $server->drop_rate = (float) $args["drop-rate"];
+if (isset($args["slow-node"])) {
+    foreach ((array) $args["slow-node"] as $slow) {
+        list($index, $ms) = array_pad(explode(":", $slow, 2), 2, 0);
+        $server->setSlowNode((integer) $index, (integer) $ms);
+    }
+}
+
+echo "Aerospike mock cluster: ".$server->describe()."\n";
+$server->run();
+?>
@@ -0,0 +1,15 @@
+--TEST--
+AerospikeSession - Check that an unmodified session is not written within lazy_touch.
+
+--SKIPIF--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_skipif("AerospikeSession", "testSessionCLazyTouch");
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("AerospikeSession", "testSessionCLazyTouch");
+--EXPECT--
+OK
+
@@ -0,0 +1,15 @@
+--TEST--
+AerospikeSession - Check that the session read refreshes the TTL and an unmodified session is not written.
+
+--SKIPIF--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_skipif("AerospikeSession", "testSessionDReadTouch");
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("AerospikeSession", "testSessionDReadTouch");
+--EXPECT--
+OK
+
@@ -0,0 +1,15 @@
+--TEST--
+AerospikeSession - Check that concurrent session modifications are merged.
+
+--SKIPIF--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_skipif("AerospikeSession", "testSessionEConcurrentMerge");
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("AerospikeSession", "testSessionEConcurrentMerge");
+--EXPECT--
+OK
+
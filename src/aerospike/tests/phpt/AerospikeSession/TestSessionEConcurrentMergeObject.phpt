@@ -0,0 +1,15 @@
+--TEST--
+AerospikeSession - Check that session objects are merged without being unserialized.
+
+--SKIPIF--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_skipif("AerospikeSession", "testSessionEConcurrentMergeObject");
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("AerospikeSession", "testSessionEConcurrentMergeObject");
+--EXPECT--
+OK
+
@@ -0,0 +1,15 @@
+--TEST--
+AerospikeSession - Check that a compressed session is read back.
+
+--SKIPIF--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_skipif("AerospikeSession", "testSessionFCompressed");
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("AerospikeSession", "testSessionFCompressed");
+--EXPECT--
+OK
+
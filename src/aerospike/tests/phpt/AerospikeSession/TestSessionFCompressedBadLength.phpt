@@ -0,0 +1,15 @@
+--TEST--
+AerospikeSession - Check that a compressed session with a bad length is rejected.
+
+--SKIPIF--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_skipif("AerospikeSession", "testSessionFCompressedBadLength");
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("AerospikeSession", "testSessionFCompressedBadLength");
+--EXPECT--
+OK
+
@@ -0,0 +1,15 @@
+--TEST--
+AerospikeSession - Check that reopened sessions reuse the cached connection.
+
+--SKIPIF--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_skipif("AerospikeSession", "testSessionGCachedConnection");
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("AerospikeSession", "testSessionGCachedConnection");
+--EXPECT--
+OK
+
@@ -0,0 +1,15 @@
+--TEST--
+AerospikeSession - Check that a concurrent read-only request does not conflict.
+
+--SKIPIF--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_skipif("AerospikeSession", "testSessionHReadOnlyNoConflict");
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("AerospikeSession", "testSessionHReadOnlyNoConflict");
+--EXPECT--
+OK
+
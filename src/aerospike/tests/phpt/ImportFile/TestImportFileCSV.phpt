@@ -0,0 +1,9 @@
+--TEST--
+ImportFile - CSV file with a header row
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("ImportFile", "testImportFileCSV");
+--EXPECT--
+OK
@@ -0,0 +1,9 @@
+--TEST--
+ImportFile - msgpack is not an import format
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("ImportFile", "testImportFileInvalidFormat");
+--EXPECT--
+ERR_PARAM
@@ -0,0 +1,9 @@
+--TEST--
+ImportFile - NDJSON file with one invalid line
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("ImportFile", "testImportFileNDJSON");
+--EXPECT--
+OK
@@ -0,0 +1,9 @@
+--TEST--
+NodeStats - count commands
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("NodeStats", "testNodeStatsCountCommands");
+--EXPECT--
+OK
@@ -0,0 +1,9 @@
+--TEST--
+NodeStats - count reads sent with replica any
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("NodeStats", "testNodeStatsCountReplicaAny");
+--EXPECT--
+OK
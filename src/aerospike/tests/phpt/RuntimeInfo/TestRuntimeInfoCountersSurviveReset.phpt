@@ -0,0 +1,9 @@
+--TEST--
+RuntimeInfo - counters survive a stats reset
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("RuntimeInfo", "testRuntimeInfoCountersSurviveReset");
+--EXPECT--
+OK
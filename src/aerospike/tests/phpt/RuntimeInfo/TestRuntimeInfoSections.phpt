@@ -0,0 +1,9 @@
+--TEST--
+RuntimeInfo - sections
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("RuntimeInfo", "testRuntimeInfoSections");
+--EXPECT--
+OK
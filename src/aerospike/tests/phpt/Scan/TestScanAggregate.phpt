@@ -0,0 +1,9 @@
+--TEST--
+Scan - Aggregate a scan with the built-in reducers
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("Scan", "testScanAggregate");
+--EXPECT--
+OK
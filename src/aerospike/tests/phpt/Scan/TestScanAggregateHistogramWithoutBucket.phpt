@@ -0,0 +1,9 @@
+--TEST--
+Scan - Aggregate a scan into a histogram without a bucket width
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("Scan", "testScanAggregateHistogramWithoutBucket");
+--EXPECT--
+ERR_PARAM
@@ -0,0 +1,9 @@
+--TEST--
+Scan - Scan with a callback receiving batches of records
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("Scan", "testScanCallbackBatchSize");
+--EXPECT--
+OK
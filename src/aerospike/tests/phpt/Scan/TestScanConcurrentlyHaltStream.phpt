@@ -0,0 +1,9 @@
+--TEST--
+Scan - Concurrent scan halted from the callback
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("Scan", "testScanConcurrentlyHaltStream");
+--EXPECT--
+OK
@@ -0,0 +1,9 @@
+--TEST--
+Scan - Iterate over a scan
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("Scan", "testScanIterator");
+--EXPECT--
+OK
@@ -0,0 +1,9 @@
+--TEST--
+Scan - Close the connection under a scan iterator
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("Scan", "testScanIteratorClose");
+--EXPECT--
+OK
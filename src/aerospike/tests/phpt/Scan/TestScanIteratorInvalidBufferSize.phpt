@@ -0,0 +1,9 @@
+--TEST--
+Scan - Scan iterator with an invalid buffer size
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("Scan", "testScanIteratorInvalidBufferSize");
+--EXPECT--
+ERR_PARAM
@@ -0,0 +1,9 @@
+--TEST--
+Scan - Export a scan to CSV without selecting the bins
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("Scan", "testScanToFileCSVWithoutSelect");
+--EXPECT--
+ERR_PARAM
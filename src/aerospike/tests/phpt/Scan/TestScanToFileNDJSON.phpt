@@ -0,0 +1,9 @@
+--TEST--
+Scan - Export a scan to NDJSON part files
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("Scan", "testScanToFileNDJSON");
+--EXPECT--
+OK
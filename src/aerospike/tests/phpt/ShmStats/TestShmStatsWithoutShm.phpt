@@ -0,0 +1,9 @@
+--TEST--
+ShmStats - shared memory tending not in use
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("ShmStats", "testShmStatsWithoutShm");
+--EXPECT--
+ERR_CLIENT
@@ -0,0 +1,9 @@
+--TEST--
+Stats - reset
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("Stats", "testStatsReset");
+--EXPECT--
+OK
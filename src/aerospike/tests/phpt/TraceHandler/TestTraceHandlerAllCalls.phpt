@@ -0,0 +1,9 @@
+--TEST--
+TraceHandler - all calls
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("TraceHandler", "testTraceHandlerAllCalls");
+--EXPECT--
+OK
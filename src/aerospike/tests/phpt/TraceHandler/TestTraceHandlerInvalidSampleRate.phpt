@@ -0,0 +1,9 @@
+--TEST--
+TraceHandler - invalid sample rate
+
+--FILE--
+<?php
+include dirname(__FILE__)."/../../astestframework/astest-phpt-loader.inc";
+aerospike_phpt_runtest("TraceHandler", "testTraceHandlerInvalidSampleRate");
+--EXPECT--
+ERR_PARAM